@@ -70,6 +70,7 @@
 #define EBUSY          -15  /* Resource is busy */
 #define EOVERFLOW      -16  /* The result does not fit its size. */
 #define EINTR          -17  /* Operation was interrupted. */
+#define EAGAIN         -18  /* Condition changed, try again. */
 
 #endif
 
@@ -62,6 +62,26 @@
 #define SYNCH_OK(rc) \
 	((rc) & (ESYNCH_OK_ATOMIC | ESYNCH_OK_BLOCKED))
 
+/** Operations of futex wake-op on the second futex word. */
+#define FUTEX_OP_SET   0  /**< word = arg */
+#define FUTEX_OP_ADD   1  /**< word += arg */
+#define FUTEX_OP_OR    2  /**< word |= arg */
+#define FUTEX_OP_ANDN  3  /**< word &= ~arg */
+#define FUTEX_OP_XOR   4  /**< word ^= arg */
+
+/** Comparisons of the former value of the second futex word. */
+#define FUTEX_OP_CMP_EQ  0
+#define FUTEX_OP_CMP_NE  1
+#define FUTEX_OP_CMP_LT  2
+#define FUTEX_OP_CMP_LE  3
+#define FUTEX_OP_CMP_GT  4
+#define FUTEX_OP_CMP_GE  5
+
+/** Encode a futex wake-op operation. */
+#define FUTEX_OP(op, oparg, cmp, cmparg) \
+	((((op) & 0xf) << 28) | (((cmp) & 0xf) << 24) | \
+	    (((oparg) & 0xfff) << 12) | ((cmparg) & 0xfff))
+
 #endif
 
 /** @}
@@ -45,6 +45,10 @@
 /** Maximum name sizes */
 #define TASK_NAME_BUFLEN  20
 #define EXC_NAME_BUFLEN   20
+#define LOCK_NAME_BUFLEN  32
+
+/** Number of top callers kept for each lock class */
+#define LOCKSTAT_CALLERS  4
 
 /** Item value type
  *
@@ -131,6 +135,52 @@ typedef struct {
 	uint64_t count;              /**< Number of handled exceptions */
 } stats_exc_t;
 
+/** Scheduler trace event types
+ *
+ */
+typedef enum {
+	SCHED_TRACE_SWITCH = 0,   /**< Thread switched in (arg: previous thread ID) */
+	SCHED_TRACE_WAKEUP = 1,   /**< Thread made ready (arg: waker thread ID) */
+	SCHED_TRACE_PREEMPT = 2,  /**< Running thread put back to ready */
+	SCHED_TRACE_MIGRATE = 3   /**< Thread stolen (arg: victim CPU ID) */
+} sched_trace_type_t;
+
+/** Single scheduler trace event
+ *
+ */
+typedef struct {
+	uint64_t timestamp;  /**< Cycle counter when the event was recorded */
+	uint64_t tid;        /**< Thread ID the event is about */
+	uint64_t arg;        /**< Type specific argument */
+	uint16_t type;       /**< Event type (sched_trace_type_t) */
+	uint16_t cpu;        /**< CPU which recorded the event */
+	uint16_t target;     /**< CPU whose run queue the thread lands in */
+	uint16_t nrdy;       /**< Number of ready threads on the target CPU */
+} sched_trace_event_t;
+
+/** Lock class kinds
+ *
+ */
+typedef enum {
+	LOCKSTAT_SPINLOCK = 1,  /**< Spinlocks sharing a name */
+	LOCKSTAT_MUTEX = 2,     /**< Mutexes sharing an initialization site */
+	LOCKSTAT_SEMAPHORE = 3  /**< Semaphores sharing an initialization site */
+} lockstat_kind_t;
+
+/** Contention statistics of a single lock class
+ *
+ */
+typedef struct {
+	char name[LOCK_NAME_BUFLEN];              /**< Lock or initialization site name */
+	uint16_t kind;                            /**< Lock class kind (lockstat_kind_t) */
+	uint64_t acquisitions;                    /**< Number of acquisitions */
+	uint64_t contended;                       /**< Number of acquisitions which had to wait */
+	uint64_t wait_cycles;                     /**< Total number of CPU cycles spent waiting */
+	uint64_t max_wait;                        /**< Longest wait in CPU cycles */
+	uint64_t caller[LOCKSTAT_CALLERS];        /**< Most frequent contending callers */
+	uint64_t caller_count[LOCKSTAT_CALLERS];  /**< Contended acquisitions of the callers */
+} stats_lock_t;
+
 /** Load fixed-point value */
 typedef uint32_t load_t;
 
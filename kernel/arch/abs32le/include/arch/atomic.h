@@ -109,6 +109,57 @@ NO_TRACE ATOMIC static inline atomic_count_t test_and_set(atomic_t *val)
 	return prev;
 }
 
+NO_TRACE ATOMIC static inline bool cas(atomic_t *val, atomic_count_t ov,
+    atomic_count_t nv)
+    WRITES(&val->count)
+    REQUIRES_EXTENT_MUTABLE(val)
+{
+	/* On real hardware the comparison and the storing
+	   of the new value have to be done as a single
+	   atomic action. */
+	
+	if (val->count != ov)
+		return false;
+	
+	val->count = nv;
+	return true;
+}
+
+#define atomic_cas_arch(val, ov, nv)  cas((val), (ov), (nv))
+
+NO_TRACE ATOMIC static inline atomic_count_t fetch_add(atomic_t *val,
+    atomic_count_t i)
+    WRITES(&val->count)
+    REQUIRES_EXTENT_MUTABLE(val)
+{
+	/* On real hardware both the storing of the previous
+	   value and the addition have to be done as a single
+	   atomic action. */
+	
+	atomic_count_t prev = val->count;
+	
+	val->count += i;
+	return prev;
+}
+
+NO_TRACE ATOMIC static inline atomic_count_t exchange(atomic_t *val,
+    atomic_count_t nv)
+    WRITES(&val->count)
+    REQUIRES_EXTENT_MUTABLE(val)
+{
+	/* On real hardware the retrieving of the original
+	   value and storing the new one have to be done as
+	   a single atomic action. */
+	
+	atomic_count_t prev = val->count;
+	
+	val->count = nv;
+	return prev;
+}
+
+#define atomic_fetch_add_arch(val, i)  fetch_add((val), (i))
+#define atomic_exchange_arch(val, nv)  exchange((val), (nv))
+
 NO_TRACE static inline void atomic_lock_arch(atomic_t *val)
     WRITES(&val->count)
     REQUIRES_EXTENT_MUTABLE(val)
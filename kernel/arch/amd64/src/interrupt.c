@@ -42,6 +42,7 @@
 #include <cpu.h>
 #include <arch/asm.h>
 #include <mm/tlb.h>
+#include <smp/ipi.h>
 #include <mm/as.h>
 #include <arch.h>
 #include <arch/asm.h>
@@ -151,6 +152,12 @@ static void tlb_shootdown_ipi(unsigned int n, istate_t *istate)
 	trap_virtual_eoi();
 	tlb_shootdown_ipi_recv();
 }
+
+static void wakeup_ipi(unsigned int n, istate_t *istate)
+{
+	trap_virtual_eoi();
+	ipi_wakeup_recv();
+}
 #endif
 
 /** Handler of IRQ exceptions.
@@ -213,6 +220,8 @@ void interrupt_init(void)
 #ifdef CONFIG_SMP
 	exc_register(VECTOR_TLB_SHOOTDOWN_IPI, "tlb_shootdown", true,
 	    (iroutine_t) tlb_shootdown_ipi);
+	exc_register(VECTOR_WAKEUP_IPI, "wakeup", true,
+	    (iroutine_t) wakeup_ipi);
 #endif
 }
 
@@ -353,6 +353,7 @@ extern void apic_init(void);
 extern void l_apic_init(void);
 extern void l_apic_eoi(void);
 extern int l_apic_broadcast_custom_ipi(uint8_t);
+extern int l_apic_send_custom_ipi(unsigned int, uint8_t);
 extern int l_apic_send_init_ipi(uint8_t);
 extern void l_apic_debug(void);
 
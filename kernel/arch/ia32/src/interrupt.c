@@ -41,6 +41,7 @@
 #include <cpu.h>
 #include <arch/asm.h>
 #include <mm/tlb.h>
+#include <smp/ipi.h>
 #include <mm/as.h>
 #include <arch.h>
 #include <proc/thread.h>
@@ -157,6 +158,13 @@ static void tlb_shootdown_ipi(unsigned int n __attribute__((unused)),
 	trap_virtual_eoi();
 	tlb_shootdown_ipi_recv();
 }
+
+static void wakeup_ipi(unsigned int n __attribute__((unused)),
+    istate_t *istate __attribute__((unused)))
+{
+	trap_virtual_eoi();
+	ipi_wakeup_recv();
+}
 #endif
 
 /** Handler of IRQ exceptions */
@@ -217,6 +225,8 @@ void interrupt_init(void)
 #ifdef CONFIG_SMP
 	exc_register(VECTOR_TLB_SHOOTDOWN_IPI, "tlb_shootdown", true,
 	    (iroutine_t) tlb_shootdown_ipi);
+	exc_register(VECTOR_WAKEUP_IPI, "wakeup", true,
+	    (iroutine_t) wakeup_ipi);
 #endif
 }
 
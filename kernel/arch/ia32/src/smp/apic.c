@@ -309,6 +309,42 @@ int l_apic_broadcast_custom_ipi(uint8_t vector)
 	return apic_poll_errors();
 }
 
+/** Send IPI vector to a single CPU.
+ *
+ * The CPU is addressed by its bit in the Logical Destination
+ * Register, which l_apic_init() programs as 1 << CPU->id.
+ *
+ * @param cpuid  Kernel ID of the target CPU.
+ * @param vector Interrupt vector to be sent.
+ *
+ * @return 0 on failure, 1 on success.
+ *
+ */
+int l_apic_send_custom_ipi(unsigned int cpuid, uint8_t vector)
+{
+	ASSERT(cpuid < 8);
+	
+	icr_t icr;
+	
+	icr.lo = l_apic[ICRlo];
+	icr.hi = l_apic[ICRhi];
+	
+	icr.delmod = DELMOD_FIXED;
+	icr.destmod = DESTMOD_LOGIC;
+	icr.level = LEVEL_ASSERT;
+	icr.shorthand = SHORTHAND_NONE;
+	icr.trigger_mode = TRIGMOD_LEVEL;
+	icr.vector = vector;
+	icr.dest = (uint8_t) (1 << cpuid);
+	
+	l_apic[ICRhi] = icr.hi;
+	l_apic[ICRlo] = icr.lo;
+	
+	l_apic_wait_for_delivery();
+	
+	return apic_poll_errors();
+}
+
 /** Universal Start-up Algorithm for bringing up the AP processors.
  *
  * @param apicid APIC ID of the processor to be brought up.
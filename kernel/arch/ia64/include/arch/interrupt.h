@@ -52,6 +52,7 @@
 /** External Interrupt vectors. */
 
 #define VECTOR_TLB_SHOOTDOWN_IPI  0xf0
+#define VECTOR_WAKEUP_IPI         0xf1
 
 #define INTERRUPT_SPURIOUS  15
 #define INTERRUPT_TIMER     255
@@ -52,6 +52,7 @@
 #include <ipc/ipc.h>
 #include <synch/spinlock.h>
 #include <mm/tlb.h>
+#include <smp/ipi.h>
 #include <symtab.h>
 #include <putchar.h>
 
@@ -231,6 +232,10 @@ void external_interrupt(uint64_t vector, istate_t *istate)
 		tlb_shootdown_ipi_recv();
 		end_of_local_irq();
 		break;
+	case VECTOR_WAKEUP_IPI:
+		ipi_wakeup_recv();
+		end_of_local_irq();
+		break;
 #endif
 	
 	case INTERRUPT_TIMER:
@@ -34,6 +34,7 @@
 
 #include <smp/smp.h>
 #include <smp/ipi.h>
+#include <cpu.h>
 
 #ifdef CONFIG_SMP
 
@@ -41,6 +42,10 @@ void ipi_broadcast_arch(int ipi)
 {
 }
 
+void ipi_unicast_arch(cpu_t *cpu, int ipi)
+{
+}
+
 void smp_init(void)
 {
 }
@@ -42,6 +42,7 @@
 #define IVT_FIRST  0
 
 #define VECTOR_TLB_SHOOTDOWN_IPI  EXC_Int
+#define VECTOR_WAKEUP_IPI         EXC_Int
 
 extern function virtual_timer_fnc;
 extern uint32_t count_hi;
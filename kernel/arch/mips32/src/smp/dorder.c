@@ -34,6 +34,7 @@
 
 #include <typedefs.h>
 #include <smp/ipi.h>
+#include <cpu.h>
 #include <arch/smp/dorder.h>
 
 #define MSIM_DORDER_ADDRESS  0xB0000100
@@ -45,6 +46,11 @@ void ipi_broadcast_arch(int ipi)
 	*((volatile uint32_t *) MSIM_DORDER_ADDRESS) = 0x7fffffff;
 }
 
+void ipi_unicast_arch(cpu_t *cpu, int ipi)
+{
+	*((volatile uint32_t *) MSIM_DORDER_ADDRESS) = 1 << cpu->id;
+}
+
 #endif
 
 uint32_t dorder_cpuid(void)
@@ -98,6 +98,26 @@ NO_TRACE static inline uint32_t sdr1_get(void)
 	return sdr1;
 }
 
+/** Count leading zero bits.
+ *
+ * @return Number of leading zero bits in arg (32 if arg is zero).
+ *
+ */
+NO_TRACE static inline uint32_t cntlzw(uint32_t arg)
+{
+	uint32_t n;
+	
+	asm volatile (
+		"cntlzw %[n], %[arg]\n"
+		: [n] "=r" (n)
+		: [arg] "r" (arg)
+	);
+	
+	return n;
+}
+
+#define fnzb32_arch(arg)  (((arg) != 0) ? (31 - cntlzw(arg)) : 0)
+
 /** Enable interrupts.
  *
  * Enable interrupts and return previous
@@ -182,8 +202,21 @@ NO_TRACE static inline uintptr_t get_stack_base(void)
 	return base;
 }
 
+/** Doze until the next interrupt.
+ *
+ * Interrupts are enabled together with the doze mode. The exception
+ * entry clears MSR[POW] in the saved SRR1, so the CPU does not doze
+ * again on the return from the interrupt.
+ *
+ */
 NO_TRACE static inline void cpu_sleep(void)
 {
+	asm volatile (
+		"sync\n"
+		"mtmsr %[msr]\n"
+		"isync\n"
+		:: [msr] "r" (msr_read() | MSR_EE | MSR_POW)
+	);
 }
 
 NO_TRACE static inline void pio_write_8(ioport8_t *port, uint8_t v)
@@ -35,66 +35,149 @@
 #ifndef KERN_ppc32_ATOMIC_H_
 #define KERN_ppc32_ATOMIC_H_
 
+#include <typedefs.h>
 #include <trace.h>
 
-NO_TRACE static inline void atomic_inc(atomic_t *val)
+/*
+ * The read-modify-write operations are lwarx/stwcx. loops which do not
+ * order any other memory accesses. For the acquire and release variants
+ * lwsync orders all accesses but stores followed by loads. Processors
+ * which do not implement lwsync execute it as sync. An isync after the
+ * conditional branch closing a loop keeps the following accesses from
+ * being performed before the loop is done, which is a cheaper acquire
+ * barrier for the read-modify-write operations.
+ */
+#define atomic_acquire_barrier_arch()      asm volatile ("lwsync\n" ::: "memory")
+#define atomic_release_barrier_arch()      asm volatile ("lwsync\n" ::: "memory")
+#define atomic_rmw_acquire_barrier_arch()  asm volatile ("isync\n" ::: "memory")
+
+/** Atomic addition
+ *
+ * @param val Atomic variable.
+ * @param i   Value to be added.
+ *
+ * @return Value of val before the addition.
+ *
+ */
+NO_TRACE static inline atomic_count_t fetch_add(atomic_t *val,
+    atomic_count_t i)
 {
+	atomic_count_t old;
 	atomic_count_t tmp;
 	
 	asm volatile (
 		"1:\n"
-		"	lwarx %[tmp], 0, %[count_ptr]\n"
-		"	addic %[tmp], %[tmp], 1\n"
+		"	lwarx %[old], 0, %[count_ptr]\n"
+		"	add %[tmp], %[old], %[i]\n"
 		"	stwcx. %[tmp], 0, %[count_ptr]\n"
 		"	bne- 1b"
-		: [tmp] "=&r" (tmp),
+		: [old] "=&r" (old),
+		  [tmp] "=&r" (tmp),
 		  "=m" (val->count)
 		: [count_ptr] "r" (&val->count),
+		  [i] "r" (i),
 		  "m" (val->count)
 		: "cc"
 	);
+	
+	return old;
 }
 
-NO_TRACE static inline void atomic_dec(atomic_t *val)
+/** Atomic exchange
+ *
+ * @param val Atomic variable.
+ * @param nv  New value.
+ *
+ * @return Value of val before the exchange.
+ *
+ */
+NO_TRACE static inline atomic_count_t exchange(atomic_t *val,
+    atomic_count_t nv)
+{
+	atomic_count_t old;
+	
+	asm volatile (
+		"1:\n"
+		"	lwarx %[old], 0, %[count_ptr]\n"
+		"	stwcx. %[nv], 0, %[count_ptr]\n"
+		"	bne- 1b"
+		: [old] "=&r" (old),
+		  "=m" (val->count)
+		: [count_ptr] "r" (&val->count),
+		  [nv] "r" (nv),
+		  "m" (val->count)
+		: "cc"
+	);
+	
+	return old;
+}
+
+/** Compare and swap
+ *
+ * @param val Atomic variable.
+ * @param ov  Expected value.
+ * @param nv  New value stored if val contains ov.
+ *
+ * @return True if nv has been stored.
+ *
+ */
+NO_TRACE static inline bool cas(atomic_t *val, atomic_count_t ov,
+    atomic_count_t nv)
 {
 	atomic_count_t tmp;
 	
 	asm volatile (
 		"1:\n"
 		"	lwarx %[tmp], 0, %[count_ptr]\n"
-		"	addic %[tmp], %[tmp], -1\n"
-		"	stwcx. %[tmp], 0, %[count_ptr]\n"
-		"	bne- 1b"
+		"	cmpw %[tmp], %[ov]\n"
+		"	bne- 2f\n"
+		"	stwcx. %[nv], 0, %[count_ptr]\n"
+		"	bne- 1b\n"
+		"2:\n"
 		: [tmp] "=&r" (tmp),
 		  "=m" (val->count)
 		: [count_ptr] "r" (&val->count),
+		  [ov] "r" (ov),
+		  [nv] "r" (nv),
 		  "m" (val->count)
-		: "cc"
+		: "cc", "memory"
 	);
+	
+	return (tmp == ov);
+}
+
+#define atomic_fetch_add_arch(val, i)  fetch_add((val), (i))
+#define atomic_exchange_arch(val, nv)  exchange((val), (nv))
+#define atomic_cas_arch(val, ov, nv)   cas((val), (ov), (nv))
+
+NO_TRACE static inline void atomic_inc(atomic_t *val)
+{
+	(void) fetch_add(val, 1);
+}
+
+NO_TRACE static inline void atomic_dec(atomic_t *val)
+{
+	(void) fetch_add(val, (atomic_count_t) -1);
 }
 
 NO_TRACE static inline atomic_count_t atomic_postinc(atomic_t *val)
 {
-	atomic_inc(val);
-	return val->count - 1;
+	return fetch_add(val, 1);
 }
 
 NO_TRACE static inline atomic_count_t atomic_postdec(atomic_t *val)
 {
-	atomic_dec(val);
-	return val->count + 1;
+	return fetch_add(val, (atomic_count_t) -1);
 }
 
 NO_TRACE static inline atomic_count_t atomic_preinc(atomic_t *val)
 {
-	atomic_inc(val);
-	return val->count;
+	return fetch_add(val, 1) + 1;
 }
 
 NO_TRACE static inline atomic_count_t atomic_predec(atomic_t *val)
 {
-	atomic_dec(val);
-	return val->count;
+	return fetch_add(val, (atomic_count_t) -1) - 1;
 }
 
 #endif
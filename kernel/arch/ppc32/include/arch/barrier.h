@@ -92,6 +92,41 @@ NO_TRACE static inline void smc_coherence_block(void *addr, unsigned int len)
 	instruction_barrier();
 }
 
+/** Size of the data cache block (in bytes). */
+#define DCACHE_BLOCK_SIZE  32
+
+/** Hint that the data cache block will be read soon.
+ *
+ * The hint never causes an exception, not even for
+ * an unmapped address.
+ *
+ */
+NO_TRACE static inline void dcache_block_prefetch(const void *addr)
+{
+	asm volatile (
+		"dcbt 0, %[addr]\n"
+		:: [addr] "r" (addr)
+	);
+}
+
+/** Zero the data cache block without fetching it from memory.
+ *
+ * The memory must be cacheable and the whole block is going
+ * to be overwritten.
+ *
+ */
+NO_TRACE static inline void dcache_block_zero(void *addr)
+{
+	asm volatile (
+		"dcbz 0, %[addr]\n"
+		:: [addr] "r" (addr)
+		: "memory"
+	);
+}
+
+#define dcache_block_prefetch  dcache_block_prefetch
+#define dcache_block_zero      dcache_block_zero
+
 #endif
 
 /** @}
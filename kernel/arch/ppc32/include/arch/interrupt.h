@@ -49,8 +49,10 @@
 #define VECTOR_DTLB_MISS_LOAD       14
 #define VECTOR_DTLB_MISS_STORE      15
 
+#define clock_program_arch(ticks)  decrementer_program(ticks)
+
 extern void decrementer_start(uint32_t);
-extern void decrementer_restart(void);
+extern void decrementer_program(uint64_t);
 extern void interrupt_init(void);
 extern void extint_handler(unsigned int, istate_t *);
 
@@ -43,9 +43,11 @@
 #define MSR_FP  (1 << 13)
 #define MSR_PR  (1 << 14)
 #define MSR_EE  (1 << 15)
+#define MSR_POW (1 << 18)
 
 /* HID0 bits */
 #define HID0_STEN  (1 << 24)
+#define HID0_DOZE  (1 << 23)
 #define HID0_ICE   (1 << 15)
 #define HID0_DCE   (1 << 14)
 #define HID0_ICFI  (1 << 11)
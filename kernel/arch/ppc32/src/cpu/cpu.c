@@ -33,6 +33,7 @@
  */
 
 #include <arch/cpu.h>
+#include <arch/msr.h>
 #include <cpu.h>
 #include <arch.h>
 #include <print.h>
@@ -43,6 +44,19 @@ void cpu_arch_init(void)
 #ifdef CONFIG_FPU
 	fpu_enable();
 #endif
+	
+	/* Make MSR[POW] in cpu_sleep() enter the doze mode. */
+	uint32_t hid0;
+	asm volatile (
+		"mfspr %[hid0], 1008\n"
+		: [hid0] "=r" (hid0)
+	);
+	
+	asm volatile (
+		"mtspr 1008, %[hid0]\n"
+		"isync\n"
+		:: [hid0] "r" (hid0 | HID0_DOZE)
+	);
 }
 
 void cpu_identify(void)
@@ -41,23 +41,52 @@
 #include <arch/drivers/pic.h>
 #include <arch/mm/tlb.h>
 #include <arch/mm/pht.h>
+#include <arch/cycle.h>
+#include <time/clock.h>
+#include <macros.h>
 #include <print.h>
 #include <log.h>
 
+/** Number of timebase ticks per clock tick. */
 static uint32_t decrementer_value;
 
+/** Timebase value of the last clock tick. */
+static uint64_t decrementer_tick;
+
+NO_TRACE static inline void decrementer_write(uint32_t val)
+{
+	asm volatile (
+		"mtdec %[dec]\n"
+		:: [dec] "r" (val)
+	);
+}
+
 void decrementer_start(uint32_t val)
 {
 	decrementer_value = val;
-	decrementer_restart();
+	decrementer_tick = get_cycle();
+	decrementer_write(val);
 }
 
-void decrementer_restart(void)
+/** Program the decrementer
+ *
+ * The decrementer interrupt is signalled when the decrementer
+ * passes zero. The timebase and the decrementer are updated at
+ * the same rate.
+ *
+ * @param ticks Number of clock ticks after the last one
+ *              the decrementer interrupt should come.
+ *
+ */
+void decrementer_program(uint64_t ticks)
 {
-	asm volatile (
-		"mtdec %[dec]\n"
-		:: [dec] "r" (decrementer_value)
-	);
+	uint64_t target = decrementer_tick + ticks * decrementer_value;
+	uint64_t now = get_cycle();
+	
+	if (target <= now)
+		decrementer_write(0);
+	else
+		decrementer_write(min(target - now, INT32_MAX));
 }
 
 void istate_decode(istate_t *istate)
@@ -160,7 +189,27 @@ static void exception_fp_unavailable(unsigned int n, istate_t *istate)
 
 static void exception_decrementer(unsigned int n, istate_t *istate)
 {
-	decrementer_restart();
+	uint64_t now = get_cycle();
+	
+	/*
+	 * The decrementer interrupt does not come every clock tick,
+	 * account the ticks which have passed since the last one.
+	 */
+	if (now - decrementer_tick < decrementer_value) {
+		/*
+		 * The decrementer has been reprogrammed after it had
+		 * passed zero, but before the interrupt was taken.
+		 */
+		clock_program();
+		return;
+	}
+	
+	decrementer_tick += decrementer_value;
+	while (now - decrementer_tick >= decrementer_value) {
+		decrementer_tick += decrementer_value;
+		CPU->missed_clock_ticks++;
+	}
+	
 	clock();
 }
 
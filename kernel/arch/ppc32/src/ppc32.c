@@ -60,6 +60,9 @@
 
 bootinfo_t bootinfo;
 
+/** Frequency of the timebase (Hz). */
+static uint32_t timebase_freq;
+
 static cir_t pic_cir;
 static void *pic_cir_arg;
 
@@ -113,11 +116,10 @@ void arch_pre_mm_init(void)
 	if (!freq_prop)
 		panic("Could not get frequency property.");
 
-	uint32_t freq;
-	freq = *((uint32_t *) freq_prop->value);
+	timebase_freq = *((uint32_t *) freq_prop->value);
 
 	/* Start decrementer */
-	decrementer_start(freq / HZ);
+	decrementer_start(timebase_freq / HZ);
 }
 
 #ifdef CONFIG_FB
@@ -281,8 +283,15 @@ void arch_post_smp_init(void)
 	ofw_tree_walk_by_device_type("mac-io", macio_register, NULL);
 }
 
+/** Calibrate the monotonic clock
+ *
+ * The frequency of the timebase, which is read by get_cycle(),
+ * is constant and reported by the firmware.
+ *
+ */
 void calibrate_delay_loop(void)
 {
+	clock_source_init(timebase_freq);
 }
 
 /** Construct function pointer
@@ -42,6 +42,7 @@
 #define IVT_FIRST  0
 
 #define VECTOR_TLB_SHOOTDOWN_IPI  0
+#define VECTOR_WAKEUP_IPI         1
 
 #endif
 
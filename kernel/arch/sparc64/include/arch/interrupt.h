@@ -44,9 +44,11 @@
 
 /* This needs to be defined for inter-architecture API portability. */
 #define VECTOR_TLB_SHOOTDOWN_IPI  0
+#define VECTOR_WAKEUP_IPI         1
 
 enum {
-	IPI_TLB_SHOOTDOWN = VECTOR_TLB_SHOOTDOWN_IPI
+	IPI_TLB_SHOOTDOWN = VECTOR_TLB_SHOOTDOWN_IPI,
+	IPI_WAKEUP = VECTOR_WAKEUP_IPI
 };
 
 #endif
@@ -128,6 +128,31 @@ static void cross_call(int mid, void (* func)(void))
 	preemption_enable();
 }
 
+/** Translate IPI number to the function invoked on the recipient.
+ *
+ * @param ipi IPI number.
+ *
+ * @return Function to be cross-called.
+ */
+static void (*ipi_func(int ipi))(void)
+{
+	void (* func)(void) = NULL;
+	
+	switch (ipi) {
+	case IPI_TLB_SHOOTDOWN:
+		func = tlb_shootdown_ipi_recv;
+		break;
+	case IPI_WAKEUP:
+		func = ipi_wakeup_recv;
+		break;
+	default:
+		panic("Unknown IPI (%d).\n", ipi);
+		break;
+	}
+	
+	return func;
+}
+
 /*
  * Deliver IPI to all processors except the current one.
  *
@@ -144,16 +169,7 @@ void ipi_broadcast_arch(int ipi)
 {
 	unsigned int i;
 	
-	void (* func)(void);
-	
-	switch (ipi) {
-	case IPI_TLB_SHOOTDOWN:
-		func = tlb_shootdown_ipi_recv;
-		break;
-	default:
-		panic("Unknown IPI (%d).\n", ipi);
-		break;
-	}
+	void (* func)(void) = ipi_func(ipi);
 	
 	/*
 	 * As long as we don't support hot-plugging
@@ -170,5 +186,20 @@ void ipi_broadcast_arch(int ipi)
 	}
 }
 
+/*
+ * Deliver IPI to a single processor.
+ *
+ * We assume that interrupts are disabled.
+ *
+ * @param cpu Target processor.
+ * @param ipi IPI number.
+ */
+void ipi_unicast_arch(cpu_t *cpu, int ipi)
+{
+	ASSERT(cpu != CPU);
+	
+	cross_call(cpu->arch.mid, ipi_func(ipi));
+}
+
 /** @}
  */
@@ -85,25 +85,41 @@ uint64_t ipi_unicast_to(void (*func)(void), uint16_t cpu_id) {
 	return ipi_brodcast_to(func, ipi_cpu_list[CPU->arch.id], 1);
 }
 
-/*
- * Deliver IPI to all processors except the current one.
- *
- * We assume that interrupts are disabled.
+/** Translate IPI number to the function invoked on the recipient.
  *
  * @param ipi IPI number.
+ *
+ * @return Function to be cross-called.
  */
-void ipi_broadcast_arch(int ipi)
+static void (*ipi_func(int ipi))(void)
 {
-	void (* func)(void);
+	void (* func)(void) = NULL;
 	
 	switch (ipi) {
 	case IPI_TLB_SHOOTDOWN:
 		func = tlb_shootdown_ipi_recv;
 		break;
+	case IPI_WAKEUP:
+		func = ipi_wakeup_recv;
+		break;
 	default:
 		panic("Unknown IPI (%d).\n", ipi);
 		break;
 	}
+	
+	return func;
+}
+
+/*
+ * Deliver IPI to all processors except the current one.
+ *
+ * We assume that interrupts are disabled.
+ *
+ * @param ipi IPI number.
+ */
+void ipi_broadcast_arch(int ipi)
+{
+	void (* func)(void) = ipi_func(ipi);
 
 	unsigned int i;
 	unsigned idx = 0;
@@ -119,5 +135,18 @@ void ipi_broadcast_arch(int ipi)
 	ipi_brodcast_to(func, ipi_cpu_list[CPU->arch.id], idx);
 }
 
+/*
+ * Deliver IPI to a single processor.
+ *
+ * We assume that interrupts are disabled.
+ *
+ * @param cpu Target processor.
+ * @param ipi IPI number.
+ */
+void ipi_unicast_arch(cpu_t *cpu, int ipi)
+{
+	(void) ipi_unicast_to(ipi_func(ipi), (uint16_t) cpu->id);
+}
+
 /** @}
  */
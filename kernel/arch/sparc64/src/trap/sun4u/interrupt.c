@@ -44,6 +44,7 @@
 #include <log.h>
 #include <arch.h>
 #include <mm/tlb.h>
+#include <smp/ipi.h>
 #include <config.h>
 #include <synch/spinlock.h>
 
@@ -89,6 +90,8 @@ void interrupt(int n, istate_t *istate)
 #ifdef CONFIG_SMP
 		if (data0 == (uintptr_t) tlb_shootdown_ipi_recv)
 			tlb_shootdown_ipi_recv();
+		else if (data0 == (uintptr_t) ipi_wakeup_recv)
+			ipi_wakeup_recv();
 #endif
 	} else {
 		/*
@@ -44,6 +44,7 @@
 #include <log.h>
 #include <arch.h>
 #include <mm/tlb.h>
+#include <smp/ipi.h>
 #include <config.h>
 #include <synch/spinlock.h>
 #include <arch/sun4v/hypercall.h>
@@ -107,7 +108,8 @@ void cpu_mondo(void)
 		    (CPU_MONDO_QUEUE_SIZE * sizeof(uint64_t));
 		asi_u64_write(ASI_QUEUE, VA_CPU_MONDO_QUEUE_HEAD, head);
 
-		if (data1 == (uintptr_t) tlb_shootdown_ipi_recv) {
+		if ((data1 == (uintptr_t) tlb_shootdown_ipi_recv) ||
+		    (data1 == (uintptr_t) ipi_wakeup_recv)) {
 			((void (*)(void)) data1)();
 		} else {
 			log(LF_ARCH, LVL_DEBUG, "Spurious interrupt on %" PRIu64
@@ -39,6 +39,7 @@
 #include <typedefs.h>
 #include <console/chardev.h>
 #include <synch/spinlock.h>
+#include <ddi/work.h>
 
 typedef struct {
 	uint8_t b;
@@ -91,7 +92,8 @@ typedef struct {
 } cuda_t;
 
 enum {
-	CUDA_RCV_BUF_SIZE = 5
+	CUDA_RCV_BUF_SIZE = 5,
+	CUDA_SCAN_BUF_SIZE = 16
 };
 
 enum cuda_xfer_state {
@@ -112,6 +114,12 @@ typedef struct {
 	size_t snd_bytes;
 	enum cuda_xfer_state xstate;
 	SPINLOCK_DECLARE(dev_lock);
+
+	/** Scancodes received, not yet passed to kbrdin. */
+	uint8_t scan_buf[CUDA_SCAN_BUF_SIZE];
+	size_t scan_count;
+	/** Passes the received scancodes to kbrdin. */
+	work_t scan_work;
 } cuda_instance_t;
 
 extern cuda_instance_t *cuda_init(cuda_t *, inr_t, cir_t, void *);
@@ -42,6 +42,9 @@
 typedef struct {
 } as_genarch_t;
 
+typedef struct {
+} cpu_genarch_t;
+
 struct as;
 
 typedef struct pte {
@@ -36,14 +36,40 @@
 #define KERN_AS_PT_H_
 
 #include <arch/mm/page.h>
+#include <typedefs.h>
 
 #define AS_PAGE_TABLE
 
+/** Number of entries in the per-CPU page table walk cache. */
+#define PT_WALK_CACHE_SIZE  4
+
 typedef struct {
 	/** Page table pointer. */
 	pte_t *page_table;
 } as_genarch_t;
 
+/** Page table walk cache entry.
+ *
+ * Remembers the PTL3 mapping the virtual address range starting
+ * at base in the page table ptl0.
+ *
+ */
+typedef struct {
+	/** PTL0 the walk started from, NULL if the entry is unused. */
+	pte_t *ptl0;
+	/** First virtual address mapped by the PTL3. */
+	uintptr_t base;
+	/** PTL3 found by the walk. */
+	pte_t *ptl3;
+	/** Page table generation the entry is valid for. */
+	atomic_count_t generation;
+} pt_walk_t;
+
+typedef struct {
+	/** Page table walk cache. */
+	pt_walk_t pt_walk[PT_WALK_CACHE_SIZE];
+} cpu_genarch_t;
+
 #endif
 
 /** @}
@@ -144,6 +144,7 @@ extern page_mapping_operations_t pt_mapping_operations;
 
 extern void page_mapping_insert_pt(as_t *, uintptr_t, uintptr_t, unsigned int);
 extern pte_t *page_mapping_find_pt(as_t *, uintptr_t, bool);
+extern void pt_walk_invalidate(void);
 
 #endif
 
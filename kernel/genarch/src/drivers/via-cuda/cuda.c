@@ -52,6 +52,7 @@ static void cuda_irq_send_start(irq_t *irq);
 static void cuda_irq_send(irq_t *irq);
 
 static void cuda_packet_handle(cuda_instance_t *instance, uint8_t *buf, size_t len);
+static void cuda_scan_work(void *arg);
 static void cuda_send_start(cuda_instance_t *instance);
 static void cuda_autopoll_set(cuda_instance_t *instance, bool enable);
 
@@ -97,8 +98,10 @@ cuda_instance_t *cuda_init(cuda_t *dev, inr_t inr, cir_t cir, void *cir_arg)
 		instance->xstate = cx_listen;
 		instance->bidx = 0;
 		instance->snd_bytes = 0;
+		instance->scan_count = 0;
 
 		spinlock_initialize(&instance->dev_lock, "cuda.instance.dev_lock");
+		work_initialize(&instance->scan_work, cuda_scan_work, instance);
 
 		/* Disable all interrupts from CUDA. */
 		pio_write_8(&dev->ier, IER_CLR | ALL_INT);
@@ -312,17 +315,54 @@ static void cuda_irq_send(irq_t *irq)
 	/* TODO: Match reply with request. */
 }
 
+/** Handle a received packet.
+ *
+ * Called from the interrupt handler. The scancodes are only stored
+ * here and passed to kbrdin later by cuda_scan_work().
+ */
 static void cuda_packet_handle(cuda_instance_t *instance, uint8_t *data, size_t len)
 {
 	if (data[0] != 0x00 || data[1] != 0x40 || (data[2] != 0x2c
 		&& data[2] != 0x8c))
 		return;
 
+	spinlock_lock(&instance->dev_lock);
+
 	/* The packet contains one or two scancodes. */
-	if (data[3] != 0xff)
-		indev_push_character(instance->kbrdin, data[3]);		
-	if (data[4] != 0xff)
-		indev_push_character(instance->kbrdin, data[4]);
+	for (size_t i = 3; i <= 4; i++) {
+		if ((data[i] != 0xff) &&
+		    (instance->scan_count < CUDA_SCAN_BUF_SIZE))
+			instance->scan_buf[instance->scan_count++] = data[i];
+	}
+
+	spinlock_unlock(&instance->dev_lock);
+
+	work_queue(&instance->scan_work);
+}
+
+/** Pass the received scancodes to kbrdin.
+ *
+ * Runs in the deferred work thread, so that the interrupt handler
+ * does not have to wait for the input device.
+ */
+static void cuda_scan_work(void *arg)
+{
+	cuda_instance_t *instance = (cuda_instance_t *) arg;
+	uint8_t scan_buf[CUDA_SCAN_BUF_SIZE];
+	size_t scan_count;
+
+	ipl_t ipl = interrupts_disable();
+	spinlock_lock(&instance->dev_lock);
+
+	scan_count = instance->scan_count;
+	memcpy(scan_buf, instance->scan_buf, scan_count);
+	instance->scan_count = 0;
+
+	spinlock_unlock(&instance->dev_lock);
+	interrupts_restore(ipl);
+
+	for (size_t i = 0; i < scan_count; i++)
+		indev_push_character(instance->kbrdin, scan_buf[i]);
 }
 
 static void cuda_autopoll_set(cuda_instance_t *instance, bool enable)
@@ -111,6 +111,7 @@ pte_t *ptl0_create(unsigned int flags)
  */
 void ptl0_destroy(pte_t *page_table)
 {
+	pt_walk_invalidate();
 	frame_free((uintptr_t) page_table, PTL0_FRAMES);
 }
 
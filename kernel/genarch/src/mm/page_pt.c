@@ -49,19 +49,49 @@
 #include <align.h>
 #include <macros.h>
 #include <bitops.h>
+#include <atomic.h>
+#include <cpu.h>
+#include <arch.h>
 
 static void pt_mapping_insert(as_t *, uintptr_t, uintptr_t, unsigned int);
 static void pt_mapping_remove(as_t *, uintptr_t);
+static void pt_mapping_remove_range(as_t *, uintptr_t, size_t,
+    page_mapping_release_t, void *);
 static pte_t *pt_mapping_find(as_t *, uintptr_t, bool);
 static void pt_mapping_make_global(uintptr_t, size_t);
 
 page_mapping_operations_t pt_mapping_operations = {
 	.mapping_insert = pt_mapping_insert,
 	.mapping_remove = pt_mapping_remove,
+	.mapping_remove_range = pt_mapping_remove_range,
 	.mapping_find = pt_mapping_find,
 	.mapping_make_global = pt_mapping_make_global
 };
 
+/** Page table generation.
+ *
+ * Incremented whenever a page table is freed, which invalidates
+ * the page table walk caches of all processors at once.
+ *
+ */
+static atomic_t pt_walk_generation = {0};
+
+/** Page table walk cache entry for a virtual address range. */
+#define PT_WALK_ENTRY(base) \
+	(&CPU->genarch.pt_walk[((base) / (PTL3_ENTRIES * PAGE_SIZE)) % \
+	    PT_WALK_CACHE_SIZE])
+
+/** Invalidate page table walk caches of all processors.
+ *
+ * Must be called before a page table is freed.
+ *
+ */
+void pt_walk_invalidate(void)
+{
+	atomic_inc(&pt_walk_generation);
+	write_barrier();
+}
+
 /** Map page to frame using hierarchical page tables.
  *
  * Map virtual address page to physical address frame
@@ -142,55 +172,21 @@ void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
 	SET_FRAME_PRESENT(ptl3, PTL3_INDEX(page));
 }
 
-/** Remove mapping of page from hierarchical page tables.
- *
- * Remove any mapping of page within address space as.
- * TLB shootdown should follow in order to make effects of
- * this call visible.
+/** Free empty page tables along the way from PTL3 down to PTL0.
  *
- * Empty page tables except PTL0 are freed.
+ * Tables needed for sharing the kernel non-identity mappings are never
+ * freed.
  *
- * @param as   Address space to wich page belongs.
- * @param page Virtual address of the page to be demapped.
+ * @param ptl0 PTL0 of the address space.
+ * @param ptl1 PTL1 on the path to page.
+ * @param ptl2 PTL2 on the path to page.
+ * @param ptl3 PTL3 on the path to page.
+ * @param page Virtual address mapped by the tables.
  *
  */
-void pt_mapping_remove(as_t *as, uintptr_t page)
+static void pt_release_empty(pte_t *ptl0, pte_t *ptl1, pte_t *ptl2,
+    pte_t *ptl3, uintptr_t page)
 {
-	ASSERT(page_table_locked(as));
-
-	/*
-	 * First, remove the mapping, if it exists.
-	 */
-	
-	pte_t *ptl0 = (pte_t *) PA2KA((uintptr_t) as->genarch.page_table);
-	if (GET_PTL1_FLAGS(ptl0, PTL0_INDEX(page)) & PAGE_NOT_PRESENT)
-		return;
-	
-	pte_t *ptl1 = (pte_t *) PA2KA(GET_PTL1_ADDRESS(ptl0, PTL0_INDEX(page)));
-	if (GET_PTL2_FLAGS(ptl1, PTL1_INDEX(page)) & PAGE_NOT_PRESENT)
-		return;
-	
-	pte_t *ptl2 = (pte_t *) PA2KA(GET_PTL2_ADDRESS(ptl1, PTL1_INDEX(page)));
-	if (GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT)
-		return;
-	
-	pte_t *ptl3 = (pte_t *) PA2KA(GET_PTL3_ADDRESS(ptl2, PTL2_INDEX(page)));
-	
-	/*
-	 * Destroy the mapping.
-	 * Setting to PAGE_NOT_PRESENT is not sufficient.
-	 * But we need SET_FRAME for possible PT coherence maintenance.
-	 * At least on ARM.
-	 */
-	//TODO: Fix this inconsistency
-	SET_FRAME_FLAGS(ptl3, PTL3_INDEX(page), PAGE_NOT_PRESENT);
-	memsetb(&ptl3[PTL3_INDEX(page)], sizeof(pte_t), 0);
-	
-	/*
-	 * Second, free all empty tables along the way from PTL3 down to PTL0
-	 * except those needed for sharing the kernel non-identity mappings.
-	 */
-	
 	/* Check PTL3 */
 	bool empty = true;
 	
@@ -218,6 +214,7 @@ void pt_mapping_remove(as_t *as, uintptr_t page)
 
 		memsetb(&ptl0[PTL0_INDEX(page)], sizeof(pte_t), 0);
 #endif
+		pt_walk_invalidate();
 		frame_free(KA2PA((uintptr_t) ptl3), PTL3_FRAMES);
 	} else {
 		/*
@@ -288,21 +285,135 @@ void pt_mapping_remove(as_t *as, uintptr_t page)
 #endif /* PTL1_ENTRIES != 0 */
 }
 
-/** Find mapping for virtual page in hierarchical page tables.
+/** Remove mapping of page from hierarchical page tables.
  *
- * @param as     Address space to which page belongs.
- * @param page   Virtual page.
- * @param nolock True if the page tables need not be locked.
+ * Remove any mapping of page within address space as.
+ * TLB shootdown should follow in order to make effects of
+ * this call visible.
  *
- * @return NULL if there is no such mapping; entry from PTL3 describing
- *         the mapping otherwise.
+ * Empty page tables except PTL0 are freed.
+ *
+ * @param as   Address space to wich page belongs.
+ * @param page Virtual address of the page to be demapped.
  *
  */
-pte_t *pt_mapping_find(as_t *as, uintptr_t page, bool nolock)
+void pt_mapping_remove(as_t *as, uintptr_t page)
 {
-	ASSERT(nolock || page_table_locked(as));
+	ASSERT(page_table_locked(as));
 
+	/*
+	 * First, remove the mapping, if it exists.
+	 */
+	
 	pte_t *ptl0 = (pte_t *) PA2KA((uintptr_t) as->genarch.page_table);
+	if (GET_PTL1_FLAGS(ptl0, PTL0_INDEX(page)) & PAGE_NOT_PRESENT)
+		return;
+	
+	pte_t *ptl1 = (pte_t *) PA2KA(GET_PTL1_ADDRESS(ptl0, PTL0_INDEX(page)));
+	if (GET_PTL2_FLAGS(ptl1, PTL1_INDEX(page)) & PAGE_NOT_PRESENT)
+		return;
+	
+	pte_t *ptl2 = (pte_t *) PA2KA(GET_PTL2_ADDRESS(ptl1, PTL1_INDEX(page)));
+	if (GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT)
+		return;
+	
+	pte_t *ptl3 = (pte_t *) PA2KA(GET_PTL3_ADDRESS(ptl2, PTL2_INDEX(page)));
+	
+	/*
+	 * Destroy the mapping.
+	 * Setting to PAGE_NOT_PRESENT is not sufficient.
+	 * But we need SET_FRAME for possible PT coherence maintenance.
+	 * At least on ARM.
+	 */
+	//TODO: Fix this inconsistency
+	SET_FRAME_FLAGS(ptl3, PTL3_INDEX(page), PAGE_NOT_PRESENT);
+	memsetb(&ptl3[PTL3_INDEX(page)], sizeof(pte_t), 0);
+	
+	/*
+	 * Second, free all empty tables along the way from PTL3 down to PTL0
+	 * except those needed for sharing the kernel non-identity mappings.
+	 */
+	pt_release_empty(ptl0, ptl1, ptl2, ptl3, page);
+}
+
+/** Remove mappings of a range of pages from hierarchical page tables.
+ *
+ * The page tables are walked only once for each PTL3 which maps a part
+ * of the range. All mappings within the PTL3 are destroyed at once and
+ * the empty page tables are then freed like in pt_mapping_remove().
+ * TLB shootdown should follow in order to make effects of this call
+ * visible.
+ *
+ * @param as      Address space to wich the pages belong.
+ * @param page    Virtual address of the first page to be demapped.
+ * @param count   Number of pages to be demapped.
+ * @param release If not NULL, called for each present mapping before
+ *                it is destroyed.
+ * @param arg     Argument passed to release.
+ *
+ */
+void pt_mapping_remove_range(as_t *as, uintptr_t page, size_t count,
+    page_mapping_release_t release, void *arg)
+{
+	ASSERT(page_table_locked(as));
+	
+	pte_t *ptl0 = (pte_t *) PA2KA((uintptr_t) as->genarch.page_table);
+	
+	while (count > 0) {
+		/*
+		 * Number of pages of the range mapped by the current PTL3.
+		 */
+		size_t pages = min(count,
+		    (size_t) (PTL3_ENTRIES - PTL3_INDEX(page)));
+		
+		if (GET_PTL1_FLAGS(ptl0, PTL0_INDEX(page)) & PAGE_NOT_PRESENT)
+			goto next;
+		
+		pte_t *ptl1 =
+		    (pte_t *) PA2KA(GET_PTL1_ADDRESS(ptl0, PTL0_INDEX(page)));
+		if (GET_PTL2_FLAGS(ptl1, PTL1_INDEX(page)) & PAGE_NOT_PRESENT)
+			goto next;
+		
+		pte_t *ptl2 =
+		    (pte_t *) PA2KA(GET_PTL2_ADDRESS(ptl1, PTL1_INDEX(page)));
+		if (GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT)
+			goto next;
+		
+		pte_t *ptl3 =
+		    (pte_t *) PA2KA(GET_PTL3_ADDRESS(ptl2, PTL2_INDEX(page)));
+		
+		size_t first = PTL3_INDEX(page);
+		for (size_t i = first; i < first + pages; i++) {
+			if (!PTE_VALID(&ptl3[i]))
+				continue;
+			
+			if ((release) && (PTE_PRESENT(&ptl3[i])))
+				release(arg, page + P2SZ(i - first),
+				    PTE_GET_FRAME(&ptl3[i]));
+			
+			/* See pt_mapping_remove(). */
+			SET_FRAME_FLAGS(ptl3, i, PAGE_NOT_PRESENT);
+			memsetb(&ptl3[i], sizeof(pte_t), 0);
+		}
+		
+		pt_release_empty(ptl0, ptl1, ptl2, ptl3, page);
+		
+next:
+		page += P2SZ(pages);
+		count -= pages;
+	}
+}
+
+/** Walk hierarchical page tables down to PTL3.
+ *
+ * @param ptl0 PTL0 to start the walk from.
+ * @param page Virtual page.
+ *
+ * @return NULL if there is no PTL3 mapping page; the PTL3 otherwise.
+ *
+ */
+static pte_t *pt_walk(pte_t *ptl0, uintptr_t page)
+{
 	if (GET_PTL1_FLAGS(ptl0, PTL0_INDEX(page)) & PAGE_NOT_PRESENT)
 		return NULL;
 
@@ -330,7 +441,60 @@ pte_t *pt_mapping_find(as_t *as, uintptr_t page, bool nolock)
 	read_barrier();
 #endif
 	
-	pte_t *ptl3 = (pte_t *) PA2KA(GET_PTL3_ADDRESS(ptl2, PTL2_INDEX(page)));
+	return (pte_t *) PA2KA(GET_PTL3_ADDRESS(ptl2, PTL2_INDEX(page)));
+}
+
+/** Find mapping for virtual page in hierarchical page tables.
+ *
+ * The PTL3 found by the walk is remembered in the walk cache of the
+ * current processor, so that subsequent lookups of pages mapped by the
+ * same PTL3 skip the upper levels.
+ *
+ * @param as     Address space to which page belongs.
+ * @param page   Virtual page.
+ * @param nolock True if the page tables need not be locked.
+ *
+ * @return NULL if there is no such mapping; entry from PTL3 describing
+ *         the mapping otherwise.
+ *
+ */
+pte_t *pt_mapping_find(as_t *as, uintptr_t page, bool nolock)
+{
+	ASSERT(nolock || page_table_locked(as));
+
+	pte_t *ptl0 = (pte_t *) PA2KA((uintptr_t) as->genarch.page_table);
+	uintptr_t base = page - P2SZ(PTL3_INDEX(page));
+	
+	/*
+	 * The generation must be sampled before the walk, so that a page
+	 * table freed during the walk invalidates the resulting entry.
+	 */
+	atomic_count_t generation = atomic_get(&pt_walk_generation);
+	read_barrier();
+	
+	/* The walk cache is CPU-local. */
+	ipl_t ipl = interrupts_disable();
+	
+	pt_walk_t *walk = (CPU) ? PT_WALK_ENTRY(base) : NULL;
+	pte_t *ptl3;
+	
+	if ((walk) && (walk->ptl0 == ptl0) && (walk->base == base) &&
+	    (walk->generation == generation)) {
+		ptl3 = walk->ptl3;
+	} else {
+		ptl3 = pt_walk(ptl0, page);
+		if ((walk) && (ptl3)) {
+			walk->ptl0 = ptl0;
+			walk->base = base;
+			walk->ptl3 = ptl3;
+			walk->generation = generation;
+		}
+	}
+	
+	interrupts_restore(ipl);
+	
+	if (!ptl3)
+		return NULL;
 	
 	return &ptl3[PTL3_INDEX(page)];
 }
@@ -79,6 +79,8 @@ typedef struct {
 extern void hash_table_create(hash_table_t *h, size_t m, size_t max_keys,
     hash_table_operations_t *op);
 extern void hash_table_insert(hash_table_t *h, sysarg_t key[], link_t *item);
+extern void hash_table_insert_rcu(hash_table_t *h, sysarg_t key[],
+    link_t *item);
 extern link_t *hash_table_find(hash_table_t *h, sysarg_t key[]);
 extern void hash_table_remove(hash_table_t *h, sysarg_t key[], size_t keys);
 
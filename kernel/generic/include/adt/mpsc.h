@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup genericadt
+ * @{
+ */
+/** @file
+ */
+
+/*
+ * Lock-free intrusive multi-producer single-consumer queue.
+ *
+ * Producers append items by swinging the head pointer to the new item
+ * and linking the former head to it afterwards. The only consumer
+ * removes items from the tail. A stub item keeps the queue non-empty,
+ * so that producers never touch the consumer's end.
+ *
+ * Appending never waits and is safe from interrupt handlers. Between
+ * swinging the head and linking the former head a producer makes the
+ * rest of the queue invisible to the consumer, which sees the queue
+ * empty at that moment. Producers therefore have to notify the consumer
+ * after appending an item rather than expect it to poll.
+ */
+
+#ifndef KERN_MPSC_H_
+#define KERN_MPSC_H_
+
+#include <typedefs.h>
+#include <trace.h>
+
+/** Link of an item in a multi-producer single-consumer queue. */
+typedef struct mpsc_link {
+	struct mpsc_link *volatile next;  /**< Next item or NULL. */
+} mpsc_link_t;
+
+/** Multi-producer single-consumer queue. */
+typedef struct {
+	atomic_t head;       /**< Last item (mpsc_link_t *), used by producers. */
+	mpsc_link_t *tail;   /**< First item, used by the consumer. */
+	mpsc_link_t stub;    /**< Item keeping the queue non-empty. */
+} mpsc_queue_t;
+
+#define mpsc_get_instance(link, type, member) \
+	((type *) (((void *) (link)) - ((void *) &(((type *) NULL)->member))))
+
+/** Check whether the queue is empty
+ *
+ * Only the consumer can call this function.
+ *
+ * @param queue Queue.
+ *
+ * @return True if there are no items in the queue, save for the items
+ *         which are just being appended.
+ *
+ */
+NO_TRACE static inline bool mpsc_empty(mpsc_queue_t *queue)
+{
+	return ((queue->tail == &queue->stub) && (queue->stub.next == NULL));
+}
+
+extern void mpsc_initialize(mpsc_queue_t *);
+extern void mpsc_push(mpsc_queue_t *, mpsc_link_t *);
+extern mpsc_link_t *mpsc_pop(mpsc_queue_t *);
+
+#endif
+
+/** @}
+ */
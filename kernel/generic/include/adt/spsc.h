@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup genericadt
+ * @{
+ */
+/** @file
+ */
+
+/*
+ * Bounded lock-free single-producer single-consumer ring.
+ *
+ * The producer and the consumer each own one free running index and
+ * only read the index of the other side. The indices live in separate
+ * cache lines and each side caches the last seen value of the other
+ * index, so that the cache line of the other side is only touched when
+ * the ring looks full (or empty) and in the common case the two sides
+ * do not share any written cache line besides the slot itself.
+ */
+
+#ifndef KERN_SPSC_H_
+#define KERN_SPSC_H_
+
+#include <typedefs.h>
+#include <atomic.h>
+#include <trace.h>
+
+/** Upper bound of the cache line size of supported processors. */
+#define SPSC_ALIGN  64
+
+/** Single-producer single-consumer ring. */
+typedef struct {
+	/** Consumer side. */
+	struct {
+		volatile size_t head;  /**< Index of the next item to remove. */
+		size_t tail_cache;     /**< Last seen producer index. */
+	} __attribute__ ((aligned(SPSC_ALIGN))) cons;
+	
+	/** Producer side. */
+	struct {
+		volatile size_t tail;  /**< Index of the next free slot. */
+		size_t head_cache;     /**< Last seen consumer index. */
+	} __attribute__ ((aligned(SPSC_ALIGN))) prod;
+	
+	size_t mask;  /**< Number of slots minus one. */
+	void **slots; /**< Slots. */
+} spsc_ring_t;
+
+/** Append an item to a ring
+ *
+ * Only the producer can call this function.
+ *
+ * @param ring Ring.
+ * @param item Item to be appended.
+ *
+ * @return False if the ring is full.
+ *
+ */
+NO_TRACE static inline bool spsc_push(spsc_ring_t *ring, void *item)
+{
+	size_t tail = ring->prod.tail;
+	
+	if (tail - ring->prod.head_cache > ring->mask) {
+		ring->prod.head_cache = ring->cons.head;
+		if (tail - ring->prod.head_cache > ring->mask)
+			return false;
+		
+		/* The consumer has to be done with the slot before we reuse it. */
+		atomic_acquire_barrier();
+	}
+	
+	ring->slots[tail & ring->mask] = item;
+	
+	/* Publish the item before the index. */
+	atomic_release_barrier();
+	ring->prod.tail = tail + 1;
+	
+	return true;
+}
+
+/** Remove the first item from a ring
+ *
+ * Only the consumer can call this function.
+ *
+ * @param ring Ring.
+ * @param item Place to store the removed item to.
+ *
+ * @return False if the ring is empty.
+ *
+ */
+NO_TRACE static inline bool spsc_pop(spsc_ring_t *ring, void **item)
+{
+	size_t head = ring->cons.head;
+	
+	if (head == ring->cons.tail_cache) {
+		ring->cons.tail_cache = ring->prod.tail;
+		if (head == ring->cons.tail_cache)
+			return false;
+		
+		/* Read the items only after the index which published them. */
+		atomic_acquire_barrier();
+	}
+	
+	*item = ring->slots[head & ring->mask];
+	
+	/* Finish reading the slot before handing it back to the producer. */
+	atomic_release_barrier();
+	ring->cons.head = head + 1;
+	
+	return true;
+}
+
+/** Check whether a ring is empty
+ *
+ * Only the consumer can call this function.
+ *
+ * @param ring Ring.
+ *
+ * @return True if there are no items in the ring.
+ *
+ */
+NO_TRACE static inline bool spsc_empty(spsc_ring_t *ring)
+{
+	return (ring->cons.head == ring->prod.tail);
+}
+
+extern bool spsc_create(spsc_ring_t *, size_t, unsigned int);
+extern void spsc_destroy(spsc_ring_t *);
+
+#endif
+
+/** @}
+ */
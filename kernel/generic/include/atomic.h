@@ -37,6 +37,7 @@
 
 #include <typedefs.h>
 #include <arch/atomic.h>
+#include <arch/barrier.h>
 #include <verify.h>
 
 NO_TRACE ATOMIC static inline void atomic_set(atomic_t *val, atomic_count_t i)
@@ -52,6 +53,163 @@ NO_TRACE ATOMIC static inline atomic_count_t atomic_get(atomic_t *val)
 	return val->count;
 }
 
+#ifndef atomic_cas_arch
+#define atomic_cas_arch(val, ov, nv) \
+	__sync_bool_compare_and_swap(&(val)->count, (ov), (nv))
+#endif
+
+/** Atomically replace the value of an atomic variable if it is expected
+ *
+ * The operation is not guaranteed to order other memory accesses,
+ * CS_ENTER_BARRIER() and CS_LEAVE_BARRIER() are to be used for that.
+ *
+ * @param val Atomic variable.
+ * @param ov  Expected value.
+ * @param nv  New value stored if val contains ov.
+ *
+ * @return True if nv has been stored.
+ *
+ */
+NO_TRACE static inline bool atomic_cas(atomic_t *val, atomic_count_t ov,
+    atomic_count_t nv)
+{
+	return atomic_cas_arch(val, ov, nv);
+}
+
+#ifndef atomic_fetch_add_arch
+#define atomic_fetch_add_arch(val, i) \
+	__sync_fetch_and_add(&(val)->count, (i))
+#endif
+
+/** Atomically add to an atomic variable
+ *
+ * The operation is not guaranteed to order other memory accesses.
+ *
+ * @param val Atomic variable.
+ * @param i   Value to be added, possibly wrapped around to subtract.
+ *
+ * @return Value of val before the addition.
+ *
+ */
+NO_TRACE static inline atomic_count_t atomic_fetch_add(atomic_t *val,
+    atomic_count_t i)
+{
+	return atomic_fetch_add_arch(val, i);
+}
+
+/** Atomically replace the value of an atomic variable
+ *
+ * The operation is not guaranteed to order other memory accesses.
+ *
+ * @param val Atomic variable.
+ * @param nv  New value.
+ *
+ * @return Value of val before the replacement.
+ *
+ */
+NO_TRACE static inline atomic_count_t atomic_exchange(atomic_t *val,
+    atomic_count_t nv)
+{
+#ifdef atomic_exchange_arch
+	return atomic_exchange_arch(val, nv);
+#else
+	atomic_count_t ov;
+	
+	do {
+		ov = atomic_get(val);
+	} while (!atomic_cas(val, ov, nv));
+	
+	return ov;
+#endif
+}
+
+/*
+ * Acquire and release ordering
+ *
+ * No memory access following an acquire operation can be performed
+ * before the operation. No memory access preceding a release operation
+ * can be performed after the operation. By default these are the
+ * barriers of the critical sections of spinlocks.
+ */
+
+#ifndef atomic_acquire_barrier_arch
+#define atomic_acquire_barrier_arch()  CS_ENTER_BARRIER()
+#endif
+
+#ifndef atomic_release_barrier_arch
+#define atomic_release_barrier_arch()  CS_LEAVE_BARRIER()
+#endif
+
+/* Acquire barrier which only follows a read-modify-write operation. */
+#ifndef atomic_rmw_acquire_barrier_arch
+#define atomic_rmw_acquire_barrier_arch()  atomic_acquire_barrier_arch()
+#endif
+
+/** Make a preceding load an acquire operation. */
+#define atomic_acquire_barrier()  atomic_acquire_barrier_arch()
+
+/** Make a following store a release operation. */
+#define atomic_release_barrier()  atomic_release_barrier_arch()
+
+NO_TRACE static inline atomic_count_t atomic_get_acquire(atomic_t *val)
+{
+	atomic_count_t count = atomic_get(val);
+	atomic_acquire_barrier_arch();
+	return count;
+}
+
+NO_TRACE static inline void atomic_set_release(atomic_t *val,
+    atomic_count_t i)
+{
+	atomic_release_barrier_arch();
+	atomic_set(val, i);
+}
+
+NO_TRACE static inline bool atomic_cas_acquire(atomic_t *val,
+    atomic_count_t ov, atomic_count_t nv)
+{
+	bool stored = atomic_cas(val, ov, nv);
+	atomic_rmw_acquire_barrier_arch();
+	return stored;
+}
+
+NO_TRACE static inline bool atomic_cas_release(atomic_t *val,
+    atomic_count_t ov, atomic_count_t nv)
+{
+	atomic_release_barrier_arch();
+	return atomic_cas(val, ov, nv);
+}
+
+NO_TRACE static inline atomic_count_t atomic_fetch_add_acquire(atomic_t *val,
+    atomic_count_t i)
+{
+	atomic_count_t count = atomic_fetch_add(val, i);
+	atomic_rmw_acquire_barrier_arch();
+	return count;
+}
+
+NO_TRACE static inline atomic_count_t atomic_fetch_add_release(atomic_t *val,
+    atomic_count_t i)
+{
+	atomic_release_barrier_arch();
+	return atomic_fetch_add(val, i);
+}
+
+NO_TRACE static inline atomic_count_t atomic_exchange_acquire(atomic_t *val,
+    atomic_count_t nv)
+{
+	atomic_count_t count = atomic_exchange(val, nv);
+	atomic_rmw_acquire_barrier_arch();
+	return count;
+}
+
+NO_TRACE static inline atomic_count_t atomic_exchange_release(atomic_t *val,
+    atomic_count_t nv)
+{
+	atomic_release_barrier_arch();
+	return atomic_exchange(val, nv);
+}
+
 #endif
 
 /** @}
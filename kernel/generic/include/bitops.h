@@ -36,6 +36,7 @@
 #define KERN_BITOPS_H_
 
 #include <trace.h>
+#include <arch/asm.h>
 
 #ifdef __32_BITS__
 	#define fnzb(arg)  fnzb32(arg)
@@ -46,12 +47,18 @@
 #endif
 
 /** Return position of first non-zero bit from left (32b variant).
+ *
+ * Architectures with a count leading zeros instruction
+ * can provide fnzb32_arch() in arch/asm.h.
  *
  * @return 0 (if the number is zero) or [log_2(arg)].
  *
  */
 NO_TRACE static inline uint8_t fnzb32(uint32_t arg)
 {
+#ifdef fnzb32_arch
+	return fnzb32_arch(arg);
+#else
 	uint8_t n = 0;
 	
 	if (arg >> 16) {
@@ -78,6 +85,7 @@ NO_TRACE static inline uint8_t fnzb32(uint32_t arg)
 		n += 1;
 	
 	return n;
+#endif
 }
 
 /** Return position of first non-zero bit from left (64b variant).
@@ -37,6 +37,7 @@
 
 #include <adt/list.h>
 #include <synch/spinlock.h>
+#include <synch/rwlock.h>
 
 #define MAX_CMDLINE       256
 #define KCONSOLE_HISTORY  10
@@ -87,7 +88,7 @@ typedef struct {
 
 extern bool kconsole_notify;
 
-SPINLOCK_EXTERN(cmd_lock);
+extern rwlock_t cmd_lock;
 extern list_t cmd_list;
 
 extern void kconsole_init(void);
@@ -37,9 +37,13 @@
 
 #include <mm/tlb.h>
 #include <synch/spinlock.h>
+#include <synch/rcu.h>
+#include <ddi/work.h>
 #include <proc/scheduler.h>
+#include <time/wheel.h>
 #include <arch/cpu.h>
 #include <arch/context.h>
+#include <arch/mm/as.h>
 
 /** CPU structure.
  *
@@ -55,10 +59,32 @@ typedef struct cpu {
 	
 	atomic_t nrdy;
 	runq_t rq[RQ_COUNT];
+	
+	/**
+	 * Bitmap of non-empty run queues. Modified by
+	 * rq_map_update() only, can be read without
+	 * any lock held.
+	 */
+	volatile uint32_t rq_map;
+	SPINLOCK_DECLARE(rq_map_lock);
 	volatile size_t needs_relink;
 	
+	fairq_t fairq;
+	rtq_t rtq;
+	
+	/** Read-copy-update state. */
+	rcu_cpu_t rcu;
+	
+	/** Deferred work for interrupt handlers. */
+	work_cpu_t work;
+	
+#ifdef CONFIG_SPINLOCK_mcs
+	/** Queue nodes of MCS spinlocks. */
+	mcs_cpu_t mcs;
+#endif
+	
 	IRQ_SPINLOCK_DECLARE(timeoutlock);
-	list_t timeout_active_list;
+	timeout_wheel_t timeout_wheel;
 	
 	/**
 	 * When system clock loses a tick, it is
@@ -90,6 +116,9 @@ typedef struct cpu {
 	
 	cpu_arch_t arch;
 	
+	/** Non-generic content. */
+	cpu_genarch_t genarch;
+	
 	struct thread *fpu_owner;
 	
 	/**
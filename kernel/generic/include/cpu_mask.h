@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup generic
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_CPU_MASK_H_
+#define KERN_CPU_MASK_H_
+
+#include <typedefs.h>
+#include <trace.h>
+
+/** Maximal number of CPUs a CPU mask can describe. */
+#define CPU_MASK_MAX  128
+
+#define CPU_MASK_WORDS  ((CPU_MASK_MAX + 31) / 32)
+
+/** Set of CPUs, CPU n being represented by bit n. */
+typedef struct {
+	uint32_t bits[CPU_MASK_WORDS];
+} cpu_mask_t;
+
+/** Make the mask contain all CPUs.
+ *
+ * @param mask CPU mask.
+ *
+ */
+NO_TRACE static inline void cpu_mask_all(cpu_mask_t *mask)
+{
+	for (unsigned int i = 0; i < CPU_MASK_WORDS; i++)
+		mask->bits[i] = UINT32_MAX;
+}
+
+/** Make the mask contain no CPU.
+ *
+ * @param mask CPU mask.
+ *
+ */
+NO_TRACE static inline void cpu_mask_none(cpu_mask_t *mask)
+{
+	for (unsigned int i = 0; i < CPU_MASK_WORDS; i++)
+		mask->bits[i] = 0;
+}
+
+/** Add a CPU to the mask.
+ *
+ * @param mask CPU mask.
+ * @param id   ID of the CPU.
+ *
+ */
+NO_TRACE static inline void cpu_mask_set(cpu_mask_t *mask, unsigned int id)
+{
+	if (id < CPU_MASK_MAX)
+		mask->bits[id / 32] |= UINT32_C(1) << (id % 32);
+}
+
+/** Remove a CPU from the mask.
+ *
+ * @param mask CPU mask.
+ * @param id   ID of the CPU.
+ *
+ */
+NO_TRACE static inline void cpu_mask_clear(cpu_mask_t *mask, unsigned int id)
+{
+	if (id < CPU_MASK_MAX)
+		mask->bits[id / 32] &= ~(UINT32_C(1) << (id % 32));
+}
+
+/** Check whether the mask contains a CPU.
+ *
+ * @param mask CPU mask.
+ * @param id   ID of the CPU.
+ *
+ * @return True if the CPU is in the mask.
+ *
+ */
+NO_TRACE static inline bool cpu_mask_is_set(const cpu_mask_t *mask,
+    unsigned int id)
+{
+	if (id >= CPU_MASK_MAX)
+		return false;
+	
+	return ((mask->bits[id / 32] & (UINT32_C(1) << (id % 32))) != 0);
+}
+
+#endif
+
+/** @}
+ */
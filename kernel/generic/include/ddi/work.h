@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup genericddi
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_WORK_H_
+#define KERN_WORK_H_
+
+#include <typedefs.h>
+#include <adt/mpsc.h>
+#include <synch/waitq.h>
+
+/** Deferred work function. */
+typedef void (*work_func_t)(void *);
+
+/** Deferred work item
+ *
+ * Usually embedded in the structure of the device whose
+ * interrupt handler defers the work.
+ *
+ */
+typedef struct {
+	mpsc_link_t link;
+	
+	/** Non-zero while the item is queued. */
+	atomic_t pending;
+	
+	work_func_t func;
+	void *arg;
+} work_t;
+
+/** Per-CPU deferred work state */
+typedef struct {
+	/** Items queued on this CPU, consumed by its worker thread only. */
+	mpsc_queue_t queue;
+	
+	/** The worker thread sleeps here. */
+	waitq_t wq;
+	
+	/** True while the worker thread processes the queue. */
+	volatile bool running;
+	
+	/** Statistics. */
+	uint64_t items;
+	uint64_t batches;
+} work_cpu_t;
+
+extern void work_initialize(work_t *, work_func_t, void *);
+extern bool work_queue(work_t *);
+extern void work_cpu_init(work_cpu_t *);
+extern void work_init(void);
+
+#endif
+
+/** @}
+ */
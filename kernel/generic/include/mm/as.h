@@ -47,6 +47,7 @@
 #include <adt/list.h>
 #include <adt/btree.h>
 #include <lib/elf.h>
+#include <mm/frame.h>
 
 /**
  * Defined to be true if user address space and kernel address space shadow each
@@ -110,10 +111,22 @@ typedef struct as {
 	atomic_t refcount;
 	
 	mutex_t lock;
-	
+
 	/** B+tree of address space areas. */
 	btree_t as_area_btree;
-	
+
+	/**
+	 * Number of virtual pages in all address space areas.
+	 * Modified with lock held, can be read without it.
+	 */
+	atomic_t virt_pages;
+
+	/**
+	 * Number of resident pages in all address space areas.
+	 * Modified with lock held, can be read without it.
+	 */
+	atomic_t resident_pages;
+
 	/** Non-generic content. */
 	as_genarch_t genarch;
 	
@@ -232,7 +245,7 @@ typedef struct mem_backend {
 	bool (* is_shareable)(as_area_t *);
 
 	int (* page_fault)(as_area_t *, uintptr_t, pf_access_t);
-	void (* frame_free)(as_area_t *, uintptr_t, uintptr_t);
+	void (* frame_free)(as_area_t *, uintptr_t, uintptr_t, frame_batch_t *);
 
 	bool (* create_shared_data)(as_area_t *);
 	void (* destroy_shared_data)(void *);
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup genericmm
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_COPY_H_
+#define KERN_COPY_H_
+
+#include <typedefs.h>
+#include <arch/barrier.h>
+
+/*
+ * Architectures may speed up the copying by providing the size of
+ * the data cache block and the hints for manipulating it.
+ */
+
+#ifndef DCACHE_BLOCK_SIZE
+#define DCACHE_BLOCK_SIZE  (8 * sizeof(sysarg_t))
+#endif
+
+#ifndef dcache_block_prefetch
+#define dcache_block_prefetch(addr)  ((void) (addr))
+#endif
+
+#ifndef dcache_block_zero
+#define dcache_block_zero(addr)  ((void) (addr))
+#endif
+
+extern size_t memcpy_from_uspace(void *, const void *, size_t);
+extern size_t memcpy_to_uspace(void *, const void *, size_t);
+
+extern int copy_from_uspace(void *, const void *, size_t);
+extern int copy_to_uspace(void *, const void *, size_t);
+
+extern void copy_failover(void);
+
+#endif
+
+/** @}
+ */
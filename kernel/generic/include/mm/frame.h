@@ -128,6 +128,22 @@ typedef struct {
 
 extern zones_t zones;
 
+/** Number of frames collected by a frame batch before it is flushed. */
+#define FRAME_BATCH_SIZE  32
+
+/** Batch of frames to be freed at once.
+ *
+ * Freeing frames one at a time acquires the zones lock and signals
+ * memory availability for every single frame. The batch collects
+ * frames which are then freed under one acquisition of the zones lock.
+ *
+ */
+typedef struct {
+	size_t count;
+	uintptr_t frame[FRAME_BATCH_SIZE];
+	frame_flags_t flags[FRAME_BATCH_SIZE];
+} frame_batch_t;
+
 extern void frame_init(void);
 extern bool frame_adjust_zone_bounds(bool, uintptr_t *, size_t *);
 extern uintptr_t frame_alloc_generic(size_t, frame_flags_t, uintptr_t,
@@ -136,7 +152,11 @@ extern uintptr_t frame_alloc(size_t, frame_flags_t, uintptr_t);
 extern void frame_free_generic(uintptr_t, size_t, frame_flags_t);
 extern void frame_free(uintptr_t, size_t);
 extern void frame_free_noreserve(uintptr_t, size_t);
+extern void frame_batch_initialize(frame_batch_t *);
+extern void frame_batch_add(frame_batch_t *, uintptr_t, frame_flags_t);
+extern void frame_batch_flush(frame_batch_t *);
 extern void frame_reference_add(pfn_t);
+extern bool frame_reference_try_add(pfn_t);
 extern size_t frame_total_free_get(void);
 
 extern size_t find_zone(pfn_t, size_t, size_t);
@@ -43,10 +43,19 @@
 #define P2SZ(pages) \
 	((pages) << PAGE_WIDTH)	
 
+/** Callback invoked for each mapping destroyed by page_mapping_remove_range().
+ *
+ * The arguments are the callback argument, the virtual page and the frame
+ * it was mapped to.
+ */
+typedef void (* page_mapping_release_t)(void *, uintptr_t, uintptr_t);
+
 /** Operations to manipulate page mappings. */
 typedef struct {
 	void (* mapping_insert)(as_t *, uintptr_t, uintptr_t, unsigned int);
 	void (* mapping_remove)(as_t *, uintptr_t);
+	void (* mapping_remove_range)(as_t *, uintptr_t, size_t,
+	    page_mapping_release_t, void *);
 	pte_t *(* mapping_find)(as_t *, uintptr_t, bool);
 	void (* mapping_make_global)(uintptr_t, size_t);
 } page_mapping_operations_t;
@@ -59,6 +68,8 @@ extern void page_table_unlock(as_t *, bool);
 extern bool page_table_locked(as_t *);
 extern void page_mapping_insert(as_t *, uintptr_t, uintptr_t, unsigned int);
 extern void page_mapping_remove(as_t *, uintptr_t);
+extern void page_mapping_remove_range(as_t *, uintptr_t, size_t,
+    page_mapping_release_t, void *);
 extern pte_t *page_mapping_find(as_t *, uintptr_t, bool);
 extern void page_mapping_make_global(uintptr_t, size_t);
 extern pte_t *page_table_create(unsigned int);
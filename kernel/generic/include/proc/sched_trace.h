@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup genericproc
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_SCHED_TRACE_H_
+#define KERN_SCHED_TRACE_H_
+
+#include <typedefs.h>
+#include <abi/sysinfo.h>
+#include <trace.h>
+
+/** Number of events kept per processor (must be a power of two). */
+#define SCHED_TRACE_ENTRIES  1024
+
+struct cpu;
+
+extern volatile bool sched_trace_enabled;
+
+extern void sched_trace_init(void);
+extern bool sched_trace_enable(void);
+extern void sched_trace_disable(void);
+extern void sched_trace_record(sched_trace_type_t, thread_id_t, uint64_t,
+    struct cpu *);
+extern size_t sched_trace_drain(sched_trace_event_t *, size_t);
+extern void sched_trace_print(void);
+
+/** Record a scheduler trace event if tracing is enabled.
+ *
+ * @param type   Event type.
+ * @param tid    ID of the thread the event is about.
+ * @param arg    Type specific argument.
+ * @param target Processor whose run queue the thread lands in.
+ *
+ */
+NO_TRACE static inline void sched_trace(sched_trace_type_t type,
+    thread_id_t tid, uint64_t arg, struct cpu *target)
+{
+	if (sched_trace_enabled)
+		sched_trace_record(type, tid, arg, target);
+}
+
+#endif
+
+/** @}
+ */
@@ -40,10 +40,45 @@
 #include <typedefs.h>
 #include <atomic.h>
 #include <adt/list.h>
+#include <adt/avl.h>
 
 #define RQ_COUNT          16
 #define NEEDS_RELINK_MAX  (HZ)
 
+/** Bit of a run queue in the bitmap of non-empty run queues.
+ *
+ * The highest-priority queue corresponds to the most significant bit,
+ * so that the index of the highest-priority non-empty queue equals the
+ * number of leading zero bits in the bitmap.
+ *
+ */
+#define RQ_MAP_BIT(i)  (UINT32_C(1) << (31 - (i)))
+
+/** Highest-priority run queue to give way to the fair class. */
+#define FAIR_PRIORITY  (RQ_COUNT / 2)
+
+/** Period in which every ready fair thread should run (microseconds). */
+#define FAIR_LATENCY  20000
+
+/** Minimal time slice of a fair thread (microseconds). */
+#define FAIR_GRANULARITY  2000
+
+/** Number of real-time priorities. */
+#define RT_COUNT  8
+
+/** Time slice of a real-time thread (microseconds). */
+#define RT_QUANTUM  10000
+
+/** Period in which the real-time bandwidth is enforced (microseconds). */
+#define RT_PERIOD  1000000
+
+/** Default share of RT_PERIOD available to real-time threads (percent). */
+#define RT_BANDWIDTH  95
+
+#if (RQ_COUNT > 32)
+#error "The bitmap of non-empty run queues is too small."
+#endif
+
 /** Scheduler run queue structure. */
 typedef struct {
 	IRQ_SPINLOCK_DECLARE(lock);
@@ -51,12 +86,55 @@ typedef struct {
 	size_t n;			/**< Number of threads in rq_ready. */
 } runq_t;
 
+/** Scheduler fair run queue structure.
+ *
+ * Ready threads of the fair class are ordered by their virtual runtime
+ * and the thread which has consumed the least processor time runs next.
+ *
+ */
+typedef struct {
+	IRQ_SPINLOCK_DECLARE(lock);
+	avltree_t tree;         /**< Ready threads keyed by vruntime. */
+	size_t n;               /**< Number of threads in tree. */
+	uint64_t min_vruntime;  /**< Monotonic base for threads entering tree. */
+} fairq_t;
+
+/** Scheduler real-time run queue structure.
+ *
+ * Ready real-time threads are kept in a FIFO queue per priority,
+ * priority 0 being the highest. Real-time threads run before all
+ * the other threads unless they have consumed their bandwidth in
+ * the current period.
+ *
+ */
+typedef struct {
+	IRQ_SPINLOCK_DECLARE(lock);
+	list_t rq[RT_COUNT];   /**< Ready threads of each priority. */
+	size_t n;              /**< Number of threads in all queues. */
+	unsigned int current;  /**< Priority of the running thread
+	                            (RT_COUNT if it is not real-time). */
+	bool preempt;          /**< The running thread should be preempted. */
+	bool throttled;        /**< The bandwidth has been exhausted. */
+	uint64_t runtime;      /**< Ticks spent running real-time threads
+	                            in the current period. */
+	uint64_t period;       /**< Ticks elapsed in the current period. */
+} rtq_t;
+
+struct cpu;
+struct thread;
+
 extern atomic_t nrdy;
 extern void scheduler_init(void);
+extern void rq_map_update(struct cpu *, unsigned int);
+extern void fairq_insert(struct cpu *, struct thread *);
+extern bool rtq_insert(struct cpu *, struct thread *, bool);
+extern void rt_bandwidth_set(unsigned int);
+extern unsigned int rt_bandwidth_get(void);
+extern bool rt_tick(size_t);
+extern void scheduler_preempt(void);
 
 extern void scheduler_fpu_lazy_request(void);
 extern void scheduler(void);
-extern void kcpulb(void *arg);
 
 extern void sched_print_list(void);
 
@@ -38,9 +38,9 @@
 #include <cpu.h>
 #include <synch/spinlock.h>
 #include <synch/mutex.h>
+#include <synch/rwlock.h>
 #include <synch/futex.h>
 #include <adt/avl.h>
-#include <adt/btree.h>
 #include <adt/list.h>
 #include <arch/proc/task.h>
 #include <arch/proc/thread.h>
@@ -84,20 +84,12 @@ typedef struct task {
 	/** Architecture specific task data. */
 	task_arch_t arch;
 	
-	/**
-	 * Serializes access to the B+tree of task's futexes. This mutex is
-	 * independent on the task spinlock.
-	 */
-	mutex_t futexes_lock;
-	/** B+tree of futexes referenced by this task. */
-	btree_t futexes;
-	
 	/** Accumulated accounting. */
 	uint64_t ucycles;
 	uint64_t kcycles;
 } task_t;
 
-IRQ_SPINLOCK_EXTERN(tasks_lock);
+IRQ_RWLOCK_EXTERN(tasks_lock);
 extern avltree_t tasks_tree;
 
 extern void task_init(void);
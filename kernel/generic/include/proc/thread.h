@@ -39,7 +39,9 @@
 #include <proc/task.h>
 #include <time/timeout.h>
 #include <cpu.h>
+#include <cpu_mask.h>
 #include <synch/spinlock.h>
+#include <synch/rwlock.h>
 #include <adt/avl.h>
 #include <mm/slab.h>
 #include <arch/cpu.h>
@@ -58,9 +60,20 @@ typedef enum {
 	/** Thread will be attached by the caller. */
 	THREAD_FLAG_NOATTACH = (1 << 1),
 	/** Thread accounting doesn't affect accumulated task accounting. */
-	THREAD_FLAG_UNCOUNTED = (1 << 2)
+	THREAD_FLAG_UNCOUNTED = (1 << 2),
+	/** Thread is scheduled by the fair scheduling class. */
+	THREAD_FLAG_FAIR = (1 << 3),
+	/** Thread is real-time and runs until it blocks or yields. */
+	THREAD_FLAG_RT_FIFO = (1 << 4),
+	/** Thread is real-time and shares its priority round-robin. */
+	THREAD_FLAG_RT_RR = (1 << 5)
 } thread_flags_t;
 
+/** Real-time priority of the thread (0 is the highest). */
+#define THREAD_FLAG_RT_PRIORITY_SHIFT  8
+#define THREAD_FLAG_RT_PRIORITY(prio) \
+	((prio) << THREAD_FLAG_RT_PRIORITY_SHIFT)
+
 /** Thread structure. There is one per thread. */
 typedef struct thread {
 	link_t rq_link;  /**< Run queue link. */
@@ -70,6 +83,9 @@ typedef struct thread {
 	/** Threads linkage to the threads_tree. */
 	avltree_node_t threads_tree_node;
 	
+	/** Fair run queue link. */
+	avltree_node_t fairq_node;
+	
 	/** Lock protecting thread structure.
 	 *
 	 * Protects the whole thread structure except list links above.
@@ -101,6 +117,13 @@ typedef struct thread {
 	 */
 	context_t sleep_interruption_context;
 	
+	/**
+	 * If not NULL, the thread is copying data between the kernel
+	 * and uspace and the context is restored when the copying
+	 * cannot continue due to a page fault.
+	 */
+	context_t *copy_failover;
+	
 	/** If true, the thread can be interrupted from sleep. */
 	bool sleep_interruptible;
 	/** Wait queue in which this thread sleeps. */
@@ -143,10 +166,8 @@ typedef struct thread {
 	cpu_t *cpu;
 	/** Containing task. */
 	task_t *task;
-	/** Thread is wired to CPU. */
-	bool wired;
-	/** Thread was migrated to another CPU and has not run yet. */
-	bool stolen;
+	/** CPUs the thread is allowed to run on. */
+	cpu_mask_t affinity;
 	/** Thread is executed in user space. */
 	bool uspace;
 	
@@ -163,6 +184,20 @@ typedef struct thread {
 	
 	/** Thread's priority. Implemented as index to CPU->rq */
 	int priority;
+	
+	/** Thread is scheduled by the fair scheduling class. */
+	bool fair;
+	/** Processor time consumed by the thread in the fair class. */
+	uint64_t vruntime;
+	/** Sum of ucycles and kcycles when vruntime was last updated. */
+	uint64_t vruntime_cycles;
+	
+	/** Thread is scheduled by the real-time scheduling class. */
+	bool rt;
+	/** Real-time thread shares its priority round-robin. */
+	bool rt_rr;
+	/** Fixed real-time priority (0 is the highest). */
+	unsigned int rt_priority;
 	/** Thread ID. */
 	thread_id_t tid;
 	
@@ -180,7 +215,7 @@ typedef struct thread {
  * Must be acquired before T.lock for each T of type thread_t.
  *
  */
-IRQ_SPINLOCK_EXTERN(threads_lock);
+IRQ_RWLOCK_EXTERN(threads_lock);
 
 /** AVL tree containing all threads. */
 extern avltree_t threads_tree;
@@ -189,6 +224,7 @@ extern void thread_init(void);
 extern thread_t *thread_create(void (*)(void *), void *, task_t *,
     thread_flags_t, const char *);
 extern void thread_wire(thread_t *, cpu_t *);
+extern int thread_set_affinity(thread_t *, const cpu_mask_t *);
 extern void thread_attach(thread_t *, task_t *);
 extern void thread_ready(thread_t *);
 extern void thread_exit(void) __attribute__((noreturn));
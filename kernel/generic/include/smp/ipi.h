@@ -37,12 +37,18 @@
 
 #ifdef CONFIG_SMP
 
+struct cpu;
+
 extern void ipi_broadcast(int);
 extern void ipi_broadcast_arch(int);
+extern void ipi_unicast_arch(struct cpu *, int);
+extern void ipi_wakeup(struct cpu *);
+extern void ipi_wakeup_recv(void);
 
 #else
 
 #define ipi_broadcast(ipi)
+#define ipi_wakeup(cpu)  ((void) (cpu))
 
 #endif /* CONFIG_SMP */
 
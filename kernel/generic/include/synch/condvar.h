@@ -42,6 +42,16 @@
 
 typedef struct {
 	waitq_t wq;
+	/**
+	 * Mutex used by all the waiters or NULL if they use different
+	 * mutexes. Protected by the lock of the wait queue.
+	 */
+	mutex_t *mtx;
+	/**
+	 * Number of waiters still to be woken up by a broadcast,
+	 * one by one. Protected by the lock of the wait queue.
+	 */
+	size_t chain;
 } condvar_t;
 
 #define condvar_wait(cv, mtx) \
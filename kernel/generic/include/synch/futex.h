@@ -36,22 +36,21 @@
 #define KERN_FUTEX_H_
 
 #include <typedefs.h>
-#include <synch/waitq.h>
-
-/** Kernel-side futex structure. */
-typedef struct {
-	/** Physical address of the status variable. */
-	uintptr_t paddr;
-	/** Wait queue for threads waiting for futex availability. */
-	waitq_t wq;
-	/** Futex hash table link. */
-	link_t ht_link;
-	/** Number of tasks that reference this futex. */
-	size_t refcount;
-} futex_t;
+#include <atomic.h>
 
 extern void futex_init(void);
-extern void futex_cleanup(void);
+
+extern int futex_wait(uintptr_t, atomic_count_t, uint32_t);
+extern int futex_wake(uintptr_t, size_t);
+extern int futex_requeue(uintptr_t, atomic_count_t, size_t, uintptr_t, size_t);
+extern int futex_wake_op(uintptr_t, size_t, uintptr_t, size_t, uint32_t);
+
+extern sysarg_t sys_futex_wait(uintptr_t, sysarg_t, sysarg_t);
+extern sysarg_t sys_futex_wake(uintptr_t, sysarg_t);
+extern sysarg_t sys_futex_requeue(uintptr_t, sysarg_t, sysarg_t, uintptr_t,
+    sysarg_t);
+extern sysarg_t sys_futex_wake_op(uintptr_t, sysarg_t, uintptr_t, sysarg_t,
+    sysarg_t);
 
 #endif
 
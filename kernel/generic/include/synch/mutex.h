@@ -36,7 +36,8 @@
 #define KERN_MUTEX_H_
 
 #include <typedefs.h>
-#include <synch/semaphore.h>
+#include <atomic.h>
+#include <synch/waitq.h>
 #include <abi/synch.h>
 
 typedef enum {
@@ -44,9 +45,25 @@ typedef enum {
 	MUTEX_ACTIVE
 } mutex_type_t;
 
+/** Owner word flag indicating that the owner has to wake up a waiter. */
+#define MUTEX_CONTENDED  1
+
+/** Owner word of a mutex locked when there was no thread yet. */
+#define MUTEX_NO_THREAD  2
+
 typedef struct {
 	mutex_type_t type;
-	semaphore_t sem;
+	/**
+	 * Owner thread or MUTEX_NO_THREAD, possibly combined with
+	 * MUTEX_CONTENDED, or zero if the mutex is unlocked.
+	 */
+	atomic_t owner;
+	/** Threads waiting for the mutex. */
+	waitq_t wq;
+#ifdef CONFIG_LOCKSTAT
+	/** Code which initialized the mutex, identifies its lock class. */
+	uintptr_t site;
+#endif
 } mutex_t;
 
 #define mutex_lock(mtx) \
@@ -59,9 +76,12 @@ typedef struct {
 	_mutex_lock_timeout((mtx), (usec), SYNCH_FLAGS_NON_BLOCKING)
 
 extern void mutex_initialize(mutex_t *, mutex_type_t);
+extern void mutex_initialize_site(mutex_t *, mutex_type_t, uintptr_t);
 extern bool mutex_locked(mutex_t *);
 extern int _mutex_lock_timeout(mutex_t *, uint32_t, unsigned int);
 extern void mutex_unlock(mutex_t *);
+extern bool mutex_requeue(mutex_t *, waitq_t *, wakeup_mode_t);
+extern void mutex_lock_requeued(mutex_t *);
 
 #endif
 
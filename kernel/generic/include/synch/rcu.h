@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup sync
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_RCU_H_
+#define KERN_RCU_H_
+
+#include <typedefs.h>
+#include <adt/list.h>
+#include <synch/spinlock.h>
+#include <arch/barrier.h>
+#include <preemption.h>
+
+struct rcu_item;
+
+/** Function invoked once a grace period has elapsed. */
+typedef void (*rcu_func_t)(struct rcu_item *);
+
+/** Deferred callback
+ *
+ * Usually embedded in the structure to be reclaimed.
+ *
+ */
+typedef struct rcu_item {
+	struct rcu_item *next;
+	rcu_func_t func;
+} rcu_item_t;
+
+/** Per-CPU RCU state */
+typedef struct {
+	/**
+	 * Number of the grace period which was already running when
+	 * the CPU passed its last quiescent state.
+	 */
+	volatile size_t qs_gp;
+	
+	/** Protects the callback list. */
+	IRQ_SPINLOCK_DECLARE(lock);
+	
+	/** Callbacks queued on this CPU, not yet claimed by the reclaimer. */
+	rcu_item_t *cbs;
+	rcu_item_t **cbs_tail;
+} rcu_cpu_t;
+
+/** Enter RCU read-side critical section
+ *
+ * Readers must not sleep. The critical sections may nest.
+ *
+ */
+NO_TRACE static inline void rcu_read_lock(void)
+{
+	preemption_disable();
+}
+
+/** Leave RCU read-side critical section */
+NO_TRACE static inline void rcu_read_unlock(void)
+{
+	preemption_enable();
+}
+
+/** Publish a pointer to be followed by RCU readers
+ *
+ * Makes the initialization of the pointed-to structure
+ * visible before the pointer itself.
+ *
+ */
+#define rcu_assign_pointer(ptr, val) \
+	do { \
+		write_barrier(); \
+		(ptr) = (val); \
+	} while (0)
+
+/** Append item to a list traversed by RCU readers
+ *
+ * Writers still have to be serialised by the caller.
+ *
+ * @param link Link to be appended.
+ * @param list List to append to.
+ *
+ */
+NO_TRACE static inline void rcu_list_append(link_t *link, list_t *list)
+{
+	link->next = &list->head;
+	link->prev = list->head.prev;
+	
+	/* The link must be complete before readers can reach it. */
+	write_barrier();
+	
+	list->head.prev->next = link;
+	list->head.prev = link;
+}
+
+extern void rcu_init(void);
+extern void rcu_cpu_init(rcu_cpu_t *);
+extern void rcu_quiescent_state(void);
+extern void rcu_call(rcu_item_t *, rcu_func_t);
+extern void rcu_synchronize(void);
+extern void rcu_reclaimer(void *);
+
+#endif
+
+/** @}
+ */
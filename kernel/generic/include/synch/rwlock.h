@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup sync
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_RWLOCK_H_
+#define KERN_RWLOCK_H_
+
+#include <typedefs.h>
+#include <cpu_mask.h>
+#include <synch/spinlock.h>
+#include <synch/mutex.h>
+#include <synch/condvar.h>
+
+/** Sleeping reader-writer lock
+ *
+ * Any number of readers or a single writer may hold the lock.
+ * Writers are preferred: once a writer is waiting, new readers
+ * are held back until all waiting writers are done.
+ *
+ */
+typedef struct {
+	/** Protects the fields below. */
+	mutex_t mtx;
+	/** Readers waiting for the writers to finish. */
+	condvar_t readers_cv;
+	/** Writers waiting for the lock to drain. */
+	condvar_t writers_cv;
+	/** Number of readers holding the lock. */
+	size_t readers;
+	/** Number of readers waiting for the lock. */
+	size_t readers_waiting;
+	/** Number of writers waiting for the lock. */
+	size_t writers_waiting;
+	/** A writer holds the lock. */
+	bool writer;
+} rwlock_t;
+
+#ifdef CONFIG_SMP
+	#define IRQ_RWLOCK_CPUS  CPU_MASK_MAX
+#else
+	#define IRQ_RWLOCK_CPUS  1
+#endif
+
+/** Upper bound of the cache line size of supported processors. */
+#define IRQ_RWLOCK_ALIGN  64
+
+/** Per-CPU reader state of an interrupts-disabled reader-writer lock
+ *
+ * Each slot occupies a cache line of its own, so that readers on
+ * different CPUs do not share it.
+ *
+ */
+typedef struct {
+	/** Number of nested read acquisitions on this CPU. */
+	volatile size_t readers;
+	/** Interrupt level to restore by the outermost reader. */
+	ipl_t ipl;
+} __attribute__ ((aligned(IRQ_RWLOCK_ALIGN))) irq_rwlock_cpu_t;
+
+/** Interrupts-disabled spinning reader-writer lock
+ *
+ * Readers only touch the slot of their own CPU, so read-mostly
+ * data can be looked up on many CPUs without bouncing a shared
+ * lock word. Writers serialise on a spinlock, announce themselves
+ * and wait for the reader counts of all CPUs to drop to zero.
+ * Readers back off while a writer is announced.
+ *
+ */
+typedef struct {
+	/** Serialises writers and keeps their interrupt level. */
+	irq_spinlock_t lock;
+	/** A writer holds or is waiting for the lock. */
+	volatile bool writer;
+	/** Per-CPU reader counts. */
+	irq_rwlock_cpu_t cpus[IRQ_RWLOCK_CPUS];
+} irq_rwlock_t;
+
+#define IRQ_RWLOCK_DECLARE(lock_name)  irq_rwlock_t lock_name
+#define IRQ_RWLOCK_EXTERN(lock_name)   extern irq_rwlock_t lock_name
+
+extern void rwlock_initialize(rwlock_t *, mutex_type_t);
+extern void rwlock_read_lock(rwlock_t *);
+extern void rwlock_read_unlock(rwlock_t *);
+extern void rwlock_write_lock(rwlock_t *);
+extern void rwlock_write_unlock(rwlock_t *);
+
+extern void irq_rwlock_initialize(irq_rwlock_t *, const char *);
+extern void irq_rwlock_read_lock(irq_rwlock_t *, bool);
+extern void irq_rwlock_read_unlock(irq_rwlock_t *, bool);
+extern void irq_rwlock_write_lock(irq_rwlock_t *, bool);
+extern void irq_rwlock_write_unlock(irq_rwlock_t *, bool);
+extern bool irq_rwlock_locked(irq_rwlock_t *);
+
+#endif
+
+/** @}
+ */
@@ -41,6 +41,10 @@
 
 typedef struct {
 	waitq_t wq;
+#ifdef CONFIG_LOCKSTAT
+	/** Code which initialized the semaphore, identifies its lock class. */
+	uintptr_t site;
+#endif
 } semaphore_t;
 
 #define semaphore_down(s) \
@@ -44,14 +44,104 @@
 
 #ifdef CONFIG_SMP
 
+#if (defined(CONFIG_SPINLOCK_ticket)) || (defined(CONFIG_SPINLOCK_mcs))
+	#define SPINLOCK_QUEUED
+#endif
+
+/*
+ * Spinlocks carry a name if it is needed either for reporting
+ * deadlocks or for identifying the lock in contention statistics.
+ */
+#if (defined(CONFIG_DEBUG_SPINLOCK)) || (defined(CONFIG_LOCKSTAT))
+	#define SPINLOCK_NAMED
+#endif
+
+#if defined(CONFIG_SPINLOCK_ticket)
+
+/** Ticket spinlock
+ *
+ * Waiters are served in the order in which they drew their
+ * tickets, spinning on the word of the current owner.
+ *
+ */
+typedef struct {
+	atomic_t next;   /**< Next ticket to be drawn */
+	atomic_t owner;  /**< Ticket of the current owner */
+	
+#ifdef SPINLOCK_NAMED
+	const char *name;
+#endif /* SPINLOCK_NAMED */
+} spinlock_t;
+
+#define SPINLOCK_INITIALIZER_FIELDS \
+	.next = { 0 }, \
+	.owner = { 0 }
+
+#elif defined(CONFIG_SPINLOCK_mcs)
+
+/** Number of MCS queue nodes per CPU
+ *
+ * Bounds the number of spinlocks a single CPU can be
+ * holding or waiting for at the same time, including
+ * locks taken by nested interrupt handlers.
+ *
+ */
+#define MCS_NODES  16
+
+struct mcs_cpu;
+
+/** MCS queue node */
+typedef struct mcs_node {
+	/** Successor in the queue */
+	struct mcs_node *volatile next;
+	/** Set while the waiter has to keep spinning */
+	volatile bool locked;
+	/** Set of nodes this node belongs to */
+	struct mcs_cpu *cpu;
+} mcs_node_t;
+
+/** Per-CPU set of MCS queue nodes */
+typedef struct mcs_cpu {
+	/** Bitmap of nodes in use */
+	atomic_t used;
+	mcs_node_t nodes[MCS_NODES];
+} mcs_cpu_t;
+
+/** MCS queue spinlock
+ *
+ * Each waiter spins on its own per-CPU queue node and is handed
+ * the lock by its predecessor, so waiters do not share a cache
+ * line and are served in FIFO order.
+ *
+ */
+typedef struct {
+	atomic_t tail;       /**< Last queued node, zero if unlocked */
+	mcs_node_t *holder;  /**< Queue node of the current owner */
+	
+#ifdef SPINLOCK_NAMED
+	const char *name;
+#endif /* SPINLOCK_NAMED */
+} spinlock_t;
+
+#define SPINLOCK_INITIALIZER_FIELDS \
+	.tail = { 0 }, \
+	.holder = NULL
+
+#else
+
 typedef struct {
 	atomic_t val;
 	
-#ifdef CONFIG_DEBUG_SPINLOCK
+#ifdef SPINLOCK_NAMED
 	const char *name;
-#endif /* CONFIG_DEBUG_SPINLOCK */
+#endif /* SPINLOCK_NAMED */
 } spinlock_t;
 
+#define SPINLOCK_INITIALIZER_FIELDS \
+	.val = { 0 }
+
+#endif
+
 /*
  * SPINLOCK_DECLARE is to be used for dynamically allocated spinlocks,
  * where the lock gets initialized in run time.
@@ -64,45 +154,62 @@ typedef struct {
  * for statically allocated spinlocks. They declare (either as global
  * or static) symbol and initialize the lock.
  */
-#ifdef CONFIG_DEBUG_SPINLOCK
+#ifdef SPINLOCK_NAMED
 
 #define SPINLOCK_INITIALIZE_NAME(lock_name, desc_name) \
 	spinlock_t lock_name = { \
 		.name = desc_name, \
-		.val = { 0 } \
+		SPINLOCK_INITIALIZER_FIELDS \
 	}
 
 #define SPINLOCK_STATIC_INITIALIZE_NAME(lock_name, desc_name) \
 	static spinlock_t lock_name = { \
 		.name = desc_name, \
-		.val = { 0 } \
+		SPINLOCK_INITIALIZER_FIELDS \
 	}
 
-#define ASSERT_SPINLOCK(expr, lock) \
-	ASSERT_VERBOSE(expr, (lock)->name)
-
-#define spinlock_lock(lock)    spinlock_lock_debug((lock))
-#define spinlock_unlock(lock)  spinlock_unlock_debug((lock))
-
-#else /* CONFIG_DEBUG_SPINLOCK */
+#else /* SPINLOCK_NAMED */
 
 #define SPINLOCK_INITIALIZE_NAME(lock_name, desc_name) \
 	spinlock_t lock_name = { \
-		.val = { 0 } \
+		SPINLOCK_INITIALIZER_FIELDS \
 	}
 
 #define SPINLOCK_STATIC_INITIALIZE_NAME(lock_name, desc_name) \
 	static spinlock_t lock_name = { \
-		.val = { 0 } \
+		SPINLOCK_INITIALIZER_FIELDS \
 	}
 
+#endif /* SPINLOCK_NAMED */
+
+#ifdef CONFIG_DEBUG_SPINLOCK
+
+#define ASSERT_SPINLOCK(expr, lock) \
+	ASSERT_VERBOSE(expr, (lock)->name)
+
+#else /* CONFIG_DEBUG_SPINLOCK */
+
 #define ASSERT_SPINLOCK(expr, lock) \
 	ASSERT(expr)
 
+#endif /* CONFIG_DEBUG_SPINLOCK */
+
+#if defined(SPINLOCK_QUEUED)
+
+#define spinlock_lock(lock)    spinlock_lock_queued((lock))
+#define spinlock_unlock(lock)  spinlock_unlock_queued((lock))
+
+#elif defined(SPINLOCK_NAMED)
+
+#define spinlock_lock(lock)    spinlock_lock_debug((lock))
+#define spinlock_unlock(lock)  spinlock_unlock_debug((lock))
+
+#else
+
 #define spinlock_lock(lock)    atomic_lock_arch(&(lock)->val)
 #define spinlock_unlock(lock)  spinlock_unlock_nondebug((lock))
 
-#endif /* CONFIG_DEBUG_SPINLOCK */
+#endif
 
 #define SPINLOCK_INITIALIZE(lock_name) \
 	SPINLOCK_INITIALIZE_NAME(lock_name, #lock_name)
@@ -114,8 +221,12 @@ extern void spinlock_initialize(spinlock_t *, const char *);
 extern int spinlock_trylock(spinlock_t *);
 extern void spinlock_lock_debug(spinlock_t *);
 extern void spinlock_unlock_debug(spinlock_t *);
+extern void spinlock_lock_queued(spinlock_t *);
+extern void spinlock_unlock_queued(spinlock_t *);
 extern bool spinlock_locked(spinlock_t *);
 
+#ifndef SPINLOCK_QUEUED
+
 /** Unlock spinlock
  *
  * Unlock spinlock for non-debug kernels.
@@ -134,6 +245,8 @@ NO_TRACE static inline void spinlock_unlock_nondebug(spinlock_t *lock)
 	preemption_enable();
 }
 
+#endif /* SPINLOCK_QUEUED */
+
 #ifdef CONFIG_DEBUG_SPINLOCK
 
 #include <log.h>
@@ -205,13 +318,13 @@ typedef struct {
  * for statically allocated interrupts-disabled spinlocks. They declare (either
  * as global or static symbol) and initialize the lock.
  */
-#ifdef CONFIG_DEBUG_SPINLOCK
+#ifdef SPINLOCK_NAMED
 
 #define IRQ_SPINLOCK_INITIALIZE_NAME(lock_name, desc_name) \
 	irq_spinlock_t lock_name = { \
 		.lock = { \
 			.name = desc_name, \
-			.val = { 0 } \
+			SPINLOCK_INITIALIZER_FIELDS \
 		}, \
 		.guard = false, \
 		.ipl = 0 \
@@ -221,18 +334,18 @@ typedef struct {
 	static irq_spinlock_t lock_name = { \
 		.lock = { \
 			.name = desc_name, \
-			.val = { 0 } \
+			SPINLOCK_INITIALIZER_FIELDS \
 		}, \
 		.guard = false, \
 		.ipl = 0 \
 	}
 
-#else /* CONFIG_DEBUG_SPINLOCK */
+#else /* SPINLOCK_NAMED */
 
 #define IRQ_SPINLOCK_INITIALIZE_NAME(lock_name, desc_name) \
 	irq_spinlock_t lock_name = { \
 		.lock = { \
-			.val = { 0 } \
+			SPINLOCK_INITIALIZER_FIELDS \
 		}, \
 		.guard = false, \
 		.ipl = 0 \
@@ -241,13 +354,13 @@ typedef struct {
 #define IRQ_SPINLOCK_STATIC_INITIALIZE_NAME(lock_name, desc_name) \
 	static irq_spinlock_t lock_name = { \
 		.lock = { \
-			.val = { 0 } \
+			SPINLOCK_INITIALIZER_FIELDS \
 		}, \
 		.guard = false, \
 		.ipl = 0 \
 	}
 
-#endif /* CONFIG_DEBUG_SPINLOCK */
+#endif /* SPINLOCK_NAMED */
 
 #else /* CONFIG_SMP */
 
@@ -39,17 +39,33 @@
 
 #define HZ  100
 
+/** Maximum number of ticks the clock interrupt can be deferred by. */
+#define CLOCK_TICKLESS_MAX  HZ
+
 /** Uptime structure */
 typedef struct {
 	sysarg_t seconds1;
 	sysarg_t useconds;
 	sysarg_t seconds2;
+	
+	/**
+	 * Conversion of cycle counter values to nanoseconds of the
+	 * monotonic clock, see cycles2ns(). Zero cycle_mult means
+	 * the cycle counter cannot be used as the clock source.
+	 */
+	uint32_t cycle_mult;
+	uint32_t cycle_shift;
+	uint64_t cycle_base;
 } uptime_t;
 
 extern uptime_t *uptime;
 
 extern void clock(void);
 extern void clock_counter_init(void);
+extern void clock_program(void);
+extern void clock_source_init(uint32_t);
+extern uint64_t cycles2ns(uint64_t);
+extern uint64_t clock_ns(void);
 
 #endif
 
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup time
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_WHEEL_H_
+#define KERN_WHEEL_H_
+
+#include <typedefs.h>
+#include <adt/list.h>
+
+/** Number of levels of the timeout wheel. */
+#define WHEEL_LEVELS  4
+
+/** Number of bits of the expiration tick used to index one level. */
+#define WHEEL_BITS   6
+#define WHEEL_SLOTS  (1 << WHEEL_BITS)
+#define WHEEL_MASK   (WHEEL_SLOTS - 1)
+
+/** Number of ticks covered by the given number of levels. */
+#define WHEEL_SPAN(levels)  (UINT64_C(1) << (WHEEL_BITS * (levels)))
+
+/** Hierarchical timeout wheel.
+ *
+ * Level 0 has a slot for each of the next WHEEL_SLOTS ticks. A slot
+ * of level l covers WHEEL_SLOTS^l ticks. Whenever the lower levels
+ * wrap around, the timeouts in the next slot of level l are moved to
+ * the lower levels.
+ *
+ */
+typedef struct {
+	/** Next tick to be processed. */
+	uint64_t now;
+	
+	/** Number of registered timeouts. */
+	size_t count;
+	
+	/**
+	 * Bitmaps of slots which might be non-empty. A bit may be
+	 * set for an empty slot after a timeout is unregistered.
+	 */
+	uint64_t map[WHEEL_LEVELS];
+	
+	/** Lists of timeouts. */
+	list_t slot[WHEEL_LEVELS][WHEEL_SLOTS];
+	
+	/**
+	 * Timeouts beyond the span of the wheel, moved to the wheel
+	 * whenever its top level wraps around.
+	 */
+	list_t overflow;
+} timeout_wheel_t;
+
+#endif
+
+/** @}
+ */
@@ -43,6 +43,7 @@
 #include <debug.h>
 #include <mm/slab.h>
 #include <memstr.h>
+#include <synch/rcu.h>
 
 /** Create chained hash table.
  *
@@ -97,6 +98,30 @@ void hash_table_insert(hash_table_t *h, sysarg_t key[], link_t *item)
 	list_append(item, &h->entry[chain]);
 }
 
+/** Insert item into hash table searched by RCU readers.
+ *
+ * The caller must still exclude other writers.
+ *
+ * @param h Hash table.
+ * @param key Array of all keys necessary to compute hash index.
+ * @param item Item to be inserted into the hash table.
+ */
+void hash_table_insert_rcu(hash_table_t *h, sysarg_t key[], link_t *item)
+{
+	size_t chain;
+	
+	ASSERT(item);
+	ASSERT(h);
+	ASSERT(h->op);
+	ASSERT(h->op->hash);
+	ASSERT(h->op->compare);
+	
+	chain = h->op->hash(key);
+	ASSERT(chain < h->entries);
+	
+	rcu_list_append(item, &h->entry[chain]);
+}
+
 /** Search hash table for an item matching keys.
  *
  * @param h Hash table.
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup genericadt
+ * @{
+ */
+
+/**
+ * @file
+ * @brief	Lock-free multi-producer single-consumer queue.
+ *
+ * See @ref mpsc.h for the description of the algorithm.
+ */
+
+#include <adt/mpsc.h>
+#include <atomic.h>
+#include <preemption.h>
+
+/** Initialize a queue
+ *
+ * @param queue Queue to be initialized.
+ *
+ */
+void mpsc_initialize(mpsc_queue_t *queue)
+{
+	queue->stub.next = NULL;
+	queue->tail = &queue->stub;
+	atomic_set(&queue->head, (atomic_count_t) (uintptr_t) &queue->stub);
+}
+
+/** Read the link following an item
+ *
+ * The items reachable through the returned link are guaranteed
+ * to be seen completely initialized.
+ *
+ * @param link Item whose successor is read.
+ *
+ * @return Next item or NULL.
+ *
+ */
+NO_TRACE static inline mpsc_link_t *mpsc_next(mpsc_link_t *link)
+{
+	mpsc_link_t *next = link->next;
+	if (next != NULL) {
+		/* Pairs with the release in mpsc_push(). */
+		atomic_acquire_barrier();
+	}
+	
+	return next;
+}
+
+/** Append an item to a queue
+ *
+ * Any number of threads and interrupt handlers can append
+ * items concurrently.
+ *
+ * @param queue Queue.
+ * @param link  Link of the item to be appended.
+ *
+ */
+void mpsc_push(mpsc_queue_t *queue, mpsc_link_t *link)
+{
+	link->next = NULL;
+	
+	/*
+	 * Keep the window in which the queue is cut in two short,
+	 * the consumer cannot get past it until we are done.
+	 */
+	preemption_disable();
+	
+	/* The item has to be complete before it becomes reachable. */
+	atomic_count_t prev = atomic_exchange_release(&queue->head,
+	    (atomic_count_t) (uintptr_t) link);
+	
+	((mpsc_link_t *) (uintptr_t) prev)->next = link;
+	
+	preemption_enable();
+}
+
+/** Remove the first item from a queue
+ *
+ * Only the consumer can call this function.
+ *
+ * @param queue Queue.
+ *
+ * @return Link of the removed item or NULL if the queue is empty
+ *         or the first item is just being appended.
+ *
+ */
+mpsc_link_t *mpsc_pop(mpsc_queue_t *queue)
+{
+	mpsc_link_t *tail = queue->tail;
+	mpsc_link_t *next = mpsc_next(tail);
+	
+	if (tail == &queue->stub) {
+		if (next == NULL)
+			return NULL;
+		
+		/* Skip the stub. */
+		queue->tail = next;
+		tail = next;
+		next = mpsc_next(next);
+	}
+	
+	if (next != NULL) {
+		queue->tail = next;
+		return tail;
+	}
+	
+	/*
+	 * The tail is the last item linked. Unless a producer is about
+	 * to link another item behind it, put the stub behind the tail
+	 * so that the tail can be removed.
+	 */
+	if (tail != (mpsc_link_t *) (uintptr_t) atomic_get(&queue->head))
+		return NULL;
+	
+	mpsc_push(queue, &queue->stub);
+	
+	next = mpsc_next(tail);
+	if (next != NULL) {
+		queue->tail = next;
+		return tail;
+	}
+	
+	return NULL;
+}
+
+/** @}
+ */
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup genericadt
+ * @{
+ */
+
+/**
+ * @file
+ * @brief	Bounded lock-free single-producer single-consumer ring.
+ *
+ * The ring is mostly implemented in @ref spsc.h.
+ */
+
+#include <adt/spsc.h>
+#include <mm/slab.h>
+#include <debug.h>
+
+/** Create a ring
+ *
+ * @param ring  Ring to be initialized.
+ * @param count Number of slots, must be a power of two.
+ * @param flags Flags for the allocation of the slots.
+ *
+ * @return False if the slots cannot be allocated.
+ *
+ */
+bool spsc_create(spsc_ring_t *ring, size_t count, unsigned int flags)
+{
+	ASSERT(count > 0);
+	ASSERT((count & (count - 1)) == 0);
+	
+	ring->slots = (void **) malloc(sizeof(void *) * count, flags);
+	if (!ring->slots)
+		return false;
+	
+	ring->cons.head = 0;
+	ring->cons.tail_cache = 0;
+	ring->prod.tail = 0;
+	ring->prod.head_cache = 0;
+	ring->mask = count - 1;
+	
+	return true;
+}
+
+/** Destroy a ring
+ *
+ * @param ring Ring to be destroyed.
+ *
+ */
+void spsc_destroy(spsc_ring_t *ring)
+{
+	ASSERT(ring->slots);
+	
+	free(ring->slots);
+	ring->slots = NULL;
+}
+
+/** @}
+ */
@@ -62,8 +62,11 @@
 #include <main/version.h>
 #include <mm/slab.h>
 #include <proc/scheduler.h>
+#include <proc/sched_trace.h>
+#include <synch/lockstat.h>
 #include <proc/thread.h>
 #include <proc/task.h>
+#include <time/clock.h>
 #include <sysinfo/sysinfo.h>
 #include <symtab.h>
 #include <errno.h>
@@ -466,6 +469,48 @@ static cmd_info_t sched_info = {
 	.argc = 0
 };
 
+static int cmd_rtbandwidth(cmd_arg_t *argv);
+static cmd_arg_t rtbandwidth_argv = {
+	.type = ARG_TYPE_INT,
+};
+static cmd_info_t rtbandwidth_info = {
+	.name = "rtbandwidth",
+	.description = "<percent> Set CPU bandwidth of real-time threads.",
+	.func = cmd_rtbandwidth,
+	.argc = 1,
+	.argv = &rtbandwidth_argv
+};
+
+static int cmd_schedtrace(cmd_arg_t *argv);
+static cmd_arg_t schedtrace_argv = {
+	.type = ARG_TYPE_STRING_OPTIONAL,
+	.buffer = flag_buf,
+	.len = sizeof(flag_buf)
+};
+static cmd_info_t schedtrace_info = {
+	.name = "schedtrace",
+	.description = "Dump scheduler trace (use on/off to start/stop tracing).",
+	.func = cmd_schedtrace,
+	.argc = 1,
+	.argv = &schedtrace_argv
+};
+
+#ifdef CONFIG_LOCKSTAT
+static int cmd_lockstat(cmd_arg_t *argv);
+static cmd_arg_t lockstat_argv = {
+	.type = ARG_TYPE_STRING_OPTIONAL,
+	.buffer = flag_buf,
+	.len = sizeof(flag_buf)
+};
+static cmd_info_t lockstat_info = {
+	.name = "lockstat",
+	.description = "Print contended locks (use -a for all locks, reset to clear).",
+	.func = cmd_lockstat,
+	.argc = 1,
+	.argv = &lockstat_argv
+};
+#endif
+
 static int cmd_slabs(cmd_arg_t *argv);
 static cmd_info_t slabs_info = {
 	.name = "slabs",
@@ -552,9 +597,14 @@ static cmd_info_t *basic_commands[] = {
 	&halt_info,
 	&help_info,
 	&kill_info,
+#ifdef CONFIG_LOCKSTAT
+	&lockstat_info,
+#endif
 	&physmem_info,
 	&reboot_info,
+	&rtbandwidth_info,
 	&sched_info,
+	&schedtrace_info,
 	&set4_info,
 	&slabs_info,
 	&symaddr_info,
@@ -617,7 +667,7 @@ void cmd_init(void)
  */
 int cmd_help(cmd_arg_t *argv)
 {
-	spinlock_lock(&cmd_lock);
+	rwlock_read_lock(&cmd_lock);
 	
 	size_t len = 0;
 	list_foreach(cmd_list, link, cmd_info_t, hlp) {
@@ -630,6 +680,7 @@ int cmd_help(cmd_arg_t *argv)
 	unsigned int _len = (unsigned int) len;
 	if ((_len != len) || (((int) _len) < 0)) {
 		log(LF_OTHER, LVL_ERROR, "Command length overflow");
+		rwlock_read_unlock(&cmd_lock);
 		return 1;
 	}
 	
@@ -639,7 +690,7 @@ int cmd_help(cmd_arg_t *argv)
 		spinlock_unlock(&hlp->lock);
 	}
 	
-	spinlock_unlock(&cmd_lock);
+	rwlock_read_unlock(&cmd_lock);
 	
 	return 1;
 }
@@ -868,7 +919,7 @@ int cmd_uptime(cmd_arg_t *argv)
  */
 int cmd_desc(cmd_arg_t *argv)
 {
-	spinlock_lock(&cmd_lock);
+	rwlock_read_lock(&cmd_lock);
 	
 	list_foreach(cmd_list, link, cmd_info_t, hlp) {
 		spinlock_lock(&hlp->lock);
@@ -884,7 +935,7 @@ int cmd_desc(cmd_arg_t *argv)
 		spinlock_unlock(&hlp->lock);
 	}
 	
-	spinlock_unlock(&cmd_lock);	
+	rwlock_read_unlock(&cmd_lock);	
 	
 	return 1;
 }
@@ -1218,6 +1269,64 @@ int cmd_sched(cmd_arg_t *argv)
 	return 1;
 }
 
+/** Command for setting the real-time bandwidth
+ *
+ * @param argv Integer argument from cmdline expected
+ *
+ * @return Always 1
+ */
+int cmd_rtbandwidth(cmd_arg_t *argv)
+{
+	rt_bandwidth_set(argv[0].intval);
+	printf("Real-time bandwidth: %u%%\n", rt_bandwidth_get());
+	return 1;
+}
+
+/** Command for controlling the scheduler trace
+ *
+ * @param argv Ignored
+ *
+ * @return Always 1
+ */
+int cmd_schedtrace(cmd_arg_t *argv)
+{
+	if (str_cmp(flag_buf, "on") == 0) {
+		if (!sched_trace_enable())
+			printf("Unable to allocate the trace buffers.\n");
+	} else if (str_cmp(flag_buf, "off") == 0)
+		sched_trace_disable();
+	else if (str_cmp(flag_buf, "") == 0)
+		sched_trace_print();
+	else
+		printf("Unknown argument \"%s\".\n", flag_buf);
+	
+	return 1;
+}
+
+#ifdef CONFIG_LOCKSTAT
+
+/** Command for printing lock contention statistics
+ *
+ * @param argv Ignored
+ *
+ * @return Always 1
+ */
+int cmd_lockstat(cmd_arg_t *argv)
+{
+	if (str_cmp(flag_buf, "-a") == 0)
+		lockstat_print(true);
+	else if (str_cmp(flag_buf, "reset") == 0)
+		lockstat_reset();
+	else if (str_cmp(flag_buf, "") == 0)
+		lockstat_print(false);
+	else
+		printf("Unknown argument \"%s\".\n", flag_buf);
+	
+	return 1;
+}
+
+#endif
+
 /** Command for listing memory zones
  *
  * @param argv Ignored
@@ -1306,24 +1415,28 @@ static bool run_test(const test_t *test)
 	uint64_t ucycles0, kcycles0;
 	task_get_accounting(TASK, &ucycles0, &kcycles0);
 	irq_spinlock_unlock(&TASK->lock, true);
+	uint64_t ns0 = clock_ns();
 	
 	/* Execute the test */
 	test_quiet = false;
 	const char *ret = test->entry();
 	
 	/* Update and read thread accounting */
+	uint64_t ns1 = clock_ns();
 	uint64_t ucycles1, kcycles1;
 	irq_spinlock_lock(&TASK->lock, true);
 	task_get_accounting(TASK, &ucycles1, &kcycles1);
 	irq_spinlock_unlock(&TASK->lock, true);
 	
-	uint64_t ucycles, kcycles;
-	char usuffix, ksuffix;
+	uint64_t ucycles, kcycles, ns;
+	char usuffix, ksuffix, nsuffix;
 	order_suffix(ucycles1 - ucycles0, &ucycles, &usuffix);
 	order_suffix(kcycles1 - kcycles0, &kcycles, &ksuffix);
+	order_suffix(ns1 - ns0, &ns, &nsuffix);
 	
-	printf("Time: %" PRIu64 "%c user cycles, %" PRIu64 "%c kernel cycles\n",
-	    ucycles, usuffix, kcycles, ksuffix);
+	printf("Time: %" PRIu64 "%c user cycles, %" PRIu64 "%c kernel cycles, "
+	    "%" PRIu64 "%c ns elapsed\n", ucycles, usuffix, kcycles, ksuffix,
+	    ns, nsuffix);
 	
 	if (ret == NULL) {
 		printf("Test passed\n");
@@ -1338,8 +1451,8 @@ static bool run_bench(const test_t *test, const uint32_t cnt)
 {
 	uint32_t i;
 	bool ret = true;
-	uint64_t ucycles, kcycles;
-	char usuffix, ksuffix;
+	uint64_t ucycles, kcycles, ns;
+	char usuffix, ksuffix, nsuffix;
 	
 	if (cnt < 1)
 		return true;
@@ -1359,12 +1472,14 @@ static bool run_bench(const test_t *test, const uint32_t cnt)
 		uint64_t ucycles0, kcycles0;
 		task_get_accounting(TASK, &ucycles0, &kcycles0);
 		irq_spinlock_unlock(&TASK->lock, true);
+		uint64_t ns0 = clock_ns();
 		
 		/* Execute the test */
 		test_quiet = true;
 		const char *test_ret = test->entry();
 		
 		/* Update and read thread accounting */
+		uint64_t ns1 = clock_ns();
 		irq_spinlock_lock(&TASK->lock, true);
 		uint64_t ucycles1, kcycles1;
 		task_get_accounting(TASK, &ucycles1, &kcycles1);
@@ -1379,8 +1494,10 @@ static bool run_bench(const test_t *test, const uint32_t cnt)
 		data[i] = ucycles1 - ucycles0 + kcycles1 - kcycles0;
 		order_suffix(ucycles1 - ucycles0, &ucycles, &usuffix);
 		order_suffix(kcycles1 - kcycles0, &kcycles, &ksuffix);
-		printf("OK (%" PRIu64 "%c user cycles, %" PRIu64 "%c kernel cycles)\n",
-		    ucycles, usuffix, kcycles, ksuffix);
+		order_suffix(ns1 - ns0, &ns, &nsuffix);
+		printf("OK (%" PRIu64 "%c user cycles, %" PRIu64 "%c kernel cycles, "
+		    "%" PRIu64 "%c ns)\n", ucycles, usuffix, kcycles, ksuffix,
+		    ns, nsuffix);
 	}
 	
 	if (ret) {
@@ -70,9 +70,10 @@
 /** Locking.
  *
  * There is a list of cmd_info_t structures. This list
- * is protected by cmd_lock spinlock. Note that specially
- * the link elements of cmd_info_t are protected by
- * this lock.
+ * is protected by cmd_lock reader-writer lock, which is
+ * only locked for writing when a command is registered.
+ * Note that specially the link elements of cmd_info_t
+ * are protected by this lock.
  *
  * Each cmd_info_t also has its own lock, which protects
  * all elements thereof except the link element.
@@ -82,7 +83,7 @@
  * lower address must be locked first.
  */
 
-SPINLOCK_INITIALIZE(cmd_lock);  /**< Lock protecting command list. */
+rwlock_t cmd_lock;              /**< Lock protecting command list. */
 LIST_INITIALIZE(cmd_list);      /**< Command list. */
 
 static wchar_t history[KCONSOLE_HISTORY][MAX_CMDLINE] = {};
@@ -98,6 +99,12 @@ void kconsole_init(void)
 {
 	unsigned int i;
 	
+	/*
+	 * The command list is searched with a cmd_info lock held,
+	 * so the lock must not sleep.
+	 */
+	rwlock_initialize(&cmd_lock, MUTEX_ACTIVE);
+	
 	cmd_init();
 	for (i = 0; i < KCONSOLE_HISTORY; i++)
 		history[i][0] = 0;
@@ -112,7 +119,7 @@ void kconsole_init(void)
  */
 bool cmd_register(cmd_info_t *cmd)
 {
-	spinlock_lock(&cmd_lock);
+	rwlock_write_lock(&cmd_lock);
 	
 	/*
 	 * Make sure the command is not already listed.
@@ -120,7 +127,7 @@ bool cmd_register(cmd_info_t *cmd)
 	list_foreach(cmd_list, link, cmd_info_t, hlp) {
 		if (hlp == cmd) {
 			/* The command is already there. */
-			spinlock_unlock(&cmd_lock);
+			rwlock_write_unlock(&cmd_lock);
 			return false;
 		}
 		
@@ -137,7 +144,7 @@ bool cmd_register(cmd_info_t *cmd)
 			/* The command is already there. */
 			spinlock_unlock(&hlp->lock);
 			spinlock_unlock(&cmd->lock);
-			spinlock_unlock(&cmd_lock);
+			rwlock_write_unlock(&cmd_lock);
 			return false;
 		}
 		
@@ -150,7 +157,7 @@ bool cmd_register(cmd_info_t *cmd)
 	 */
 	list_append(&cmd->link, &cmd_list);
 	
-	spinlock_unlock(&cmd_lock);
+	rwlock_write_unlock(&cmd_lock);
 	return true;
 }
 
@@ -168,7 +175,7 @@ NO_TRACE static const char *cmdtab_search_one(const char *name,
 {
 	size_t namelen = str_length(name);
 	
-	spinlock_lock(&cmd_lock);
+	rwlock_read_lock(&cmd_lock);
 	
 	if (*startpos == NULL)
 		*startpos = cmd_list.head.next;
@@ -181,12 +188,12 @@ NO_TRACE static const char *cmdtab_search_one(const char *name,
 			continue;
 		
 		if (str_lcmp(curname, name, namelen) == 0) {
-			spinlock_unlock(&cmd_lock);
+			rwlock_read_unlock(&cmd_lock);
 			return (curname + str_lsize(curname, namelen));
 		}
 	}
 	
-	spinlock_unlock(&cmd_lock);
+	rwlock_read_unlock(&cmd_lock);
 	return NULL;
 }
 
@@ -605,7 +612,7 @@ NO_TRACE static cmd_info_t *parse_cmdline(const char *cmdline, size_t size)
 		/* Command line did not contain alphanumeric word. */
 		return NULL;
 	}
-	spinlock_lock(&cmd_lock);
+	rwlock_read_lock(&cmd_lock);
 	
 	cmd_info_t *cmd = NULL;
 	
@@ -622,7 +629,7 @@ NO_TRACE static cmd_info_t *parse_cmdline(const char *cmdline, size_t size)
 		spinlock_unlock(&hlp->lock);
 	}
 	
-	spinlock_unlock(&cmd_lock);
+	rwlock_read_unlock(&cmd_lock);
 	
 	if (!cmd) {
 		/* Unknown command. */
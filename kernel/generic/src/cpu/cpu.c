@@ -36,6 +36,7 @@
  */
 
 #include <cpu.h>
+#include <cpu_mask.h>
 #include <arch.h>
 #include <arch/cpu.h>
 #include <mm/slab.h>
@@ -62,6 +63,9 @@ void cpu_init(void) {
 	if (config.cpu_active == 1) {
 #endif /* CONFIG_SMP */
 		
+		if (config.cpu_count > CPU_MASK_MAX)
+			panic("Too many CPUs (%u).", config.cpu_count);
+		
 		cpus = (cpu_t *) malloc(sizeof(cpu_t) * config.cpu_count,
 		    FRAME_ATOMIC);
 		if (!cpus)
@@ -81,11 +85,26 @@ void cpu_init(void) {
 			cpus[i].id = i;
 			
 			irq_spinlock_initialize(&cpus[i].lock, "cpus[].lock");
+			spinlock_initialize(&cpus[i].rq_map_lock,
+			    "cpus[].rq_map_lock");
 			
 			for (unsigned int j = 0; j < RQ_COUNT; j++) {
 				irq_spinlock_initialize(&cpus[i].rq[j].lock, "cpus[].rq[].lock");
 				list_initialize(&cpus[i].rq[j].rq);
 			}
+			
+			irq_spinlock_initialize(&cpus[i].fairq.lock,
+			    "cpus[].fairq.lock");
+			avltree_create(&cpus[i].fairq.tree);
+			
+			irq_spinlock_initialize(&cpus[i].rtq.lock,
+			    "cpus[].rtq.lock");
+			for (unsigned int j = 0; j < RT_COUNT; j++)
+				list_initialize(&cpus[i].rtq.rq[j]);
+			cpus[i].rtq.current = RT_COUNT;
+			
+			rcu_cpu_init(&cpus[i].rcu);
+			work_cpu_init(&cpus[i].work);
 		}
 		
 #ifdef CONFIG_SMP
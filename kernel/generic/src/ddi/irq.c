@@ -72,6 +72,7 @@
 #include <mm/slab.h>
 #include <typedefs.h>
 #include <synch/spinlock.h>
+#include <synch/rcu.h>
 #include <console/console.h>
 #include <interrupt.h>
 #include <memstr.h>
@@ -80,7 +81,11 @@
 #define KEY_INR    0
 #define KEY_DEVNO  1
 
-/** Spinlock protecting the kernel IRQ hash table.
+/** Spinlock serialising updates of the kernel IRQ hash table.
+ *
+ * Lookups are done under RCU protection only. Kernel IRQ
+ * structures are never unregistered, so they need not be
+ * reclaimed.
  *
  * This lock must be taken only when interrupts are disabled.
  *
@@ -190,7 +195,7 @@ void irq_register(irq_t *irq)
 	
 	irq_spinlock_lock(&irq_kernel_hash_table_lock, true);
 	irq_spinlock_lock(&irq->lock, false);
-	hash_table_insert(&irq_kernel_hash_table, key, &irq->link);
+	hash_table_insert_rcu(&irq_kernel_hash_table, key, &irq->link);
 	irq_spinlock_unlock(&irq->lock, false);
 	irq_spinlock_unlock(&irq_kernel_hash_table_lock, true);
 }
@@ -206,14 +211,12 @@ static irq_t *irq_dispatch_and_lock_kernel(inr_t inr)
 		(sysarg_t) -1    /* Search will use claim() instead of devno */
 	};
 	
-	irq_spinlock_lock(&irq_kernel_hash_table_lock, false);
+	rcu_read_lock();
 	lnk = hash_table_find(&irq_kernel_hash_table, key);
-	if (lnk) {
-		irq_t *irq = hash_table_get_instance(lnk, irq_t, link);
-		irq_spinlock_unlock(&irq_kernel_hash_table_lock, false);
-		return irq;
-	}
-	irq_spinlock_unlock(&irq_kernel_hash_table_lock, false);
+	rcu_read_unlock();
+	
+	if (lnk)
+		return hash_table_get_instance(lnk, irq_t, link);
 	
 	return NULL;
 }
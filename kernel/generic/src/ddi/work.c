@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup genericddi
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Deferred work for interrupt handlers.
+ *
+ * Interrupt handlers run with interrupts disabled and the IRQ
+ * spinlock held, so they should only talk to the device and leave
+ * the rest of the processing to a thread. A handler queues a work
+ * item on the current CPU and the worker thread of the CPU calls
+ * the work function later with interrupts enabled.
+ *
+ * Queueing an item which is already queued does nothing, so an item
+ * queued by a device interrupting at a high rate is processed once for
+ * a whole burst of interrupts. The worker thread drains all the queued
+ * items before it goes to sleep again.
+ *
+ * Items are only queued on the current CPU with preemption disabled,
+ * so all producers of a per-CPU queue run on the CPU of its consumer.
+ * A work item can still be queued on another CPU while its function
+ * is running, hence work functions have to synchronize with
+ * themselves if they can run on more CPUs.
+ */
+
+#include <ddi/work.h>
+#include <proc/thread.h>
+#include <preemption.h>
+#include <atomic.h>
+#include <config.h>
+#include <arch.h>
+#include <cpu.h>
+#include <debug.h>
+#include <panic.h>
+
+/** Initialize a work item
+ *
+ * @param work Work item.
+ * @param func Function to be called by the worker thread.
+ * @param arg  Argument of the function.
+ *
+ */
+void work_initialize(work_t *work, work_func_t func, void *arg)
+{
+	atomic_set(&work->pending, 0);
+	work->func = func;
+	work->arg = arg;
+}
+
+/** Queue a work item on the current CPU
+ *
+ * Can be called from interrupt handlers.
+ *
+ * @param work Work item.
+ *
+ * @return False if the item has already been queued and not
+ *         yet picked up by the worker thread.
+ *
+ */
+bool work_queue(work_t *work)
+{
+	if (!atomic_cas(&work->pending, 0, 1))
+		return false;
+	
+	preemption_disable();
+	ASSERT(CPU);
+	
+	work_cpu_t *wcpu = &CPU->work;
+	mpsc_push(&wcpu->queue, &work->link);
+	
+	/*
+	 * A running worker thread picks the item up before it goes
+	 * to sleep, this producer cannot run in between as it is
+	 * on the same CPU.
+	 */
+	if (!wcpu->running)
+		waitq_wakeup(&wcpu->wq, WAKEUP_FIRST);
+	
+	preemption_enable();
+	return true;
+}
+
+/** Initialize per-CPU deferred work state
+ *
+ * @param wcpu Per-CPU state.
+ *
+ */
+void work_cpu_init(work_cpu_t *wcpu)
+{
+	mpsc_initialize(&wcpu->queue);
+	waitq_initialize(&wcpu->wq);
+	wcpu->running = false;
+	wcpu->items = 0;
+	wcpu->batches = 0;
+}
+
+/** Worker thread of a CPU
+ *
+ * @param arg Per-CPU state of the CPU the thread is wired to.
+ *
+ */
+static void work_thread(void *arg)
+{
+	work_cpu_t *wcpu = (work_cpu_t *) arg;
+	
+	thread_detach(THREAD);
+	
+	while (true) {
+		wcpu->running = true;
+		
+		mpsc_link_t *link;
+		while ((link = mpsc_pop(&wcpu->queue)) != NULL) {
+			work_t *work = mpsc_get_instance(link, work_t, link);
+			
+			/* The item may be queued again from now on. */
+			atomic_set(&work->pending, 0);
+			work->func(work->arg);
+			wcpu->items++;
+		}
+		
+		wcpu->batches++;
+		wcpu->running = false;
+		
+		/* Items queued while we were still running did not wake us up. */
+		if (!mpsc_empty(&wcpu->queue))
+			continue;
+		
+		waitq_sleep(&wcpu->wq);
+	}
+}
+
+/** Start the worker threads
+ *
+ * Items queued before the worker threads start are
+ * processed as soon as the threads run.
+ *
+ */
+void work_init(void)
+{
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		if (!cpus[i].active)
+			continue;
+		
+		thread_t *thread = thread_create(work_thread, &cpus[i].work,
+		    TASK, THREAD_FLAG_RT_FIFO | THREAD_FLAG_RT_PRIORITY(0),
+		    "work");
+		if (thread == NULL)
+			panic("Unable to create work thread.");
+		
+		thread_wire(thread, &cpus[i]);
+		thread_ready(thread);
+	}
+}
+
+/** @}
+ */
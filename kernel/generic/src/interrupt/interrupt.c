@@ -52,6 +52,7 @@
 #include <stdarg.h>
 #include <symtab.h>
 #include <proc/thread.h>
+#include <proc/scheduler.h>
 #include <arch/cycle.h>
 #include <arch/stack.h>
 #include <str.h>
@@ -141,6 +142,9 @@ NO_TRACE void exc_dispatch(unsigned int n, istate_t *istate)
 		THREAD->last_cycle = end_cycle;
 		irq_spinlock_unlock(&THREAD->lock, false);
 	}
+	
+	/* A real-time thread made ready by the handler runs right away */
+	scheduler_preempt();
 }
 
 /** Default 'null' exception handler
@@ -203,7 +203,15 @@ int load_segment(elf_segment_header_t *entry, elf_header_t *elf, as_t *as)
 		    (entry->p_vaddr % entry->p_align))
 			return EE_INVALID;
 	}
-	
+
+	/*
+	 * The segment is mapped from the image page by page by
+	 * elf_page_fault(), so it must start at the same offset
+	 * within a page both in the image and in memory.
+	 */
+	if ((entry->p_offset % PAGE_SIZE) != (entry->p_vaddr % PAGE_SIZE))
+		return EE_UNSUPPORTED;
+
 	unsigned int flags = 0;
 	
 	if (entry->p_flags & PF_X)
@@ -42,6 +42,9 @@
 #include <lib/memfnc.h>
 #include <typedefs.h>
 
+/** Machine word which can alias any other type. */
+typedef sysarg_t word_t __attribute__((may_alias));
+
 /** Fill block of memory.
  *
  * Fill cnt bytes at dst address with the value val.
@@ -80,6 +83,37 @@ void *memcpy(void *dst, const void *src, size_t cnt)
 	uint8_t *dp = (uint8_t *) dst;
 	const uint8_t *sp = (uint8_t *) src;
 	
+	/*
+	 * If the source and the destination can be both word aligned
+	 * at the same time, copy the unaligned head byte by byte and
+	 * the bulk of the block word by word.
+	 */
+	if ((((uintptr_t) dp ^ (uintptr_t) sp) & (sizeof(word_t) - 1)) == 0) {
+		while ((cnt != 0) &&
+		    (((uintptr_t) dp & (sizeof(word_t) - 1)) != 0)) {
+			*dp++ = *sp++;
+			cnt--;
+		}
+		
+		word_t *wdp = (word_t *) dp;
+		const word_t *wsp = (const word_t *) sp;
+		
+		for (; cnt >= 4 * sizeof(word_t); cnt -= 4 * sizeof(word_t)) {
+			wdp[0] = wsp[0];
+			wdp[1] = wsp[1];
+			wdp[2] = wsp[2];
+			wdp[3] = wsp[3];
+			wdp += 4;
+			wsp += 4;
+		}
+		
+		for (; cnt >= sizeof(word_t); cnt -= sizeof(word_t))
+			*wdp++ = *wsp++;
+		
+		dp = (uint8_t *) wdp;
+		sp = (const uint8_t *) wsp;
+	}
+	
 	while (cnt-- != 0)
 		*dp++ = *sp++;
 	
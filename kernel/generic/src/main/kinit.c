@@ -75,6 +75,8 @@
 
 #include <synch/waitq.h>
 #include <synch/spinlock.h>
+#include <synch/rcu.h>
+#include <ddi/work.h>
 
 #define ALIVE_CHARS  4
 
@@ -110,9 +112,7 @@ void kinit(void *arg)
 		
 		/*
 		 * Create the kmp thread and wait for its completion.
-		 * cpu1 through cpuN-1 will come up consecutively and
-		 * not mess together with kcpulb threads.
-		 * Just a beautification.
+		 * cpu1 through cpuN-1 will come up consecutively.
 		 */
 		thread = thread_create(kmp, NULL, TASK,
 		    THREAD_FLAG_UNCOUNTED, "kmp");
@@ -124,22 +124,6 @@ void kinit(void *arg)
 		
 		thread_join(thread);
 		thread_detach(thread);
-		
-		/*
-		 * For each CPU, create its load balancing thread.
-		 */
-		unsigned int i;
-		
-		for (i = 0; i < config.cpu_count; i++) {
-			thread = thread_create(kcpulb, NULL, TASK,
-			    THREAD_FLAG_UNCOUNTED, "kcpulb");
-			if (thread != NULL) {
-				thread_wire(thread, &cpus[i]);
-				thread_ready(thread);
-			} else
-				log(LF_OTHER, LVL_ERROR,
-				    "Unable to create kcpulb thread for cpu%u", i);
-		}
 	}
 #endif /* CONFIG_SMP */
 	
@@ -148,6 +132,17 @@ void kinit(void *arg)
 	 */
 	arch_post_smp_init();
 	
+	/* Start threads processing deferred work of interrupt handlers */
+	work_init();
+	
+	/* Start thread reclaiming RCU protected data */
+	thread = thread_create(rcu_reclaimer, NULL, TASK, THREAD_FLAG_NONE,
+	    "rcu");
+	if (thread != NULL)
+		thread_ready(thread);
+	else
+		panic("Unable to create rcu thread.");
+	
 	/* Start thread computing system load */
 	thread = thread_create(kload, NULL, TASK, THREAD_FLAG_NONE,
 	    "kload");
@@ -57,6 +57,8 @@
 #include <proc/scheduler.h>
 #include <proc/thread.h>
 #include <proc/task.h>
+#include <proc/sched_trace.h>
+#include <synch/lockstat.h>
 #include <main/kinit.h>
 #include <main/version.h>
 #include <console/kconsole.h>
@@ -75,6 +77,7 @@
 #include <mm/reserve.h>
 #include <synch/waitq.h>
 #include <synch/futex.h>
+#include <synch/rcu.h>
 #include <arch/arch.h>
 #include <arch.h>
 #include <arch/faddr.h>
@@ -268,6 +271,7 @@ void main_bsp_separated_stack(void)
 	task_init();
 	thread_init();
 	futex_init();
+	rcu_init();
 	
 	if (init.cnt > 0) {
 		size_t i;
@@ -280,6 +284,10 @@ void main_bsp_separated_stack(void)
 	kio_init();
 	log_init();
 	stats_init();
+	sched_trace_init();
+#ifdef CONFIG_LOCKSTAT
+	lockstat_init();
+#endif
 	
 	/*
 	 * Create kernel task.
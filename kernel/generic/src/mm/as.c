@@ -52,6 +52,7 @@
 #include <mm/frame.h>
 #include <mm/slab.h>
 #include <mm/tlb.h>
+#include <mm/copy.h>
 #include <arch/mm/page.h>
 #include <genarch/mm/page_pt.h>
 #include <genarch/mm/page_ht.h>
@@ -124,6 +125,25 @@ NO_TRACE static size_t as_destructor(void *obj)
 	return as_destructor_arch((as_t *) obj);
 }
 
+/** Adjust an address space page counter.
+ *
+ * All modifications are serialized by the address space mutex,
+ * the counter itself only needs to be atomic for the readers
+ * which do not take the mutex.
+ *
+ * @param as      Address space owning the counter.
+ * @param counter Counter to adjust.
+ * @param delta   Number of pages to add (or subtract if negative).
+ *
+ */
+NO_TRACE static void as_pages_adjust(as_t *as, atomic_t *counter,
+    ssize_t delta)
+{
+	ASSERT(mutex_locked(&as->lock));
+	
+	atomic_set(counter, atomic_get(counter) + delta);
+}
+
 /** Initialize address space subsystem. */
 void as_init(void)
 {
@@ -163,6 +183,8 @@ as_t *as_create(unsigned int flags)
 	
 	atomic_set(&as->refcount, 0);
 	as->cpu_refcount = 0;
+	atomic_set(&as->virt_pages, 0);
+	atomic_set(&as->resident_pages, 0);
 	
 #ifdef AS_PAGE_TABLE
 	as->genarch.page_table = page_table_create(flags);
@@ -676,6 +698,7 @@ as_area_t *as_area_create(as_t *as, unsigned int flags, size_t size,
 	btree_create(&area->used_space);
 	btree_insert(&as->as_area_btree, *base, (void *) area,
 	    NULL);
+	as_pages_adjust(as, &as->virt_pages, pages);
 	
 	mutex_unlock(&as->lock);
 	
@@ -745,6 +768,34 @@ NO_TRACE static as_area_t *find_area_and_lock(as_t *as, uintptr_t va)
 	return NULL;
 }
 
+/** Argument of area_frame_release(). */
+typedef struct {
+	/** Address space area whose pages are being unmapped. */
+	as_area_t *area;
+	/** Frames released by the area backend. */
+	frame_batch_t batch;
+} area_release_t;
+
+/** Release a frame of an address space area being unmapped.
+ *
+ * Callback for page_mapping_remove_range(). The frame is handed over to
+ * the area backend, which adds it to the frame batch if it should be freed.
+ *
+ * @param arg   Pointer to area_release_t.
+ * @param page  Virtual page that was mapped to the frame.
+ * @param frame Frame to be released.
+ *
+ */
+NO_TRACE static void area_frame_release(void *arg, uintptr_t page,
+    uintptr_t frame)
+{
+	area_release_t *release = (area_release_t *) arg;
+	as_area_t *area = release->area;
+	
+	if ((area->backend) && (area->backend->frame_free))
+		area->backend->frame_free(area, page, frame, &release->batch);
+}
+
 /** Find address space area and change it.
  *
  * @param as      Address space.
@@ -813,6 +864,11 @@ int as_area_resize(as_t *as, uintptr_t address, size_t size, unsigned int flags)
 		 * No need to check for overlaps.
 		 */
 		
+		area_release_t release = {
+			.area = area
+		};
+		frame_batch_initialize(&release.batch);
+		
 		page_table_lock(as, false);
 		
 		/*
@@ -885,23 +941,8 @@ int as_area_resize(as_t *as, uintptr_t address, size_t size, unsigned int flags)
 				    as->asid, area->base + P2SZ(pages),
 				    area->pages - pages);
 		
-				for (; i < size; i++) {
-					pte_t *pte = page_mapping_find(as,
-					    ptr + P2SZ(i), false);
-					
-					ASSERT(pte);
-					ASSERT(PTE_VALID(pte));
-					ASSERT(PTE_PRESENT(pte));
-					
-					if ((area->backend) &&
-					    (area->backend->frame_free)) {
-						area->backend->frame_free(area,
-						    ptr + P2SZ(i),
-						    PTE_GET_FRAME(pte));
-					}
-					
-					page_mapping_remove(as, ptr + P2SZ(i));
-				}
+				page_mapping_remove_range(as, ptr + P2SZ(i),
+				    size - i, area_frame_release, &release);
 		
 				/*
 				 * Finish TLB shootdown sequence.
@@ -919,6 +960,11 @@ int as_area_resize(as_t *as, uintptr_t address, size_t size, unsigned int flags)
 				    area->base + P2SZ(pages),
 				    area->pages - pages);
 				tlb_shootdown_finalize(ipl);
+				
+				/*
+				 * Free frames still held in the batch.
+				 */
+				frame_batch_flush(&release.batch);
 			}
 		}
 		page_table_unlock(as, false);
@@ -949,6 +995,8 @@ int as_area_resize(as_t *as, uintptr_t address, size_t size, unsigned int flags)
 		}
 	}
 	
+	as_pages_adjust(as, &as->virt_pages,
+	    (ssize_t) pages - (ssize_t) area->pages);
 	area->pages = pages;
 	
 	mutex_unlock(&area->lock);
@@ -980,6 +1028,11 @@ int as_area_destroy(as_t *as, uintptr_t address)
 	
 	uintptr_t base = area->base;
 	
+	area_release_t release = {
+		.area = area
+	};
+	frame_batch_initialize(&release.batch);
+	
 	page_table_lock(as, false);
 	
 	/*
@@ -989,33 +1042,17 @@ int as_area_destroy(as_t *as, uintptr_t address)
 	    area->pages);
 	
 	/*
-	 * Visit only the pages mapped by used_space B+tree.
+	 * Visit only the pages mapped by used_space B+tree. Each interval
+	 * of used space is unmapped at once.
 	 */
 	list_foreach(area->used_space.leaf_list, leaf_link, btree_node_t,
 	    node) {
 		btree_key_t i;
 		
 		for (i = 0; i < node->keys; i++) {
-			uintptr_t ptr = node->key[i];
-			size_t size;
-			
-			for (size = 0; size < (size_t) node->value[i]; size++) {
-				pte_t *pte = page_mapping_find(as,
-				     ptr + P2SZ(size), false);
-				
-				ASSERT(pte);
-				ASSERT(PTE_VALID(pte));
-				ASSERT(PTE_PRESENT(pte));
-				
-				if ((area->backend) &&
-				    (area->backend->frame_free)) {
-					area->backend->frame_free(area,
-					    ptr + P2SZ(size),
-					    PTE_GET_FRAME(pte));
-				}
-				
-				page_mapping_remove(as, ptr + P2SZ(size));
-			}
+			page_mapping_remove_range(as, node->key[i],
+			    (size_t) node->value[i], area_frame_release,
+			    &release);
 		}
 	}
 	
@@ -1032,10 +1069,18 @@ int as_area_destroy(as_t *as, uintptr_t address)
 	as_invalidate_translation_cache(as, area->base, area->pages);
 	tlb_shootdown_finalize(ipl);
 	
+	/*
+	 * Free frames still held in the batch.
+	 */
+	frame_batch_flush(&release.batch);
+	
 	page_table_unlock(as, false);
 	
 	btree_destroy(&area->used_space);
 	
+	as_pages_adjust(as, &as->virt_pages, -(ssize_t) area->pages);
+	as_pages_adjust(as, &as->resident_pages, -(ssize_t) area->resident);
+	
 	area->attributes |= AS_AREA_ATTR_PARTIAL;
 	
 	sh_info_remove_reference(area->sh_info);
@@ -1229,6 +1274,31 @@ NO_TRACE static unsigned int area_flags_to_page_flags(unsigned int aflags)
 	return flags;
 }
 
+/** Argument of frame_remember(). */
+typedef struct {
+	/** Array for storing the frames. */
+	uintptr_t *frame;
+	/** Index of the next frame to be stored. */
+	size_t idx;
+} frame_remember_t;
+
+/** Remember a frame of an address space area being unmapped.
+ *
+ * Callback for page_mapping_remove_range().
+ *
+ * @param arg   Pointer to frame_remember_t.
+ * @param page  Virtual page that was mapped to the frame.
+ * @param frame Frame to be remembered.
+ *
+ */
+NO_TRACE static void frame_remember(void *arg, uintptr_t page,
+    uintptr_t frame)
+{
+	frame_remember_t *remember = (frame_remember_t *) arg;
+	
+	remember->frame[remember->idx++] = frame;
+}
+
 /** Change adress space area flags.
  *
  * The idea is to have the same data, but with a different access mode.
@@ -1301,32 +1371,23 @@ int as_area_change_flags(as_t *as, unsigned int flags, uintptr_t address)
 	 * Remove used pages from page tables and remember their frame
 	 * numbers.
 	 */
-	size_t frame_idx = 0;
+	frame_remember_t remember = {
+		.frame = old_frame,
+		.idx = 0
+	};
 	
 	list_foreach(area->used_space.leaf_list, leaf_link, btree_node_t,
 	    node) {
 		btree_key_t i;
 		
 		for (i = 0; i < node->keys; i++) {
-			uintptr_t ptr = node->key[i];
-			size_t size;
-			
-			for (size = 0; size < (size_t) node->value[i]; size++) {
-				pte_t *pte = page_mapping_find(as,
-				    ptr + P2SZ(size), false);
-				
-				ASSERT(pte);
-				ASSERT(PTE_VALID(pte));
-				ASSERT(PTE_PRESENT(pte));
-				
-				old_frame[frame_idx++] = PTE_GET_FRAME(pte);
-				
-				/* Remove old mapping */
-				page_mapping_remove(as, ptr + P2SZ(size));
-			}
+			page_mapping_remove_range(as, node->key[i],
+			    (size_t) node->value[i], frame_remember, &remember);
 		}
 	}
 	
+	ASSERT(remember.idx == used_pages);
+	
 	/*
 	 * Finish TLB shootdown sequence.
 	 */
@@ -1352,7 +1413,7 @@ int as_area_change_flags(as_t *as, unsigned int flags, uintptr_t address)
 	 * so that the memory area could not be accesed with both the old and
 	 * the new flags at once.
 	 */
-	frame_idx = 0;
+	size_t frame_idx = 0;
 	
 	list_foreach(area->used_space.leaf_list, leaf_link, btree_node_t,
 	    node) {
@@ -1397,8 +1458,8 @@ int as_area_change_flags(as_t *as, unsigned int flags, uintptr_t address)
  *
  * @return AS_PF_FAULT on page fault.
  * @return AS_PF_OK on success.
- * @return AS_PF_DEFER if the fault was caused by copy_to_uspace()
- *         or copy_from_uspace().
+ * @return AS_PF_DEFER if the fault was caused by memcpy_to_uspace()
+ *         or memcpy_from_uspace().
  *
  */
 int as_page_fault(uintptr_t address, pf_access_t access, istate_t *istate)
@@ -1484,6 +1545,15 @@ page_fault:
 		printf("Killing task %" PRIu64 " due to a "
 		    "failed late reservation request.\n", TASK->taskid);
 		task_kill_self(true);
+	} else if ((THREAD) && (THREAD->copy_failover) &&
+	    (address <= USER_ADDRESS_SPACE_END)) {
+		/*
+		 * The page fault was caused by memcpy_from_uspace()
+		 * or memcpy_to_uspace(). Instead of retrying the
+		 * faulting access, let the copying return the number
+		 * of bytes copied so far.
+		 */
+		istate_set_retaddr(istate, (uintptr_t) copy_failover);
 	} else {
 		panic_memtrap(istate, access, address, NULL);
 	}
@@ -1699,7 +1769,7 @@ size_t as_area_get_size(uintptr_t base)
 
 /** Mark portion of address space area as used.
  *
- * The address space area must be already locked.
+ * The address space and the address space area must be already locked.
  *
  * @param area  Address space area.
  * @param page  First page to be marked.
@@ -1980,12 +2050,13 @@ bool used_space_insert(as_area_t *area, uintptr_t page, size_t count)
 	
 success:
 	area->resident += count;
+	as_pages_adjust(area->as, &area->as->resident_pages, count);
 	return true;
 }
 
 /** Mark portion of address space area as unused.
  *
- * The address space area must be already locked.
+ * The address space and the address space area must be already locked.
  *
  * @param area  Address space area.
  * @param page  First page to be marked.
@@ -2163,6 +2234,7 @@ error:
 	
 success:
 	area->resident -= count;
+	as_pages_adjust(area->as, &area->as->resident_pages, -(ssize_t) count);
 	return true;
 }
 
@@ -62,7 +62,8 @@ static bool anon_is_resizable(as_area_t *);
 static bool anon_is_shareable(as_area_t *);
 
 static int anon_page_fault(as_area_t *, uintptr_t, pf_access_t);
-static void anon_frame_free(as_area_t *, uintptr_t, uintptr_t);
+static void anon_frame_free(as_area_t *, uintptr_t, uintptr_t,
+    frame_batch_t *);
 
 mem_backend_t anon_backend = {
 	.create = anon_create,
@@ -286,8 +287,10 @@ int anon_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
  * @param area Ignored.
  * @param page Virtual address of the page corresponding to the frame.
  * @param frame Frame to be released.
+ * @param batch Frame batch which the frame is added to.
  */
-void anon_frame_free(as_area_t *area, uintptr_t page, uintptr_t frame)
+void anon_frame_free(as_area_t *area, uintptr_t page, uintptr_t frame,
+    frame_batch_t *batch)
 {
 	ASSERT(page_table_locked(area->as));
 	ASSERT(mutex_locked(&area->lock));
@@ -295,17 +298,17 @@ void anon_frame_free(as_area_t *area, uintptr_t page, uintptr_t frame)
 	if (area->flags & AS_AREA_LATE_RESERVE) {
 		/*
 		 * In case of the late reserve areas, physical memory will not
-		 * be unreserved when the area is destroyed so we need to use
-		 * the normal unreserving frame_free().
+		 * be unreserved when the area is destroyed so we need to
+		 * unreserve the frame when it is freed.
 		 */
-		frame_free(frame, 1);
+		frame_batch_add(batch, frame, FRAME_NONE);
 	} else {
 		/*
 		 * The reserve will be given back when the area is destroyed or
-		 * resized, so use the frame_free_noreserve() which does not
-		 * manipulate the reserve or it would be given back twice.
+		 * resized, so do not manipulate the reserve when freeing the
+		 * frame or it would be given back twice.
 		 */
-		frame_free_noreserve(frame, 1);
+		frame_batch_add(batch, frame, FRAME_NO_RESERVE);
 	}
 }
 
@@ -61,7 +61,8 @@ static bool elf_is_resizable(as_area_t *);
 static bool elf_is_shareable(as_area_t *);
 
 static int elf_page_fault(as_area_t *, uintptr_t, pf_access_t);
-static void elf_frame_free(as_area_t *, uintptr_t, uintptr_t);
+static void elf_frame_free(as_area_t *, uintptr_t, uintptr_t,
+    frame_batch_t *);
 
 mem_backend_t elf_backend = {
 	.create = elf_create,
@@ -79,20 +80,49 @@ mem_backend_t elf_backend = {
 	.destroy_shared_data = NULL
 };
 
-static size_t elf_nonanon_pages_get(as_area_t *area)
+/** Get the end of the part of a segment mapped directly from the ELF image.
+ *
+ * Pages of a read-only segment which contain initialized data only (i.e. do
+ * not overlap the zero-filled tail of the segment) are not copied. Instead,
+ * they are mapped straight to the frames holding the in-memory ELF image and
+ * are thus shared by all tasks started from the same image. These pages form
+ * a contiguous range starting at the first page of the segment.
+ *
+ * @param entry		Segment header.
+ *
+ * @return		Page-aligned end (exclusive) of the range of pages
+ *			backed directly by the ELF image.
+ */
+static uintptr_t elf_image_end(elf_segment_header_t *entry)
 {
-	elf_segment_header_t *entry = area->backend_data.segment;
-	uintptr_t first = ALIGN_UP(entry->p_vaddr, PAGE_SIZE);
-	uintptr_t last = ALIGN_DOWN(entry->p_vaddr + entry->p_filesz,
-	    PAGE_SIZE);
+	uintptr_t first = ALIGN_DOWN(entry->p_vaddr, PAGE_SIZE);
+	uintptr_t start_anon = entry->p_vaddr + entry->p_filesz;
+	uintptr_t last;
 
-	if (entry->p_flags & PF_W)
-		return 0;
+	if ((entry->p_flags & PF_W) || (entry->p_filesz == 0))
+		return first;
+
+	/*
+	 * If the segment has a zero-filled tail, the page containing its
+	 * beginning must be prepared in an anonymous frame.
+	 */
+	if (entry->p_memsz > entry->p_filesz)
+		last = ALIGN_DOWN(start_anon, PAGE_SIZE);
+	else
+		last = ALIGN_UP(start_anon, PAGE_SIZE);
 
 	if (last < first)
-		return 0;
+		return first;
+
+	return last;
+}
+
+static size_t elf_nonanon_pages_get(as_area_t *area)
+{
+	elf_segment_header_t *entry = area->backend_data.segment;
+	uintptr_t first = ALIGN_DOWN(entry->p_vaddr, PAGE_SIZE);
 
-	return last - first;
+	return (elf_image_end(entry) - first) >> PAGE_WIDTH;
 }
 
 bool elf_create(as_area_t *area)
@@ -139,7 +169,7 @@ void elf_share(as_area_t *area)
 	elf_segment_header_t *entry = area->backend_data.segment;
 	link_t *cur;
 	btree_node_t *leaf, *node;
-	uintptr_t start_anon = entry->p_vaddr + entry->p_filesz;
+	uintptr_t image_end = elf_image_end(entry);
 
 	ASSERT(mutex_locked(&area->as->lock));
 	ASSERT(mutex_locked(&area->lock));
@@ -151,9 +181,8 @@ void elf_share(as_area_t *area)
 		node = list_get_instance(list_first(&area->used_space.leaf_list),
 		    btree_node_t, leaf_link);
 	} else {
-		(void) btree_search(&area->sh_info->pagemap, start_anon, &leaf);
-		node = btree_leaf_node_left_neighbour(&area->sh_info->pagemap,
-		    leaf);
+		(void) btree_search(&area->used_space, image_end, &leaf);
+		node = btree_leaf_node_left_neighbour(&area->used_space, leaf);
 		if (!node)
 			node = leaf;
 	}
@@ -174,25 +203,21 @@ void elf_share(as_area_t *area)
 			unsigned int j;
 			
 			/*
-			 * Skip read-only areas of used space that are backed
-			 * by the ELF image.
+			 * Skip areas of used space that are mapped directly
+			 * from the ELF image.
 			 */
-			if (!(area->flags & AS_AREA_WRITE))
-				if (base >= entry->p_vaddr &&
-				    base + P2SZ(count) <= start_anon)
-					continue;
+			if (base + P2SZ(count) <= image_end)
+				continue;
 			
 			for (j = 0; j < count; j++) {
 				pte_t *pte;
 			
 				/*
-				 * Skip read-only pages that are backed by the
-				 * ELF image.
+				 * Skip pages that are mapped directly from
+				 * the ELF image.
 				 */
-				if (!(area->flags & AS_AREA_WRITE))
-					if (base >= entry->p_vaddr &&
-					    base + P2SZ(j + 1) <= start_anon)
-						continue;
+				if (base + P2SZ(j) < image_end)
+					continue;
 				
 				page_table_lock(area->as, false);
 				pte = page_mapping_find(area->as,
@@ -315,33 +340,35 @@ int elf_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 	 * The area is either not shared or the pagemap does not contain the
 	 * mapping.
 	 */
-	if (upage >= entry->p_vaddr && upage + PAGE_SIZE <= start_anon) {
+	if (upage < elf_image_end(entry)) {
 		/*
-		 * Initialized portion of the segment. The memory is backed
-		 * directly by the content of the ELF image. Pages are
-		 * only copied if the segment is writable so that there
-		 * can be more instantions of the same memory ELF image
-		 * used at a time. Note that this could be later done
-		 * as COW.
+		 * Read-only initialized portion of the segment. The memory
+		 * is backed directly by the frames of the ELF image so that
+		 * all instances of the same memory ELF image share it and
+		 * nothing needs to be allocated or copied.
 		 */
-		if (entry->p_flags & PF_W) {
-			kpage = km_temporary_page_get(&frame, FRAME_NO_RESERVE);
-			memcpy((void *) kpage, (void *) (base + i * PAGE_SIZE),
-			    PAGE_SIZE);
-			if (entry->p_flags & PF_X) {
-				smc_coherence_block((void *) kpage, PAGE_SIZE);
-			}
-			km_temporary_page_put(kpage);
-			dirty = true;
-		} else {
-			pte_t *pte = page_mapping_find(AS_KERNEL,
-			    base + i * FRAME_SIZE, true);
+		pte_t *pte = page_mapping_find(AS_KERNEL,
+		    base + i * FRAME_SIZE, true);
 
-			ASSERT(pte);
-			ASSERT(PTE_PRESENT(pte));
+		ASSERT(pte);
+		ASSERT(PTE_PRESENT(pte));
 
-			frame = PTE_GET_FRAME(pte);
-		}	
+		frame = PTE_GET_FRAME(pte);
+	} else if (upage >= entry->p_vaddr && upage + PAGE_SIZE <= start_anon) {
+		/*
+		 * Writable initialized portion of the segment. Pages are
+		 * copied so that there can be more instantions of the same
+		 * memory ELF image used at a time. Note that this could be
+		 * later done as COW.
+		 */
+		kpage = km_temporary_page_get(&frame, FRAME_NO_RESERVE);
+		memcpy((void *) kpage, (void *) (base + i * PAGE_SIZE),
+		    PAGE_SIZE);
+		if (entry->p_flags & PF_X) {
+			smc_coherence_block((void *) kpage, PAGE_SIZE);
+		}
+		km_temporary_page_put(kpage);
+		dirty = true;
 	} else if (upage >= start_anon) {
 		/*
 		 * This is the uninitialized portion of the segment.
@@ -409,12 +436,13 @@ int elf_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
  * @param page		Page that is mapped to frame. Must be aligned to
  * 			PAGE_SIZE.
  * @param frame		Frame to be released.
+ * @param batch		Frame batch which the frame is added to.
  *
  */
-void elf_frame_free(as_area_t *area, uintptr_t page, uintptr_t frame)
+void elf_frame_free(as_area_t *area, uintptr_t page, uintptr_t frame,
+    frame_batch_t *batch)
 {
 	elf_segment_header_t *entry = area->backend_data.segment;
-	uintptr_t start_anon;
 
 	ASSERT(page_table_locked(area->as));
 	ASSERT(mutex_locked(&area->lock));
@@ -422,23 +450,15 @@ void elf_frame_free(as_area_t *area, uintptr_t page, uintptr_t frame)
 	ASSERT(page >= ALIGN_DOWN(entry->p_vaddr, PAGE_SIZE));
 	ASSERT(page < entry->p_vaddr + entry->p_memsz);
 
-	start_anon = entry->p_vaddr + entry->p_filesz;
-
-	if (page >= entry->p_vaddr && page + PAGE_SIZE <= start_anon) {
-		if (entry->p_flags & PF_W) {
-			/*
-			 * Free the frame with the copy of writable segment
-			 * data.
-			 */
-			frame_free_noreserve(frame, 1);
-		}
-	} else {
+	if (page >= elf_image_end(entry)) {
 		/*
-		 * The frame is either anonymous memory or the mixed case (i.e.
-		 * lower part is backed by the ELF image and the upper is
-		 * anonymous). In any case, a frame needs to be freed.
+		 * The frame is either a copy of writable segment data,
+		 * anonymous memory or the mixed case (i.e. lower part is
+		 * backed by the ELF image and the upper is anonymous). In
+		 * any case, a frame needs to be freed. Frames of the ELF
+		 * image itself are never freed.
 		 */
-		frame_free_noreserve(frame, 1);
+		frame_batch_add(batch, frame, FRAME_NO_RESERVE);
 	}
 }
 
@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup genericmm
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Copying data between the kernel and uspace.
+ *
+ * The data are copied in whole data cache blocks whenever possible. An access
+ * to uspace memory which cannot be resolved by the page fault handler does not
+ * bring the system down, but merely cuts the copying short. The number of
+ * bytes copied is reported back to the caller.
+ */
+
+#include <mm/copy.h>
+#include <mm/as.h>
+#include <proc/thread.h>
+#include <context.h>
+#include <arch.h>
+#include <macros.h>
+#include <debug.h>
+#include <errno.h>
+#include <typedefs.h>
+
+/** Machine word which can alias any other type. */
+typedef sysarg_t word_t __attribute__((may_alias));
+
+/** Copy memory block between the kernel and uspace.
+ *
+ * If the source and the destination can be both word aligned at the
+ * same time, the block is copied in whole data cache blocks, using
+ * words for the rest. Otherwise, the block is copied byte by byte.
+ *
+ * @param dst  Destination address.
+ * @param src  Source address.
+ * @param size Number of bytes to copy.
+ * @param zero True if the destination is cacheable kernel memory
+ *             which can be established in the cache without being
+ *             read from memory first.
+ * @param done Number of bytes copied so far. Kept up to date
+ *             during the copying.
+ *
+ */
+NO_TRACE static void copy_block(void *dst, const void *src, size_t size,
+    bool zero, volatile size_t *done)
+{
+	uint8_t *dp = (uint8_t *) dst;
+	const uint8_t *sp = (const uint8_t *) src;
+	size_t off = 0;
+	
+	if ((((uintptr_t) dp ^ (uintptr_t) sp) & (sizeof(word_t) - 1)) == 0) {
+		/* Align the destination to a word. */
+		while ((off < size) &&
+		    (((uintptr_t) (dp + off) & (sizeof(word_t) - 1)) != 0)) {
+			dp[off] = sp[off];
+			*done = ++off;
+		}
+		
+		/* Align the destination to a data cache block. */
+		while ((size - off >= sizeof(word_t)) &&
+		    (((uintptr_t) (dp + off) & (DCACHE_BLOCK_SIZE - 1)) != 0)) {
+			*((word_t *) (dp + off)) = *((const word_t *) (sp + off));
+			off += sizeof(word_t);
+			*done = off;
+		}
+		
+		/* Copy whole data cache blocks. */
+		while (size - off >= DCACHE_BLOCK_SIZE) {
+			word_t *wdp = (word_t *) (dp + off);
+			const word_t *wsp = (const word_t *) (sp + off);
+			unsigned int i;
+			
+			dcache_block_prefetch(sp + off + DCACHE_BLOCK_SIZE);
+			if (zero)
+				dcache_block_zero(wdp);
+			
+			for (i = 0; i < DCACHE_BLOCK_SIZE / sizeof(word_t); i++)
+				wdp[i] = wsp[i];
+			
+			off += DCACHE_BLOCK_SIZE;
+			*done = off;
+		}
+		
+		/* Copy the remaining words. */
+		while (size - off >= sizeof(word_t)) {
+			*((word_t *) (dp + off)) = *((const word_t *) (sp + off));
+			off += sizeof(word_t);
+			*done = off;
+		}
+	}
+	
+	/* Copy the remaining bytes. */
+	while (off < size) {
+		dp[off] = sp[off];
+		*done = ++off;
+	}
+}
+
+/** Copy memory block between the kernel and uspace with failover.
+ *
+ * @param dst  Destination address.
+ * @param src  Source address.
+ * @param size Number of bytes to copy.
+ * @param zero True if the destination is kernel memory.
+ *
+ * @return Number of bytes copied before an unresolvable
+ *         page fault occurred or size on success.
+ *
+ */
+static size_t copy_uspace(void *dst, const void *src, size_t size, bool zero)
+{
+	context_t failover;
+	volatile size_t done = 0;
+	
+	ASSERT(THREAD);
+	ASSERT(THREAD->copy_failover == NULL);
+	
+	/*
+	 * If the copying faults, as_page_fault() redirects the thread
+	 * to copy_failover(), which returns here once more.
+	 */
+	if (context_save(&failover)) {
+		THREAD->copy_failover = &failover;
+		copy_block(dst, src, size, zero, &done);
+	}
+	
+	THREAD->copy_failover = NULL;
+	return done;
+}
+
+/** Copy data from uspace to the kernel.
+ *
+ * The uspace address is not checked.
+ *
+ * @param dst        Destination kernel address.
+ * @param uspace_src Source uspace address.
+ * @param size       Number of bytes to copy.
+ *
+ * @return Number of bytes copied. Less than size if the
+ *         uspace memory could not be accessed.
+ *
+ */
+size_t memcpy_from_uspace(void *dst, const void *uspace_src, size_t size)
+{
+	return copy_uspace(dst, uspace_src, size, true);
+}
+
+/** Copy data from the kernel to uspace.
+ *
+ * The uspace address is not checked.
+ *
+ * @param uspace_dst Destination uspace address.
+ * @param src        Source kernel address.
+ * @param size       Number of bytes to copy.
+ *
+ * @return Number of bytes copied. Less than size if the
+ *         uspace memory could not be accessed.
+ *
+ */
+size_t memcpy_to_uspace(void *uspace_dst, const void *src, size_t size)
+{
+	/*
+	 * The uspace memory might not be cacheable, do not
+	 * establish its cache blocks without reading them.
+	 */
+	return copy_uspace(uspace_dst, src, size, false);
+}
+
+/** Check whether a memory block lies in uspace.
+ *
+ * @param addr Start of the block.
+ * @param size Size of the block.
+ *
+ * @return True if the whole block lies in uspace.
+ *
+ */
+NO_TRACE static bool uspace_block(const void *addr, size_t size)
+{
+	return iswithin(USER_ADDRESS_SPACE_START,
+	    (uint64_t) USER_ADDRESS_SPACE_END - USER_ADDRESS_SPACE_START + 1,
+	    (uintptr_t) addr, size);
+}
+
+/** Copy data from uspace to the kernel.
+ *
+ * @param dst        Destination kernel address.
+ * @param uspace_src Source uspace address.
+ * @param size       Number of bytes to copy.
+ *
+ * @return EOK on success.
+ * @return EPERM if the source is not a valid uspace memory block.
+ *
+ */
+int copy_from_uspace(void *dst, const void *uspace_src, size_t size)
+{
+	if (!uspace_block(uspace_src, size))
+		return EPERM;
+	
+	if (memcpy_from_uspace(dst, uspace_src, size) != size)
+		return EPERM;
+	
+	return EOK;
+}
+
+/** Copy data from the kernel to uspace.
+ *
+ * @param uspace_dst Destination uspace address.
+ * @param src        Source kernel address.
+ * @param size       Number of bytes to copy.
+ *
+ * @return EOK on success.
+ * @return EPERM if the destination is not a valid uspace memory block.
+ *
+ */
+int copy_to_uspace(void *uspace_dst, const void *src, size_t size)
+{
+	if (!uspace_block(uspace_dst, size))
+		return EPERM;
+	
+	if (memcpy_to_uspace(uspace_dst, src, size) != size)
+		return EPERM;
+	
+	return EOK;
+}
+
+/** Abandon the copying after an unresolvable page fault.
+ *
+ * The page fault handler makes the faulting thread return
+ * here instead of the faulting instruction.
+ *
+ */
+void copy_failover(void)
+{
+	ASSERT(THREAD);
+	ASSERT(THREAD->copy_failover);
+	
+	context_restore(THREAD->copy_failover);
+}
+
+/** @}
+ */
@@ -963,6 +963,39 @@ uintptr_t frame_alloc(size_t count, frame_flags_t flags, uintptr_t constraint)
 	return frame_alloc_generic(count, flags, constraint, NULL);
 }
 
+/** Signal that frames have been freed.
+ *
+ * @param freed     Number of frames that have been freed.
+ * @param unreserve Number of freed frames to be returned to the reserve.
+ *
+ */
+NO_TRACE static void frame_freed(size_t freed, size_t unreserve)
+{
+	/*
+	 * Signal that some memory has been freed.
+	 * Since the mem_avail_mtx is an active mutex,
+	 * we need to disable interruptsto prevent deadlock
+	 * with TLB shootdown.
+	 */
+	
+	ipl_t ipl = interrupts_disable();
+	mutex_lock(&mem_avail_mtx);
+	
+	if (mem_avail_req > 0)
+		mem_avail_req -= min(mem_avail_req, freed);
+	
+	if (mem_avail_req == 0) {
+		mem_avail_gen++;
+		condvar_broadcast(&mem_avail_cv);
+	}
+	
+	mutex_unlock(&mem_avail_mtx);
+	interrupts_restore(ipl);
+	
+	if (unreserve > 0)
+		reserve_free(unreserve);
+}
+
 /** Free frames of physical memory.
  *
  * Find respective frame structures for supplied physical frames.
@@ -995,29 +1028,7 @@ void frame_free_generic(uintptr_t start, size_t count, frame_flags_t flags)
 	
 	irq_spinlock_unlock(&zones.lock, true);
 	
-	/*
-	 * Signal that some memory has been freed.
-	 * Since the mem_avail_mtx is an active mutex,
-	 * we need to disable interruptsto prevent deadlock
-	 * with TLB shootdown.
-	 */
-	
-	ipl_t ipl = interrupts_disable();
-	mutex_lock(&mem_avail_mtx);
-	
-	if (mem_avail_req > 0)
-		mem_avail_req -= min(mem_avail_req, freed);
-	
-	if (mem_avail_req == 0) {
-		mem_avail_gen++;
-		condvar_broadcast(&mem_avail_cv);
-	}
-	
-	mutex_unlock(&mem_avail_mtx);
-	interrupts_restore(ipl);
-	
-	if (!(flags & FRAME_NO_RESERVE))
-		reserve_free(freed);
+	frame_freed(freed, (flags & FRAME_NO_RESERVE) ? 0 : freed);
 }
 
 void frame_free(uintptr_t frame, size_t count)
@@ -1030,6 +1041,75 @@ void frame_free_noreserve(uintptr_t frame, size_t count)
 	frame_free_generic(frame, count, FRAME_NO_RESERVE);
 }
 
+/** Initialize an empty frame batch.
+ *
+ * @param batch Frame batch.
+ *
+ */
+void frame_batch_initialize(frame_batch_t *batch)
+{
+	batch->count = 0;
+}
+
+/** Add frame to a frame batch.
+ *
+ * The frame is freed as if by frame_free_generic() at the latest when
+ * the batch is flushed. A full batch is flushed automatically.
+ *
+ * @param batch Frame batch.
+ * @param frame Physical address of the frame to be freed.
+ * @param flags Flags to control memory reservation.
+ *
+ */
+void frame_batch_add(frame_batch_t *batch, uintptr_t frame,
+    frame_flags_t flags)
+{
+	if (batch->count == FRAME_BATCH_SIZE)
+		frame_batch_flush(batch);
+	
+	batch->frame[batch->count] = frame;
+	batch->flags[batch->count] = flags;
+	batch->count++;
+}
+
+/** Free all frames collected in a frame batch.
+ *
+ * @param batch Frame batch. It is empty upon return.
+ *
+ */
+void frame_batch_flush(frame_batch_t *batch)
+{
+	size_t freed = 0;
+	size_t unreserve = 0;
+	size_t znum = 0;
+	
+	if (batch->count == 0)
+		return;
+	
+	irq_spinlock_lock(&zones.lock, true);
+	
+	for (size_t i = 0; i < batch->count; i++) {
+		pfn_t pfn = ADDR2PFN(batch->frame[i]);
+		
+		/* Frames of a batch tend to come from the same zone. */
+		znum = find_zone(pfn, 1, znum);
+		
+		ASSERT(znum != (size_t) -1);
+		
+		size_t cnt = zone_frame_free(&zones.info[znum],
+		    pfn - zones.info[znum].base);
+		
+		freed += cnt;
+		if (!(batch->flags[i] & FRAME_NO_RESERVE))
+			unreserve += cnt;
+	}
+	
+	irq_spinlock_unlock(&zones.lock, true);
+	
+	batch->count = 0;
+	frame_freed(freed, unreserve);
+}
+
 /** Add reference to frame.
  *
  * Find respective frame structure for supplied PFN and
@@ -1054,6 +1134,32 @@ NO_TRACE void frame_reference_add(pfn_t pfn)
 	irq_spinlock_unlock(&zones.lock, true);
 }
 
+/** Add reference to frame if it is managed by a zone.
+ *
+ * Unlike frame_reference_add(), the frame might be outside
+ * of all available zones, e.g. device memory mapped to a task.
+ *
+ * @param pfn Frame number of the frame.
+ *
+ * @return True if the reference has been added.
+ *
+ */
+NO_TRACE bool frame_reference_try_add(pfn_t pfn)
+{
+	irq_spinlock_lock(&zones.lock, true);
+	
+	size_t znum = find_zone(pfn, 1, 0);
+	bool available = (znum != (size_t) -1) &&
+	    (zones.info[znum].flags & ZONE_AVAILABLE);
+	
+	if (available)
+		zones.info[znum].frames[pfn - zones.info[znum].base].refcount++;
+	
+	irq_spinlock_unlock(&zones.lock, true);
+	
+	return available;
+}
+
 /** Mark given range unavailable in frame zones.
  *
  */
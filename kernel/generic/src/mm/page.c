@@ -133,6 +133,58 @@ NO_TRACE void page_mapping_remove(as_t *as, uintptr_t page)
 	memory_barrier();
 }
 
+/** Remove mappings of a range of pages.
+ *
+ * Remove any mappings of count pages starting at page within address
+ * space as. For each present mapping, the release callback is invoked
+ * with the virtual page and the frame it was mapped to before the mapping
+ * is destroyed. TLB shootdown should follow in order to make effects of
+ * this call visible.
+ *
+ * Page table implementations which do not provide a range operation
+ * fall back to removing the pages one by one.
+ *
+ * @param as      Address space to which the pages belong.
+ * @param page    Virtual address of the first page to be demapped.
+ * @param count   Number of pages to be demapped.
+ * @param release Callback to be invoked for each present mapping or NULL.
+ * @param arg     Argument passed to the callback.
+ *
+ */
+NO_TRACE void page_mapping_remove_range(as_t *as, uintptr_t page, size_t count,
+    page_mapping_release_t release, void *arg)
+{
+	ASSERT(page_table_locked(as));
+	
+	ASSERT(page_mapping_operations);
+	
+	page = ALIGN_DOWN(page, PAGE_SIZE);
+	
+	if (page_mapping_operations->mapping_remove_range) {
+		page_mapping_operations->mapping_remove_range(as, page, count,
+		    release, arg);
+	} else {
+		ASSERT(page_mapping_operations->mapping_remove);
+		ASSERT(page_mapping_operations->mapping_find);
+		
+		for (size_t i = 0; i < count; i++) {
+			pte_t *pte = page_mapping_operations->mapping_find(as,
+			    page + P2SZ(i), false);
+			if ((!pte) || (!PTE_VALID(pte)))
+				continue;
+			
+			if ((release) && (PTE_PRESENT(pte)))
+				release(arg, page + P2SZ(i), PTE_GET_FRAME(pte));
+			
+			page_mapping_operations->mapping_remove(as,
+			    page + P2SZ(i));
+		}
+	}
+	
+	/* Repel prefetched accesses to the old mappings. */
+	memory_barrier();
+}
+
 /** Find mapping for virtual page.
  *
  * @param as     Address space to which page belongs.
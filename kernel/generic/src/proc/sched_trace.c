@@ -0,0 +1,336 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup genericproc
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Scheduler event tracing.
+ *
+ * Every processor records context switches, wakeups, preemptions and
+ * migrations into its own ring of fixed size binary events. A ring is
+ * only ever written by its processor with interrupts disabled, so the
+ * writer needs no locking. Once a ring is full, the oldest events are
+ * overwritten. Readers drain the rings through sysinfo or the kconsole.
+ * The events of each processor are ordered, events of different
+ * processors need to be merged by their timestamps.
+ */
+
+#include <proc/sched_trace.h>
+#include <proc/thread.h>
+#include <synch/spinlock.h>
+#include <sysinfo/sysinfo.h>
+#include <arch/barrier.h>
+#include <arch/cycle.h>
+#include <arch/asm.h>
+#include <mm/slab.h>
+#include <mm/frame.h>
+#include <memstr.h>
+#include <config.h>
+#include <macros.h>
+#include <print.h>
+#include <debug.h>
+#include <arch.h>
+#include <cpu.h>
+
+/** Per-processor trace ring. */
+typedef struct {
+	/** Number of events ever recorded (written by the owner only). */
+	volatile size_t head;
+	/** Number of events ever drained (protected by drain_lock). */
+	size_t tail;
+	sched_trace_event_t event[SCHED_TRACE_ENTRIES];
+} sched_trace_ring_t;
+
+/** Tracing switch checked by the recording fast path. */
+volatile bool sched_trace_enabled = false;
+
+/** Rings of all processors, allocated when first enabled. */
+static sched_trace_ring_t *rings = NULL;
+
+/** Serializes readers of the rings. */
+IRQ_SPINLOCK_STATIC_INITIALIZE(drain_lock);
+
+#define SCHED_TRACE_TYPES  4
+
+static const char *sched_trace_names[SCHED_TRACE_TYPES] = {
+	"switch",
+	"wakeup",
+	"preempt",
+	"migrate"
+};
+
+/** Count the events which can still be drained from the rings.
+ *
+ * @return Number of events neither overwritten nor drained yet.
+ *
+ */
+static size_t sched_trace_pending(void)
+{
+	size_t count = 0;
+	
+	irq_spinlock_lock(&drain_lock, true);
+	
+	if (rings != NULL) {
+		for (unsigned int i = 0; i < config.cpu_count; i++) {
+			count += min(rings[i].head - rings[i].tail,
+			    (size_t) SCHED_TRACE_ENTRIES);
+		}
+	}
+	
+	irq_spinlock_unlock(&drain_lock, true);
+	
+	return count;
+}
+
+/** Record a scheduler trace event on the current processor.
+ *
+ * Use sched_trace() instead, which avoids the call
+ * when tracing is disabled.
+ *
+ * @param type   Event type.
+ * @param tid    ID of the thread the event is about.
+ * @param arg    Type specific argument.
+ * @param target Processor whose run queue the thread lands in.
+ *
+ */
+void sched_trace_record(sched_trace_type_t type, thread_id_t tid,
+    uint64_t arg, cpu_t *target)
+{
+	ASSERT(CPU != NULL);
+	ASSERT(rings != NULL);
+	
+	ipl_t ipl = interrupts_disable();
+	
+	sched_trace_ring_t *ring = &rings[CPU->id];
+	size_t head = ring->head;
+	sched_trace_event_t *event =
+	    &ring->event[head & (SCHED_TRACE_ENTRIES - 1)];
+	
+	event->timestamp = get_cycle();
+	event->tid = tid;
+	event->arg = arg;
+	event->type = type;
+	event->cpu = CPU->id;
+	event->target = target->id;
+	event->nrdy = atomic_get(&target->nrdy);
+	
+	/* Publish the event only after it has been completely written. */
+	write_barrier();
+	ring->head = head + 1;
+	
+	interrupts_restore(ipl);
+}
+
+/** Start tracing the scheduler.
+ *
+ * @return False if the trace rings could not be allocated.
+ *
+ */
+bool sched_trace_enable(void)
+{
+	if (rings == NULL) {
+		sched_trace_ring_t *new_rings = (sched_trace_ring_t *)
+		    malloc(sizeof(sched_trace_ring_t) * config.cpu_count,
+		    FRAME_ATOMIC);
+		if (new_rings == NULL)
+			return false;
+		
+		memsetb(new_rings, sizeof(sched_trace_ring_t) * config.cpu_count, 0);
+		
+		irq_spinlock_lock(&drain_lock, true);
+		if (rings == NULL) {
+			rings = new_rings;
+			new_rings = NULL;
+		}
+		irq_spinlock_unlock(&drain_lock, true);
+		
+		if (new_rings != NULL)
+			free(new_rings);
+	}
+	
+	/* The rings must be visible before the recording starts. */
+	write_barrier();
+	sched_trace_enabled = true;
+	
+	return true;
+}
+
+/** Stop tracing the scheduler.
+ *
+ * The events recorded so far are kept and can still be drained.
+ *
+ */
+void sched_trace_disable(void)
+{
+	sched_trace_enabled = false;
+}
+
+/** Drain recorded events from the trace rings.
+ *
+ * The rings are drained one processor after another. Events overwritten
+ * by their processor while being copied are dropped.
+ *
+ * @param buf   Buffer for the events.
+ * @param count Maximal number of events to drain.
+ *
+ * @return Number of events stored to buf.
+ *
+ */
+size_t sched_trace_drain(sched_trace_event_t *buf, size_t count)
+{
+	size_t drained = 0;
+	
+	irq_spinlock_lock(&drain_lock, true);
+	
+	if (rings == NULL) {
+		irq_spinlock_unlock(&drain_lock, true);
+		return 0;
+	}
+	
+	for (unsigned int i = 0; (i < config.cpu_count) && (drained < count);
+	    i++) {
+		sched_trace_ring_t *ring = &rings[i];
+		
+		size_t head = ring->head;
+		read_barrier();
+		
+		size_t tail = ring->tail;
+		if (head - tail > SCHED_TRACE_ENTRIES)
+			tail = head - SCHED_TRACE_ENTRIES;
+		
+		size_t n = min(head - tail, count - drained);
+		for (size_t j = 0; j < n; j++) {
+			buf[drained + j] =
+			    ring->event[(tail + j) & (SCHED_TRACE_ENTRIES - 1)];
+		}
+		
+		/*
+		 * The owner might have been overwriting the oldest
+		 * events while they were being copied.
+		 */
+		read_barrier();
+		size_t lost = 0;
+		size_t recorded = ring->head - tail;
+		if (recorded >= SCHED_TRACE_ENTRIES)
+			lost = min(recorded - SCHED_TRACE_ENTRIES + 1, n);
+		
+		if (lost > 0) {
+			memmove(&buf[drained], &buf[drained + lost],
+			    (n - lost) * sizeof(sched_trace_event_t));
+		}
+		
+		ring->tail = tail + n;
+		drained += n - lost;
+	}
+	
+	irq_spinlock_unlock(&drain_lock, true);
+	
+	return drained;
+}
+
+/** Get the recorded scheduler events
+ *
+ * The events returned are drained from the trace rings.
+ *
+ * @param item    Sysinfo item (unused).
+ * @param size    Size of the returned data.
+ * @param dry_run Do not get the data, just calculate the size.
+ * @param data    Unused.
+ *
+ * @return Data containing several sched_trace_event_t structures.
+ *         If the return value is not NULL, it should be freed
+ *         in the context of the sysinfo request.
+ */
+static void *get_sched_trace(struct sysinfo_item *item, size_t *size,
+    bool dry_run, void *data)
+{
+	size_t count = sched_trace_pending();
+	
+	*size = sizeof(sched_trace_event_t) * count;
+	if ((dry_run) || (count == 0))
+		return NULL;
+	
+	sched_trace_event_t *events =
+	    (sched_trace_event_t *) malloc(*size, FRAME_ATOMIC);
+	if (events == NULL) {
+		*size = 0;
+		return NULL;
+	}
+	
+	*size = sizeof(sched_trace_event_t) * sched_trace_drain(events, count);
+	return ((void *) events);
+}
+
+/** Drain and print the recorded scheduler events. */
+void sched_trace_print(void)
+{
+	sched_trace_event_t events[16];
+	
+	/*
+	 * Printing causes further events to be recorded,
+	 * print only those which are already there.
+	 */
+	size_t pending = sched_trace_pending();
+	
+	printf("[cpu] [timestamp         ] [event] [tid     ] [arg     ]"
+	    " [target] [nrdy]\n");
+	
+	while (pending > 0) {
+		size_t count = sched_trace_drain(events,
+		    min(pending, sizeof(events) / sizeof(events[0])));
+		if (count == 0)
+			break;
+		
+		for (size_t i = 0; i < count; i++) {
+			sched_trace_event_t *event = &events[i];
+			const char *name = (event->type < SCHED_TRACE_TYPES) ?
+			    sched_trace_names[event->type] : "?";
+			
+			printf("%5u %20" PRIu64 " %-7s %10" PRIu64 " %10" PRIu64
+			    " %8u %6u\n", (unsigned int) event->cpu,
+			    event->timestamp, name, event->tid, event->arg,
+			    (unsigned int) event->target,
+			    (unsigned int) event->nrdy);
+		}
+		
+		pending = (count < pending) ? pending - count : 0;
+	}
+}
+
+/** Initialize scheduler tracing. */
+void sched_trace_init(void)
+{
+	sysinfo_set_item_gen_data("system.schedtrace", NULL, get_sched_trace,
+	    NULL);
+}
+
+/** @}
+ */
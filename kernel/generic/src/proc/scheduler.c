@@ -34,12 +34,13 @@
  * @file
  * @brief Scheduler and load balancing.
  *
- * This file contains the scheduler and kcpulb kernel thread which
- * performs load-balancing of per-CPU run queues.
+ * This file contains the scheduler. Load balancing of per-CPU run
+ * queues is done by idle CPUs stealing ready threads from busy ones.
  */
 
 #include <proc/scheduler.h>
 #include <proc/thread.h>
+#include <proc/sched_trace.h>
 #include <proc/task.h>
 #include <mm/frame.h>
 #include <mm/page.h>
@@ -47,25 +48,33 @@
 #include <time/timeout.h>
 #include <time/delay.h>
 #include <arch/asm.h>
+#include <arch/barrier.h>
 #include <arch/faddr.h>
 #include <arch/cycle.h>
 #include <atomic.h>
 #include <synch/spinlock.h>
+#include <synch/rcu.h>
 #include <config.h>
 #include <context.h>
 #include <fpu_context.h>
 #include <func.h>
 #include <arch.h>
 #include <adt/list.h>
+#include <adt/avl.h>
 #include <panic.h>
+#include <macros.h>
 #include <cpu.h>
 #include <print.h>
 #include <log.h>
 #include <debug.h>
 #include <stacktrace.h>
+#include <bitops.h>
 
 static void scheduler_separated_stack(void);
 
+/** Share of RT_PERIOD available to real-time threads (percent). */
+static unsigned int rt_bandwidth = RT_BANDWIDTH;
+
 atomic_t nrdy;  /**< Number of ready threads in the system. */
 
 /** Carry out actions before new task runs. */
@@ -171,81 +180,633 @@ void scheduler_init(void)
 {
 }
 
+/** Update the bit of a run queue in the bitmap of non-empty run queues
+ *
+ * Must be called whenever the run queue becomes empty or non-empty.
+ * The run queue lock must be held.
+ *
+ * @param cpu CPU owning the run queue.
+ * @param i   Index of the run queue.
+ *
+ */
+void rq_map_update(cpu_t *cpu, unsigned int i)
+{
+	ASSERT(irq_spinlock_locked(&cpu->rq[i].lock));
+	
+	spinlock_lock(&cpu->rq_map_lock);
+	
+	if (cpu->rq[i].n == 0)
+		cpu->rq_map &= ~RQ_MAP_BIT(i);
+	else
+		cpu->rq_map |= RQ_MAP_BIT(i);
+	
+	spinlock_unlock(&cpu->rq_map_lock);
+}
+
+/** Insert a ready thread into the fair run queue
+ *
+ * A thread which has slept for a long time or which comes from
+ * another CPU is not allowed to lag behind the threads already
+ * waiting in the queue, otherwise it would monopolize the CPU
+ * until it catches up with them.
+ *
+ * @param cpu    CPU whose fair run queue is used. The lock of
+ *               the queue must be held.
+ * @param thread Thread to insert.
+ *
+ */
+void fairq_insert(cpu_t *cpu, thread_t *thread)
+{
+	ASSERT(irq_spinlock_locked(&cpu->fairq.lock));
+	ASSERT(thread->fair);
+	
+	if ((thread->cpu != cpu) ||
+	    (thread->vruntime < cpu->fairq.min_vruntime))
+		thread->vruntime = cpu->fairq.min_vruntime;
+	
+	avltree_node_initialize(&thread->fairq_node);
+	thread->fairq_node.key = thread->vruntime;
+	avltree_insert(&cpu->fairq.tree, &thread->fairq_node);
+	cpu->fairq.n++;
+}
+
+/** Remove a thread from the fair run queue
+ *
+ * @param cpu    CPU whose fair run queue is used. The lock of
+ *               the queue must be held.
+ * @param thread Thread to remove.
+ *
+ */
+NO_TRACE static void fairq_remove(cpu_t *cpu, thread_t *thread)
+{
+	ASSERT(irq_spinlock_locked(&cpu->fairq.lock));
+	ASSERT(cpu->fairq.n > 0);
+	
+	avltree_delete(&cpu->fairq.tree, &thread->fairq_node);
+	cpu->fairq.n--;
+}
+
+/** Time slice of a fair thread
+ *
+ * The latency period is divided among all ready fair threads.
+ *
+ * @param cpu CPU the thread is going to run on.
+ *
+ * @return Time slice in microseconds.
+ *
+ */
+NO_TRACE static uint32_t fairq_slice(cpu_t *cpu)
+{
+	return max(FAIR_LATENCY / (cpu->fairq.n + 1), FAIR_GRANULARITY);
+}
+
+/** Insert a ready thread into the real-time run queue
+ *
+ * @param cpu    CPU whose real-time run queue is used. The lock
+ *               of the queue must be held.
+ * @param thread Thread to insert.
+ * @param head   Insert the thread at the head of its queue
+ *               instead of the tail.
+ *
+ * @return True if the thread running on the CPU should be preempted.
+ *
+ */
+bool rtq_insert(cpu_t *cpu, thread_t *thread, bool head)
+{
+	ASSERT(irq_spinlock_locked(&cpu->rtq.lock));
+	ASSERT(thread->rt);
+	ASSERT(thread->rt_priority < RT_COUNT);
+	
+	list_t *rq = &cpu->rtq.rq[thread->rt_priority];
+	
+	if (head)
+		list_prepend(&thread->rq_link, rq);
+	else
+		list_append(&thread->rq_link, rq);
+	
+	cpu->rtq.n++;
+	
+	if ((!cpu->rtq.throttled) &&
+	    (thread->rt_priority < cpu->rtq.current)) {
+		cpu->rtq.preempt = true;
+		return true;
+	}
+	
+	return false;
+}
+
+/** Take the highest-priority thread from the real-time run queue
+ *
+ * @param cpu CPU whose real-time run queue is used. The lock
+ *            of the queue must be held.
+ *
+ * @return Thread taken from the queue or NULL if it is empty.
+ *
+ */
+NO_TRACE static thread_t *rtq_take(cpu_t *cpu)
+{
+	ASSERT(irq_spinlock_locked(&cpu->rtq.lock));
+	
+	unsigned int i;
+	for (i = 0; i < RT_COUNT; i++) {
+		if (!list_empty(&cpu->rtq.rq[i])) {
+			thread_t *thread = list_get_instance(
+			    list_first(&cpu->rtq.rq[i]), thread_t, rq_link);
+			list_remove(&thread->rq_link);
+			cpu->rtq.n--;
+			
+			return thread;
+		}
+	}
+	
+	return NULL;
+}
+
+/** Set the real-time bandwidth
+ *
+ * @param percent Share of each RT_PERIOD the real-time threads
+ *                may consume on a CPU while other threads are ready.
+ *
+ */
+void rt_bandwidth_set(unsigned int percent)
+{
+	rt_bandwidth = min(percent, 100);
+}
+
+/** Get the real-time bandwidth
+ *
+ * @return Share of each RT_PERIOD the real-time threads
+ *         may consume on a CPU while other threads are ready.
+ *
+ */
+unsigned int rt_bandwidth_get(void)
+{
+	return rt_bandwidth;
+}
+
+/** Account the real-time bandwidth on clock tick
+ *
+ * Once the real-time threads have consumed their bandwidth, they are
+ * throttled for the rest of the period so that the other threads
+ * cannot be locked out of the CPU.
+ *
+ * Interrupts must be disabled.
+ *
+ * @param ticks Number of ticks elapsed since the last call.
+ *
+ * @return True if THREAD should be preempted because it is throttled
+ *         or because the throttled threads are allowed to run again.
+ *
+ */
+bool rt_tick(size_t ticks)
+{
+	rtq_t *rtq = &CPU->rtq;
+	bool running = (rtq->current < RT_COUNT);
+	
+	rtq->period += ticks;
+	if (rtq->period >= us2ticks(RT_PERIOD)) {
+		rtq->period = 0;
+		rtq->runtime = 0;
+		
+		if (rtq->throttled) {
+			rtq->throttled = false;
+			return ((!running) && (rtq->n != 0));
+		}
+		
+		return false;
+	}
+	
+	if (running)
+		rtq->runtime += ticks;
+	
+	if ((!rtq->throttled) &&
+	    (rtq->runtime >= us2ticks(RT_PERIOD / 100 * rt_bandwidth))) {
+		rtq->throttled = true;
+		return running;
+	}
+	
+	return false;
+}
+
+/** Preempt THREAD in favour of a higher-priority real-time thread
+ *
+ * Called at the points where it is safe to reschedule, i.e. on return
+ * from an interrupt and after waking up threads, when a real-time thread
+ * has become ready on the current CPU.
+ *
+ */
+void scheduler_preempt(void)
+{
+	if ((CPU) && (CPU->rtq.preempt) && (THREAD) && (!PREEMPTION_DISABLED))
+		scheduler();
+}
+
+#ifdef CONFIG_SMP
+
+/** Distance between two CPUs
+ *
+ * A hint used to prefer stealing threads from CPUs which are more
+ * likely to share caches with the current one. No topology is known,
+ * so CPUs with close IDs are assumed to be closer to each other.
+ *
+ * @param cpu1 First CPU.
+ * @param cpu2 Second CPU.
+ *
+ * @return Distance between the CPUs.
+ *
+ */
+NO_TRACE static unsigned int cpu_distance(cpu_t *cpu1, cpu_t *cpu2)
+{
+	return (cpu1->id > cpu2->id) ?
+	    (cpu1->id - cpu2->id) : (cpu2->id - cpu1->id);
+}
+
+/** Find the CPU to steal a ready thread from
+ *
+ * The CPU with the most ready threads is chosen, the closest
+ * one if there are several of them.
+ *
+ * @return CPU to steal from or NULL if there is none.
+ *
+ */
+static cpu_t *steal_victim(void)
+{
+	cpu_t *victim = NULL;
+	atomic_count_t victim_rdy = 0;
+	unsigned int victim_distance = 0;
+	
+	unsigned int i;
+	for (i = 0; i < config.cpu_count; i++) {
+		cpu_t *cpu = &cpus[i];
+		
+		if ((cpu == CPU) || (!cpu->active))
+			continue;
+		
+		/*
+		 * An idle CPU with a single ready thread has just been
+		 * woken up to run it.
+		 */
+		atomic_count_t rdy = atomic_get(&cpu->nrdy);
+		if ((rdy == 0) || ((rdy == 1) && (cpu->idle)))
+			continue;
+		
+		unsigned int distance = cpu_distance(CPU, cpu);
+		
+		if ((victim == NULL) || (rdy > victim_rdy) ||
+		    ((rdy == victim_rdy) && (distance < victim_distance))) {
+			victim = cpu;
+			victim_rdy = rdy;
+			victim_distance = distance;
+		}
+	}
+	
+	return victim;
+}
+
+/** Check whether a ready thread can be stolen by another CPU
+ *
+ * Do not steal threads not allowed to run on the current CPU, threads
+ * for which migration was temporarily disabled or threads whose FPU
+ * context is still in the CPU.
+ *
+ * @param thread Ready thread. Its lock must be held.
+ *
+ * @return True if the thread can be stolen.
+ *
+ */
+NO_TRACE static bool thread_stealable(thread_t *thread)
+{
+	return ((cpu_mask_is_set(&thread->affinity, CPU->id)) &&
+	    (!thread->nomigrate) && (!thread->fpu_context_engaged));
+}
+
+/** Fair run queue walker looking for a thread to steal
+ *
+ * @param node Node of the fair run queue.
+ * @param arg  Place to store the thread found.
+ *
+ * @return False to stop the walk once a thread is found.
+ *
+ */
+static bool steal_fair_walker(avltree_node_t *node, void *arg)
+{
+	thread_t *thread = avltree_get_instance(node, thread_t, fairq_node);
+	
+	irq_spinlock_lock(&thread->lock, false);
+	if (thread_stealable(thread)) {
+		/* The lock is released by the caller. */
+		*((thread_t **) arg) = thread;
+		return false;
+	}
+	
+	irq_spinlock_unlock(&thread->lock, false);
+	return true;
+}
+
+/** Steal a ready thread from another CPU
+ *
+ * The run queues of the victim are searched from the lowest priority
+ * and each of them from the back, so that the thread which is least
+ * likely to have its working set in the caches of the victim is taken.
+ * Fair threads are taken in the order of their virtual runtime.
+ *
+ * @param victim CPU to steal from.
+ * @param rq     Place to store the index of the run queue
+ *               the thread was taken from.
+ *
+ * @return Stolen thread with its lock held or NULL.
+ *
+ */
+static thread_t *steal_thread(cpu_t *victim, unsigned int *rq)
+{
+	/*
+	 * A real-time thread waiting on a busy CPU is the one
+	 * which profits the most from being stolen.
+	 */
+	if (victim->rtq.n != 0) {
+		irq_spinlock_lock(&victim->rtq.lock, false);
+		
+		unsigned int i;
+		for (i = 0; i < RT_COUNT; i++) {
+			list_foreach(victim->rtq.rq[i], rq_link, thread_t,
+			    thread) {
+				irq_spinlock_lock(&thread->lock, false);
+				
+				if (thread_stealable(thread)) {
+					atomic_dec(&victim->nrdy);
+					atomic_dec(&nrdy);
+					
+					list_remove(&thread->rq_link);
+					victim->rtq.n--;
+					
+					irq_spinlock_unlock(&victim->rtq.lock,
+					    false);
+					
+					*rq = 0;
+					return thread;
+				}
+				
+				irq_spinlock_unlock(&thread->lock, false);
+			}
+		}
+		
+		irq_spinlock_unlock(&victim->rtq.lock, false);
+	}
+	
+	/*
+	 * The fair run queue is searched first, its threads are the
+	 * first to give way to the higher-priority threads in rq.
+	 */
+	if (victim->fairq.n != 0) {
+		thread_t *thread = NULL;
+		
+		irq_spinlock_lock(&victim->fairq.lock, false);
+		avltree_walk(&victim->fairq.tree, steal_fair_walker, &thread);
+		
+		if (thread) {
+			atomic_dec(&victim->nrdy);
+			atomic_dec(&nrdy);
+			
+			fairq_remove(victim, thread);
+			irq_spinlock_unlock(&victim->fairq.lock, false);
+			
+			*rq = FAIR_PRIORITY;
+			return thread;
+		}
+		
+		irq_spinlock_unlock(&victim->fairq.lock, false);
+	}
+	
+	uint32_t map = victim->rq_map;
+	
+	while (map != 0) {
+		/* The lowest-priority queue has the least significant bit. */
+		unsigned int i = 31 - fnzb32(map & (~map + 1));
+		ASSERT(i < RQ_COUNT);
+		map &= ~RQ_MAP_BIT(i);
+		
+		irq_spinlock_lock(&(victim->rq[i].lock), false);
+		
+		list_foreach_rev(victim->rq[i].rq, rq_link, thread_t, thread) {
+			irq_spinlock_lock(&thread->lock, false);
+			
+			if (thread_stealable(thread)) {
+				atomic_dec(&victim->nrdy);
+				atomic_dec(&nrdy);
+				
+				victim->rq[i].n--;
+				if (victim->rq[i].n == 0)
+					rq_map_update(victim, i);
+				list_remove(&thread->rq_link);
+				
+				irq_spinlock_unlock(&(victim->rq[i].lock),
+				    false);
+				
+				*rq = i;
+				return thread;
+			}
+			
+			irq_spinlock_unlock(&thread->lock, false);
+		}
+		
+		irq_spinlock_unlock(&(victim->rq[i].lock), false);
+	}
+	
+	return NULL;
+}
+
+#endif /* CONFIG_SMP */
+
 /** Get thread to be scheduled
  *
  * Get the optimal thread to be scheduled
  * according to thread accounting and scheduler
  * policy.
  *
+ * Real-time threads are preferred unless they have
+ * exhausted their bandwidth. If there is no ready thread
+ * on the current CPU, a ready thread is stolen from the
+ * busiest CPU.
+ *
  * @return Thread to be scheduled.
  *
  */
 static thread_t *find_best_thread(void)
 {
+	thread_t *thread;
+	unsigned int i;
+	
 	ASSERT(CPU != NULL);
 	
 loop:
 	
+	/* Any real-time thread made ready from now on is considered. */
+	CPU->rtq.current = RT_COUNT;
+	CPU->rtq.preempt = false;
+	
 	if (atomic_get(&CPU->nrdy) == 0) {
+#ifdef CONFIG_SMP
+		cpu_t *victim = steal_victim();
+		if (victim) {
+			thread = steal_thread(victim, &i);
+			if (thread) {
+				sched_trace(SCHED_TRACE_MIGRATE, thread->tid,
+				    victim->id, CPU);
+				goto found;
+			}
+		}
+#endif /* CONFIG_SMP */
+		
 		/*
 		 * For there was nothing to run, the CPU goes to sleep
 		 * until a hardware interrupt or an IPI comes.
 		 * This improves energy saving and hyperthreading.
+		 * The idle loop is a quiescent state for RCU.
 		 */
+		rcu_quiescent_state();
+		
 		irq_spinlock_lock(&CPU->lock, false);
 		CPU->idle = true;
 		irq_spinlock_unlock(&CPU->lock, false);
+		
+		/*
+		 * A thread made ready by another CPU before the idle
+		 * flag became visible there has not been announced by
+		 * a wakeup IPI. Pairs with the barrier in thread_ready().
+		 */
+		memory_barrier();
+		if (atomic_get(&CPU->nrdy) != 0) {
+			irq_spinlock_lock(&CPU->lock, false);
+			CPU->idle = false;
+			irq_spinlock_unlock(&CPU->lock, false);
+			goto loop;
+		}
+		
+		/* Do not wake up before the first timeout expires. */
+		clock_program();
 		interrupts_enable();
 		
 		/*
-		 * An interrupt might occur right now and wake up a thread.
-		 * In such case, the CPU will continue to go to sleep
-		 * even though there is a runnable thread.
+		 * An interrupt taken since the check above has cleared
+		 * the idle flag and might have woken up a thread, which
+		 * would otherwise wait for the programmed timeout.
 		 */
-		cpu_sleep();
+		memory_barrier();
+		if (CPU->idle)
+			cpu_sleep();
+		
 		interrupts_disable();
 		goto loop;
 	}
 	
-	unsigned int i;
-	for (i = 0; i < RQ_COUNT; i++) {
-		irq_spinlock_lock(&(CPU->rq[i].lock), false);
-		if (CPU->rq[i].n == 0) {
-			/*
-			 * If this queue is empty, try a lower-priority queue.
-			 */
-			irq_spinlock_unlock(&(CPU->rq[i].lock), false);
-			continue;
+	/*
+	 * Real-time threads run first. Once they have exhausted
+	 * their bandwidth, they run only if nothing else is ready.
+	 */
+	if ((CPU->rtq.n != 0) && ((!CPU->rtq.throttled) ||
+	    ((CPU->rq_map == 0) && (CPU->fairq.n == 0)))) {
+		irq_spinlock_lock(&CPU->rtq.lock, false);
+		
+		thread = rtq_take(CPU);
+		if (thread) {
+			atomic_dec(&CPU->nrdy);
+			atomic_dec(&nrdy);
+			
+			irq_spinlock_pass(&CPU->rtq.lock, &thread->lock);
+			
+			i = 0;
+			goto found;
 		}
 		
-		atomic_dec(&CPU->nrdy);
-		atomic_dec(&nrdy);
-		CPU->rq[i].n--;
+		irq_spinlock_unlock(&CPU->rtq.lock, false);
+	}
+	
+	/*
+	 * Find the highest-priority non-empty queue.
+	 */
+	uint32_t map = CPU->rq_map;
+	i = (map != 0) ? 31 - fnzb32(map) : RQ_COUNT;
+	
+	/*
+	 * The fair class takes the place of rq[FAIR_PRIORITY] and is
+	 * served unless there are threads in the queues of higher
+	 * priority. The classic threads queued below it are not
+	 * starved, see relink_rq() in scheduler().
+	 */
+	if ((i >= FAIR_PRIORITY) && (CPU->fairq.n != 0)) {
+		irq_spinlock_lock(&CPU->fairq.lock, false);
 		
+		avltree_node_t *node = avltree_find_min(&CPU->fairq.tree);
+		if (node) {
+			thread = avltree_get_instance(node, thread_t,
+			    fairq_node);
+			
+			atomic_dec(&CPU->nrdy);
+			atomic_dec(&nrdy);
+			fairq_remove(CPU, thread);
+			
+			CPU->fairq.min_vruntime =
+			    max(CPU->fairq.min_vruntime, thread->vruntime);
+			
+			irq_spinlock_pass(&CPU->fairq.lock, &thread->lock);
+			
+			i = FAIR_PRIORITY;
+			goto found;
+		}
+		
+		irq_spinlock_unlock(&CPU->fairq.lock, false);
+	}
+	
+	if (map == 0) {
 		/*
-		 * Take the first thread from the queue.
+		 * The thread which made CPU->nrdy non-zero
+		 * has not been enqueued yet or has just been
+		 * stolen by another CPU.
 		 */
-		thread_t *thread = list_get_instance(
-		    list_first(&CPU->rq[i].rq), thread_t, rq_link);
-		list_remove(&thread->rq_link);
-		
-		irq_spinlock_pass(&(CPU->rq[i].lock), &thread->lock);
-		
-		thread->cpu = CPU;
-		thread->ticks = us2ticks((i + 1) * 10000);
-		thread->priority = i;  /* Correct rq index */
-		
+		goto loop;
+	}
+	
+	ASSERT(i < RQ_COUNT);
+	
+	irq_spinlock_lock(&(CPU->rq[i].lock), false);
+	if (CPU->rq[i].n == 0) {
 		/*
-		 * Clear the stolen flag so that it can be migrated
-		 * when load balancing needs emerge.
+		 * The queue has been emptied by another CPU
+		 * after the bitmap was read.
 		 */
-		thread->stolen = false;
-		irq_spinlock_unlock(&thread->lock, false);
-		
-		return thread;
+		irq_spinlock_unlock(&(CPU->rq[i].lock), false);
+		goto loop;
 	}
 	
-	goto loop;
+	atomic_dec(&CPU->nrdy);
+	atomic_dec(&nrdy);
+	CPU->rq[i].n--;
+	if (CPU->rq[i].n == 0)
+		rq_map_update(CPU, i);
+	
+	/*
+	 * Take the first thread from the queue.
+	 */
+	thread = list_get_instance(list_first(&CPU->rq[i].rq), thread_t,
+	    rq_link);
+	list_remove(&thread->rq_link);
+	
+	irq_spinlock_pass(&(CPU->rq[i].lock), &thread->lock);
+	
+found:
+	thread->cpu = CPU;
+	if (thread->rt) {
+		thread->ticks = us2ticks(RT_QUANTUM);
+		CPU->rtq.current = thread->rt_priority;
+	} else if (thread->fair)
+		thread->ticks = us2ticks(fairq_slice(CPU));
+	else
+		thread->ticks = us2ticks((i + 1) * 10000);
+	thread->priority = i;  /* Correct rq index */
+	
+	irq_spinlock_unlock(&thread->lock, false);
+	
+	return thread;
 }
 
 /** Prevent rq starvation
@@ -275,13 +836,19 @@ static void relink_rq(int start)
 			list_concat(&list, &CPU->rq[i + 1].rq);
 			size_t n = CPU->rq[i + 1].n;
 			CPU->rq[i + 1].n = 0;
+			if (n != 0)
+				rq_map_update(CPU, i + 1);
 			irq_spinlock_unlock(&CPU->rq[i + 1].lock, false);
 			
 			/* Append rq[i + 1] to rq[i] */
 			
 			irq_spinlock_lock(&CPU->rq[i].lock, false);
 			list_concat(&CPU->rq[i].rq, &list);
-			CPU->rq[i].n += n;
+			if ((CPU->rq[i].n == 0) && (n != 0)) {
+				CPU->rq[i].n = n;
+				rq_map_update(CPU, i);
+			} else
+				CPU->rq[i].n += n;
 			irq_spinlock_unlock(&CPU->rq[i].lock, false);
 		}
 		
@@ -382,10 +949,14 @@ void scheduler_separated_stack(void)
 	DEADLOCK_PROBE_INIT(p_joinwq);
 	task_t *old_task = TASK;
 	as_t *old_as = AS;
+	thread_id_t old_tid = THREAD ? THREAD->tid : 0;
 	
 	ASSERT((!THREAD) || (irq_spinlock_locked(&THREAD->lock)));
 	ASSERT(CPU != NULL);
 	
+	/* A context switch is a quiescent state for RCU. */
+	rcu_quiescent_state();
+	
 	/*
 	 * Hold the current task and the address space to prevent their
 	 * possible destruction should thread_destroy() be called on this or any
@@ -465,12 +1036,20 @@ repeat:
 	}
 	
 	THREAD = find_best_thread();
+	sched_trace(SCHED_TRACE_SWITCH, THREAD->tid, old_tid, CPU);
 	
 	irq_spinlock_lock(&THREAD->lock, false);
 	int priority = THREAD->priority;
+	bool fair = THREAD->fair;
 	irq_spinlock_unlock(&THREAD->lock, false);
 	
-	relink_rq(priority);
+	/*
+	 * A fair thread runs in place of rq[FAIR_PRIORITY]. Relink that
+	 * queue as well so that the classic threads of the lower half
+	 * eventually get above the fair class instead of being starved
+	 * by a CPU-bound fair thread.
+	 */
+	relink_rq(fair ? FAIR_PRIORITY - 1 : priority);
 	
 	/*
 	 * If both the old and the new task are the same,
@@ -504,6 +1083,9 @@ repeat:
 	irq_spinlock_lock(&THREAD->lock, false);
 	THREAD->state = Running;
 	
+	/* Interrupt the thread when its time slice ends. */
+	clock_program();
+	
 #ifdef SCHEDULER_VERBOSE
 	log(LF_OTHER, LVL_DEBUG,
 	    "cpu%u: tid %" PRIu64 " (priority=%d, ticks=%" PRIu64
@@ -532,177 +1114,23 @@ repeat:
 	/* Not reached */
 }
 
-#ifdef CONFIG_SMP
-/** Load balancing thread
+/** Fair run queue walker printing the threads
  *
- * SMP load balancing thread, supervising thread supplies
- * for the CPU it's wired to.
+ * @param node Node of the fair run queue.
+ * @param arg  Unused.
  *
- * @param arg Generic thread argument (unused).
+ * @return Always true to continue the walk.
  *
  */
-void kcpulb(void *arg)
+static bool sched_print_walker(avltree_node_t *node, void *arg)
 {
-	atomic_count_t average;
-	atomic_count_t rdy;
-	
-	/*
-	 * Detach kcpulb as nobody will call thread_join_timeout() on it.
-	 */
-	thread_detach(THREAD);
-	
-loop:
-	/*
-	 * Work in 1s intervals.
-	 */
-	thread_sleep(1);
-	
-not_satisfied:
-	/*
-	 * Calculate the number of threads that will be migrated/stolen from
-	 * other CPU's. Note that situation can have changed between two
-	 * passes. Each time get the most up to date counts.
-	 *
-	 */
-	average = atomic_get(&nrdy) / config.cpu_active + 1;
-	rdy = atomic_get(&CPU->nrdy);
-	
-	if (average <= rdy)
-		goto satisfied;
-	
-	atomic_count_t count = average - rdy;
-	
-	/*
-	 * Searching least priority queues on all CPU's first and most priority
-	 * queues on all CPU's last.
-	 */
-	size_t acpu;
-	size_t acpu_bias = 0;
-	int rq;
-	
-	for (rq = RQ_COUNT - 1; rq >= 0; rq--) {
-		for (acpu = 0; acpu < config.cpu_active; acpu++) {
-			cpu_t *cpu = &cpus[(acpu + acpu_bias) % config.cpu_active];
-			
-			/*
-			 * Not interested in ourselves.
-			 * Doesn't require interrupt disabling for kcpulb has
-			 * THREAD_FLAG_WIRED.
-			 *
-			 */
-			if (CPU == cpu)
-				continue;
-			
-			if (atomic_get(&cpu->nrdy) <= average)
-				continue;
-			
-			irq_spinlock_lock(&(cpu->rq[rq].lock), true);
-			if (cpu->rq[rq].n == 0) {
-				irq_spinlock_unlock(&(cpu->rq[rq].lock), true);
-				continue;
-			}
-			
-			thread_t *thread = NULL;
-			
-			/* Search rq from the back */
-			link_t *link = cpu->rq[rq].rq.head.prev;
-			
-			while (link != &(cpu->rq[rq].rq.head)) {
-				thread = (thread_t *) list_get_instance(link,
-				    thread_t, rq_link);
-				
-				/*
-				 * Do not steal CPU-wired threads, threads
-				 * already stolen, threads for which migration
-				 * was temporarily disabled or threads whose
-				 * FPU context is still in the CPU.
-				 */
-				irq_spinlock_lock(&thread->lock, false);
-				
-				if ((!thread->wired) && (!thread->stolen) &&
-				    (!thread->nomigrate) &&
-				    (!thread->fpu_context_engaged)) {
-					/*
-					 * Remove thread from ready queue.
-					 */
-					irq_spinlock_unlock(&thread->lock,
-					    false);
-					
-					atomic_dec(&cpu->nrdy);
-					atomic_dec(&nrdy);
-					
-					cpu->rq[rq].n--;
-					list_remove(&thread->rq_link);
-					
-					break;
-				}
-				
-				irq_spinlock_unlock(&thread->lock, false);
-				
-				link = link->prev;
-				thread = NULL;
-			}
-			
-			if (thread) {
-				/*
-				 * Ready thread on local CPU
-				 */
-				
-				irq_spinlock_pass(&(cpu->rq[rq].lock),
-				    &thread->lock);
-				
-#ifdef KCPULB_VERBOSE
-				log(LF_OTHER, LVL_DEBUG,
-				    "kcpulb%u: TID %" PRIu64 " -> cpu%u, "
-				    "nrdy=%ld, avg=%ld", CPU->id, t->tid,
-				    CPU->id, atomic_get(&CPU->nrdy),
-				    atomic_get(&nrdy) / config.cpu_active);
-#endif
-				
-				thread->stolen = true;
-				thread->state = Entering;
-				
-				irq_spinlock_unlock(&thread->lock, true);
-				thread_ready(thread);
-				
-				if (--count == 0)
-					goto satisfied;
-				
-				/*
-				 * We are not satisfied yet, focus on another
-				 * CPU next time.
-				 *
-				 */
-				acpu_bias++;
-				
-				continue;
-			} else
-				irq_spinlock_unlock(&(cpu->rq[rq].lock), true);
-			
-		}
-	}
+	thread_t *thread = avltree_get_instance(node, thread_t, fairq_node);
 	
-	if (atomic_get(&CPU->nrdy)) {
-		/*
-		 * Be a little bit light-weight and let migrated threads run.
-		 *
-		 */
-		scheduler();
-	} else {
-		/*
-		 * We failed to migrate a single thread.
-		 * Give up this turn.
-		 *
-		 */
-		goto loop;
-	}
-	
-	goto not_satisfied;
+	printf("%" PRIu64 "(%s, vruntime=%" PRIu64 ") ", thread->tid,
+	    thread_states[thread->state], thread->vruntime);
 	
-satisfied:
-	goto loop;
+	return true;
 }
-#endif /* CONFIG_SMP */
 
 /** Print information about threads & scheduler queues
  *
@@ -716,11 +1144,37 @@ void sched_print_list(void)
 		
 		irq_spinlock_lock(&cpus[cpu].lock, true);
 		
-		printf("cpu%u: address=%p, nrdy=%" PRIua ", needs_relink=%zu\n",
-		    cpus[cpu].id, &cpus[cpu], atomic_get(&cpus[cpu].nrdy),
-		    cpus[cpu].needs_relink);
+		printf("cpu%u: address=%p, nrdy=%" PRIua ", needs_relink=%zu"
+		    "%s\n", cpus[cpu].id, &cpus[cpu],
+		    atomic_get(&cpus[cpu].nrdy), cpus[cpu].needs_relink,
+		    cpus[cpu].rtq.throttled ? ", rt throttled" : "");
+		
+		irq_spinlock_lock(&cpus[cpu].fairq.lock, false);
+		if (cpus[cpu].fairq.n != 0) {
+			printf("\tfairq: ");
+			avltree_walk(&cpus[cpu].fairq.tree, sched_print_walker,
+			    NULL);
+			printf("\n");
+		}
+		irq_spinlock_unlock(&cpus[cpu].fairq.lock, false);
 		
 		unsigned int i;
+		
+		irq_spinlock_lock(&cpus[cpu].rtq.lock, false);
+		for (i = 0; i < RT_COUNT; i++) {
+			if (list_empty(&cpus[cpu].rtq.rq[i]))
+				continue;
+			
+			printf("\trt[%u]: ", i);
+			list_foreach(cpus[cpu].rtq.rq[i], rq_link, thread_t,
+			    thread) {
+				printf("%" PRIu64 "(%s) ", thread->tid,
+				    thread_states[thread->state]);
+			}
+			printf("\n");
+		}
+		irq_spinlock_unlock(&cpus[cpu].rtq.lock, false);
+		
 		for (i = 0; i < RQ_COUNT; i++) {
 			irq_spinlock_lock(&(cpus[cpu].rq[i].lock), false);
 			if (cpus[cpu].rq[i].n == 0) {
@@ -45,7 +45,6 @@
 #include <arch.h>
 #include <arch/barrier.h>
 #include <adt/avl.h>
-#include <adt/btree.h>
 #include <adt/list.h>
 #include <print.h>
 #include <errno.h>
@@ -54,8 +53,8 @@
 #include <memstr.h>
 #include <macros.h>
 
-/** Spinlock protecting the tasks_tree AVL tree. */
-IRQ_SPINLOCK_INITIALIZE(tasks_lock);
+/** Reader-writer lock protecting the tasks_tree AVL tree. */
+IRQ_RWLOCK_DECLARE(tasks_lock);
 
 /** AVL tree of active tasks.
  *
@@ -84,6 +83,7 @@ static int tsk_constructor(void *, unsigned int);
 void task_init(void)
 {
 	TASK = NULL;
+	irq_rwlock_initialize(&tasks_lock, "tasks_lock");
 	avltree_create(&tasks_tree);
 	task_slab = slab_cache_create("task_t", sizeof(task_t), 0,
 	    tsk_constructor, NULL, 0);
@@ -127,10 +127,10 @@ void task_done(void)
 		printf("Killing tasks... ");
 #endif
 		
-		irq_spinlock_lock(&tasks_lock, true);
+		irq_rwlock_read_lock(&tasks_lock, true);
 		tasks_left = 0;
 		avltree_walk(&tasks_tree, task_done_walker, &tasks_left);
-		irq_spinlock_unlock(&tasks_lock, true);
+		irq_rwlock_read_unlock(&tasks_lock, true);
 		
 		thread_sleep(1);
 		
@@ -148,7 +148,6 @@ int tsk_constructor(void *obj, unsigned int kmflags)
 	atomic_set(&task->lifecount, 0);
 	
 	irq_spinlock_initialize(&task->lock, "task_t_lock");
-	mutex_initialize(&task->futexes_lock, MUTEX_PASSIVE);
 	
 	list_initialize(&task->threads);
 	
@@ -174,22 +173,20 @@ task_t *task_create(as_t *as, const char *name)
 	task->container = CONTAINER;
 	task->ucycles = 0;
 	task->kcycles = 0;
-
-	btree_create(&task->futexes);
 	
 	/*
 	 * Get a reference to the address space.
 	 */
 	as_hold(task->as);
 	
-	irq_spinlock_lock(&tasks_lock, true);
+	irq_rwlock_write_lock(&tasks_lock, true);
 	
 	task->taskid = ++task_counter;
 	avltree_node_initialize(&task->tasks_tree_node);
 	task->tasks_tree_node.key = task->taskid;
 	avltree_insert(&tasks_tree, &task->tasks_tree_node);
 	
-	irq_spinlock_unlock(&tasks_lock, true);
+	irq_rwlock_write_unlock(&tasks_lock, true);
 	
 	return task;
 }
@@ -204,20 +201,15 @@ void task_destroy(task_t *task)
 	/*
 	 * Remove the task from the task B+tree.
 	 */
-	irq_spinlock_lock(&tasks_lock, true);
+	irq_rwlock_write_lock(&tasks_lock, true);
 	avltree_delete(&tasks_tree, &task->tasks_tree_node);
-	irq_spinlock_unlock(&tasks_lock, true);
+	irq_rwlock_write_unlock(&tasks_lock, true);
 	
 	/*
 	 * Perform architecture specific task destruction.
 	 */
 	task_destroy_arch(task);
 	
-	/*
-	 * Free up dynamically allocated state.
-	 */
-	btree_destroy(&task->futexes);
-	
 	/*
 	 * Drop our reference to the address space.
 	 */
@@ -265,7 +257,7 @@ void task_release(task_t *task)
 task_t *task_find_by_id(task_id_t id)
 {
 	ASSERT(interrupts_disabled());
-	ASSERT(irq_spinlock_locked(&tasks_lock));
+	ASSERT(irq_rwlock_locked(&tasks_lock));
 
 	avltree_node_t *node =
 	    avltree_search(&tasks_tree, (avltree_key_t) id);
@@ -320,7 +312,7 @@ void task_get_accounting(task_t *task, uint64_t *ucycles, uint64_t *kcycles)
 static void task_kill_internal(task_t *task)
 {
 	irq_spinlock_lock(&task->lock, false);
-	irq_spinlock_lock(&threads_lock, false);
+	irq_rwlock_read_lock(&threads_lock, false);
 	
 	/*
 	 * Interrupt all threads.
@@ -341,7 +333,7 @@ static void task_kill_internal(task_t *task)
 			waitq_interrupt_sleep(thread);
 	}
 	
-	irq_spinlock_unlock(&threads_lock, false);
+	irq_rwlock_read_unlock(&threads_lock, false);
 	irq_spinlock_unlock(&task->lock, false);
 }
 
@@ -360,16 +352,16 @@ int task_kill(task_id_t id)
 	if (id == 1)
 		return EPERM;
 	
-	irq_spinlock_lock(&tasks_lock, true);
+	irq_rwlock_read_lock(&tasks_lock, true);
 	
 	task_t *task = task_find_by_id(id);
 	if (!task) {
-		irq_spinlock_unlock(&tasks_lock, true);
+		irq_rwlock_read_unlock(&tasks_lock, true);
 		return ENOENT;
 	}
 	
 	task_kill_internal(task);
-	irq_spinlock_unlock(&tasks_lock, true);
+	irq_rwlock_read_unlock(&tasks_lock, true);
 	
 	return EOK;
 }
@@ -383,9 +375,9 @@ int task_kill(task_id_t id)
  */
 void task_kill_self(bool notify)
 {
-	irq_spinlock_lock(&tasks_lock, true);
+	irq_rwlock_read_lock(&tasks_lock, true);
 	task_kill_internal(TASK);
-	irq_spinlock_unlock(&tasks_lock, true);
+	irq_rwlock_read_unlock(&tasks_lock, true);
 	
 	thread_exit();
 }
@@ -437,7 +429,7 @@ static bool task_print_walker(avltree_node_t *node, void *arg)
 void task_print_list(bool additional)
 {
 	/* Messing with task structures, avoid deadlock */
-	irq_spinlock_lock(&tasks_lock, true);
+	irq_rwlock_read_lock(&tasks_lock, true);
 	
 #ifdef __32_BITS__
 	if (additional)
@@ -458,7 +450,7 @@ void task_print_list(bool additional)
 	
 	avltree_walk(&tasks_tree, task_print_walker, &additional);
 	
-	irq_spinlock_unlock(&tasks_lock, true);
+	irq_rwlock_read_unlock(&tasks_lock, true);
 }
 
 /** @}
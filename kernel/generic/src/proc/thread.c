@@ -37,10 +37,12 @@
 
 #include <proc/scheduler.h>
 #include <proc/thread.h>
+#include <proc/sched_trace.h>
 #include <proc/task.h>
 #include <mm/frame.h>
 #include <mm/page.h>
 #include <arch/asm.h>
+#include <arch/barrier.h>
 #include <arch/cycle.h>
 #include <arch.h>
 #include <synch/spinlock.h>
@@ -56,6 +58,7 @@
 #include <config.h>
 #include <arch/interrupt.h>
 #include <smp/ipi.h>
+#include <macros.h>
 #include <arch/faddr.h>
 #include <atomic.h>
 #include <memstr.h>
@@ -85,7 +88,7 @@ typedef struct {
  * For locking rules, see declaration thereof.
  *
  */
-IRQ_SPINLOCK_INITIALIZE(threads_lock);
+IRQ_RWLOCK_DECLARE(threads_lock);
 
 /** AVL tree of all threads.
  *
@@ -231,6 +234,7 @@ void thread_init(void)
 {
 	THREAD = NULL;
 	
+	irq_rwlock_initialize(&threads_lock, "threads_lock");
 	atomic_set(&nrdy, 0);
 	thread_slab = slab_cache_create("thread_t", sizeof(thread_t), 0,
 	    thr_constructor, thr_destructor, 0);
@@ -245,15 +249,158 @@ void thread_init(void)
 
 /** Wire thread to the given CPU
  *
- * @param cpu CPU to wire the thread to.
+ * Restrict the affinity of the thread to a single CPU. The thread
+ * is made ready on that CPU even if it is not active yet.
+ *
+ * @param thread Thread to wire.
+ * @param cpu    CPU to wire the thread to.
  *
  */
 void thread_wire(thread_t *thread, cpu_t *cpu)
 {
 	irq_spinlock_lock(&thread->lock, true);
 	thread->cpu = cpu;
-	thread->wired = true;
+	cpu_mask_none(&thread->affinity);
+	cpu_mask_set(&thread->affinity, cpu->id);
+	irq_spinlock_unlock(&thread->lock, true);
+}
+
+/** Set the CPU affinity of a thread
+ *
+ * A thread which is running or ready on a CPU outside of the new
+ * affinity moves to an allowed CPU the next time it becomes ready.
+ *
+ * @param thread   Thread whose affinity is set.
+ * @param affinity CPUs the thread is allowed to run on.
+ *
+ * @return EOK on success.
+ * @return EINVAL if the affinity does not contain any existing CPU.
+ *
+ */
+int thread_set_affinity(thread_t *thread, const cpu_mask_t *affinity)
+{
+	unsigned int i;
+	for (i = 0; i < config.cpu_count; i++) {
+		if (cpu_mask_is_set(affinity, i))
+			break;
+	}
+	
+	if (i == config.cpu_count)
+		return EINVAL;
+	
+	irq_spinlock_lock(&thread->lock, true);
+	thread->affinity = *affinity;
 	irq_spinlock_unlock(&thread->lock, true);
+	
+	return EOK;
+}
+
+/** Check whether a thread is allowed to run on a CPU
+ *
+ * @param thread Thread. Its lock must be held.
+ * @param cpu    CPU.
+ *
+ * @return True if the CPU is in the affinity of the thread.
+ *
+ */
+NO_TRACE static inline bool thread_allowed(thread_t *thread, cpu_t *cpu)
+{
+	return cpu_mask_is_set(&thread->affinity, cpu->id);
+}
+
+/** Choose the CPU on which a migratable thread becomes ready
+ *
+ * The CPU on which the thread ran last is preferred as its cache
+ * might still be warm, unless it is already busier than average
+ * while another CPU is idle. The current CPU is used for threads
+ * which have never run and when there is no better choice.
+ *
+ * A real-time thread is rather sent to a CPU on which it can
+ * preempt the running thread than left waiting on its previous CPU.
+ *
+ * Only the CPUs in the affinity of the thread are considered.
+ *
+ * @param thread Thread to be made ready. Its lock must be held.
+ *
+ * @return CPU to enqueue the thread on.
+ *
+ */
+static cpu_t *thread_ready_cpu(thread_t *thread)
+{
+#ifdef CONFIG_SMP
+	cpu_t *prev = thread->cpu;
+	bool prev_usable = (prev) && (prev->active) &&
+	    (thread_allowed(thread, prev));
+	unsigned int i;
+	
+	/* The previous CPU is idle, nothing can be better. */
+	if ((prev_usable) && (prev->idle))
+		return prev;
+	
+	if (thread->rt) {
+		if ((prev_usable) && (prev->rtq.current > thread->rt_priority))
+			return prev;
+		
+		/* Prefer an idle CPU, then the least urgent running thread. */
+		cpu_t *best = NULL;
+		for (i = 0; i < config.cpu_count; i++) {
+			cpu_t *cpu = &cpus[i];
+			
+			if ((!cpu->active) || (!thread_allowed(thread, cpu)))
+				continue;
+			
+			if (cpu->idle)
+				return cpu;
+			
+			if ((cpu->rtq.current > thread->rt_priority) &&
+			    ((best == NULL) ||
+			    (cpu->rtq.current > best->rtq.current)))
+				best = cpu;
+		}
+		
+		if (best)
+			return best;
+	}
+	
+	atomic_count_t avg = atomic_get(&nrdy) / config.cpu_active;
+	
+	if ((prev_usable) && (atomic_get(&prev->nrdy) <= avg))
+		return prev;
+	
+	/* Try to find an idle CPU. */
+	for (i = 0; i < config.cpu_count; i++) {
+		if ((cpus[i].active) && (cpus[i].idle) &&
+		    (thread_allowed(thread, &cpus[i])))
+			return &cpus[i];
+	}
+	
+	if (prev_usable)
+		return prev;
+	
+	if (thread_allowed(thread, CPU))
+		return CPU;
+	
+	/*
+	 * Take the least loaded allowed CPU. A thread wired
+	 * to a CPU which is not active yet waits there.
+	 */
+	cpu_t *best = NULL;
+	for (i = 0; i < config.cpu_count; i++) {
+		cpu_t *cpu = &cpus[i];
+		
+		if (!thread_allowed(thread, cpu))
+			continue;
+		
+		if ((best == NULL) || ((cpu->active) && ((!best->active) ||
+		    (atomic_get(&cpu->nrdy) < atomic_get(&best->nrdy)))))
+			best = cpu;
+	}
+	
+	ASSERT(best != NULL);
+	return best;
+#else
+	return CPU;
+#endif
 }
 
 /** Make thread ready
@@ -269,33 +416,82 @@ void thread_ready(thread_t *thread)
 	
 	ASSERT(thread->state != Ready);
 	
-	int i = (thread->priority < RQ_COUNT - 1) ?
-	    ++thread->priority : thread->priority;
+	/* The thread can run and exit as soon as it is unlocked. */
+	thread_id_t tid = thread->tid;
 	
 	cpu_t *cpu;
-	if (thread->wired || thread->nomigrate || thread->fpu_context_engaged) {
+	if (thread->nomigrate || thread->fpu_context_engaged) {
 		ASSERT(thread->cpu != NULL);
 		cpu = thread->cpu;
 	} else
-		cpu = CPU;
+		cpu = thread_ready_cpu(thread);
 	
 	thread->state = Ready;
 	
-	irq_spinlock_pass(&thread->lock, &(cpu->rq[i].lock));
-	
-	/*
-	 * Append thread to respective ready queue
-	 * on respective processor.
-	 */
+	bool preempt = false;
 	
-	list_append(&thread->rq_link, &cpu->rq[i].rq);
-	cpu->rq[i].n++;
-	irq_spinlock_unlock(&(cpu->rq[i].lock), true);
+	if (thread->rt) {
+		/*
+		 * A running thread preempted by a higher-priority one keeps
+		 * its place at the head of its queue, unless it is
+		 * round-robin and its time slice has run out.
+		 */
+		bool head = (thread == THREAD) &&
+		    ((!thread->rt_rr) || (thread->ticks > 0));
+		
+		irq_spinlock_pass(&thread->lock, &cpu->rtq.lock);
+		preempt = rtq_insert(cpu, thread, head);
+		irq_spinlock_unlock(&cpu->rtq.lock, true);
+	} else if (thread->fair) {
+		/*
+		 * Charge the thread for the processor time
+		 * consumed since it was made ready last time.
+		 */
+		uint64_t cycles = thread->ucycles + thread->kcycles;
+		thread->vruntime += cycles - thread->vruntime_cycles;
+		thread->vruntime_cycles = cycles;
+		
+		irq_spinlock_pass(&thread->lock, &cpu->fairq.lock);
+		fairq_insert(cpu, thread);
+		irq_spinlock_unlock(&cpu->fairq.lock, true);
+	} else {
+		int i = (thread->priority < RQ_COUNT - 1) ?
+		    ++thread->priority : thread->priority;
+		
+		irq_spinlock_pass(&thread->lock, &(cpu->rq[i].lock));
+		
+		/*
+		 * Append thread to respective ready queue
+		 * on respective processor.
+		 */
+		
+		list_append(&thread->rq_link, &cpu->rq[i].rq);
+		cpu->rq[i].n++;
+		if (cpu->rq[i].n == 1)
+			rq_map_update(cpu, i);
+		irq_spinlock_unlock(&(cpu->rq[i].lock), true);
+	}
 	
 	atomic_inc(&nrdy);
-	// FIXME: Why is the avg value not used
-	// avg = atomic_get(&nrdy) / config.cpu_active;
 	atomic_inc(&cpu->nrdy);
+	
+	if (thread == THREAD)
+		sched_trace(SCHED_TRACE_PREEMPT, tid, 0, cpu);
+	else
+		sched_trace(SCHED_TRACE_WAKEUP, tid,
+		    THREAD ? THREAD->tid : 0, cpu);
+	
+	/*
+	 * An idle CPU would not notice the thread until the next
+	 * interrupt, neither would a CPU which has to preempt its
+	 * running thread in favour of a real-time one. The current
+	 * CPU is preempted by the caller calling scheduler_preempt().
+	 * The barrier orders the update of nrdy before the read of the
+	 * idle flag, pairing with the one in find_best_thread().
+	 */
+	memory_barrier();
+	if ((cpu != CPU) && ((cpu->idle) || (preempt)))
+		ipi_wakeup(cpu);
 }
 
 /** Create new thread
@@ -307,7 +503,9 @@ void thread_ready(thread_t *thread)
  * @param task      Task to which the thread belongs. The caller must
  *                  guarantee that the task won't cease to exist during the
  *                  call. The task's lock may not be held.
- * @param flags     Thread flags.
+ * @param flags     Thread flags. A real-time thread is created by
+ *                  THREAD_FLAG_RT_FIFO or THREAD_FLAG_RT_RR combined
+ *                  with THREAD_FLAG_RT_PRIORITY().
  * @param name      Symbolic name (a copy is made).
  *
  * @return New thread's structure on success, NULL on failure.
@@ -347,9 +545,16 @@ thread_t *thread_create(void (* func)(void *), void *arg, task_t *task,
 	thread->uncounted =
 	    ((flags & THREAD_FLAG_UNCOUNTED) == THREAD_FLAG_UNCOUNTED);
 	thread->priority = -1;          /* Start in rq[0] */
+	thread->fair = ((flags & THREAD_FLAG_FAIR) == THREAD_FLAG_FAIR);
+	thread->vruntime = 0;
+	thread->vruntime_cycles = 0;
+	avltree_node_initialize(&thread->fairq_node);
+	thread->rt = ((flags & (THREAD_FLAG_RT_FIFO | THREAD_FLAG_RT_RR)) != 0);
+	thread->rt_rr = ((flags & THREAD_FLAG_RT_RR) == THREAD_FLAG_RT_RR);
+	thread->rt_priority = min((unsigned int) flags >>
+	    THREAD_FLAG_RT_PRIORITY_SHIFT, RT_COUNT - 1);
 	thread->cpu = NULL;
-	thread->wired = false;
-	thread->stolen = false;
+	cpu_mask_all(&thread->affinity);
 	thread->uspace =
 	    ((flags & THREAD_FLAG_USPACE) == THREAD_FLAG_USPACE);
 	
@@ -361,6 +566,8 @@ thread_t *thread_create(void (* func)(void *), void *arg, task_t *task,
 	thread->sleep_queue = NULL;
 	thread->timeout_pending = false;
 	
+	thread->copy_failover = NULL;
+	
 	thread->interrupted = false;
 	thread->detached = false;
 	waitq_initialize(&thread->join_wq);
@@ -403,11 +610,11 @@ void thread_destroy(thread_t *thread, bool irq_res)
 		thread->cpu->fpu_owner = NULL;
 	irq_spinlock_unlock(&thread->cpu->lock, false);
 	
-	irq_spinlock_pass(&thread->lock, &threads_lock);
+	irq_spinlock_pass(&thread->lock, &thread->task->lock);
 	
+	irq_rwlock_write_lock(&threads_lock, false);
 	avltree_delete(&threads_tree, &thread->threads_tree_node);
-	
-	irq_spinlock_pass(&threads_lock, &thread->task->lock);
+	irq_rwlock_write_unlock(&threads_lock, false);
 	
 	/*
 	 * Detach from the containing task.
@@ -447,13 +654,14 @@ void thread_attach(thread_t *thread, task_t *task)
 	
 	list_append(&thread->th_link, &task->threads);
 	
-	irq_spinlock_pass(&task->lock, &threads_lock);
-	
 	/*
 	 * Register this thread in the system-wide list.
 	 */
+	irq_rwlock_write_lock(&threads_lock, false);
 	avltree_insert(&threads_tree, &thread->threads_tree_node);
-	irq_spinlock_unlock(&threads_lock, true);
+	irq_rwlock_write_unlock(&threads_lock, false);
+	
+	irq_spinlock_unlock(&task->lock, true);
 }
 
 /** Terminate thread.
@@ -471,11 +679,10 @@ void thread_exit(void)
 			 * still has not exited. With the exception of the
 			 * moment the task was created, new userspace threads
 			 * can only be created by threads of the same task.
-			 * We are safe to perform cleanup.
 			 *
 			 */
-			futex_cleanup();
-			LOG("Cleanup of task %" PRIu64" completed.", TASK->taskid);
+			LOG("Last userspace thread of task %" PRIu64 " exited.",
+			    TASK->taskid);
 		}
 	}
 	
@@ -675,7 +882,7 @@ static bool thread_walker(avltree_node_t *node, void *arg)
 void thread_print_list(bool additional)
 {
 	/* Messing with thread structures, avoid deadlock */
-	irq_spinlock_lock(&threads_lock, true);
+	irq_rwlock_read_lock(&threads_lock, true);
 	
 #ifdef __32_BITS__
 	if (additional)
@@ -697,7 +904,7 @@ void thread_print_list(bool additional)
 	
 	avltree_walk(&threads_tree, thread_walker, &additional);
 	
-	irq_spinlock_unlock(&threads_lock, true);
+	irq_rwlock_read_unlock(&threads_lock, true);
 }
 
 /** Check whether thread exists.
@@ -713,7 +920,7 @@ void thread_print_list(bool additional)
 bool thread_exists(thread_t *thread)
 {
 	ASSERT(interrupts_disabled());
-	ASSERT(irq_spinlock_locked(&threads_lock));
+	ASSERT(irq_rwlock_locked(&threads_lock));
 
 	avltree_node_t *node =
 	    avltree_search(&threads_tree, (avltree_key_t) ((uintptr_t) thread));
@@ -771,7 +978,7 @@ static bool thread_search_walker(avltree_node_t *node, void *arg)
 thread_t *thread_find_by_id(thread_id_t thread_id)
 {
 	ASSERT(interrupts_disabled());
-	ASSERT(irq_spinlock_locked(&threads_lock));
+	ASSERT(irq_rwlock_locked(&threads_lock));
 	
 	thread_iterator_t iterator;
 	
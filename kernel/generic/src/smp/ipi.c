@@ -38,7 +38,12 @@
 #ifdef CONFIG_SMP
 
 #include <smp/ipi.h>
+#include <arch/interrupt.h>
+#include <arch/asm.h>
 #include <config.h>
+#include <cpu.h>
+#include <arch.h>
+#include <debug.h>
 
 /** Broadcast IPI message
  *
@@ -59,6 +64,41 @@ void ipi_broadcast(int ipi)
 		ipi_broadcast_arch(ipi);
 }
 
+/** Wake up an idle CPU or make it reschedule
+ *
+ * Make a CPU sleeping in cpu_sleep() look for ready threads
+ * without waiting for the next clock tick. A CPU asked to preempt
+ * its running thread does so on return from the interrupt.
+ *
+ * Only the target CPU is interrupted, using a vector which
+ * is reserved for this purpose. Architectures which cannot
+ * address a single CPU leave the target to its next clock tick.
+ *
+ * @param cpu CPU to wake up.
+ *
+ */
+void ipi_wakeup(cpu_t *cpu)
+{
+	ASSERT(cpu != CPU);
+	
+	if (config.cpu_count > 1) {
+		ipl_t ipl = interrupts_disable();
+		ipi_unicast_arch(cpu, VECTOR_WAKEUP_IPI);
+		interrupts_restore(ipl);
+	}
+}
+
+/** Handle the wakeup IPI
+ *
+ * The interrupt itself ends cpu_sleep() and the return
+ * from it preempts the running thread if needed, so there
+ * is nothing left to do.
+ *
+ */
+void ipi_wakeup_recv(void)
+{
+}
+
 #endif /* CONFIG_SMP */
 
 /** @}
@@ -33,11 +33,22 @@
 /**
  * @file
  * @brief	Condition variables.
+ *
+ * Waking up waiters which are to lock the mutex held by the waker just
+ * makes them contend for the mutex. When the waker holds the passive
+ * mutex of the waiters, the waiters are moved to the wait queue of the
+ * mutex instead (wait morphing) and woken up one by one as the mutex
+ * gets unlocked. Otherwise a broadcast wakes up the first waiter only
+ * and each woken waiter wakes up the next one once it has locked the
+ * mutex again.
  */
 
 #include <synch/condvar.h>
 #include <synch/mutex.h>
 #include <synch/waitq.h>
+#include <proc/scheduler.h>
+#include <adt/list.h>
+#include <arch/asm.h>
 #include <arch.h>
 
 /** Initialize condition variable.
@@ -47,6 +58,39 @@
 void condvar_initialize(condvar_t *cv)
 {
 	waitq_initialize(&cv->wq);
+	cv->mtx = NULL;
+	cv->chain = 0;
+}
+
+/** Wake up waiters of a condition variable.
+ *
+ * @param cv		Condition variable.
+ * @param mode		WAKEUP_FIRST or WAKEUP_ALL.
+ */
+static void condvar_wakeup(condvar_t *cv, wakeup_mode_t mode)
+{
+	irq_spinlock_lock(&cv->wq.lock, true);
+	
+	/*
+	 * The mutex is only known to exist as long
+	 * as there are threads waiting to lock it.
+	 */
+	if ((!list_empty(&cv->wq.sleepers)) && (cv->mtx != NULL) &&
+	    (mutex_requeue(cv->mtx, &cv->wq, mode))) {
+		irq_spinlock_unlock(&cv->wq.lock, true);
+		return;
+	}
+	
+	if ((mode == WAKEUP_ALL) && (!list_empty(&cv->wq.sleepers))) {
+		cv->chain = list_count(&cv->wq.sleepers) - 1;
+		mode = WAKEUP_FIRST;
+	}
+	
+	_waitq_wakeup_unsafe(&cv->wq, mode);
+	irq_spinlock_unlock(&cv->wq.lock, true);
+	
+	if (!interrupts_disabled())
+		scheduler_preempt();
 }
 
 /** Signal the condition has become true to the first waiting thread by waking
@@ -56,7 +100,7 @@ void condvar_initialize(condvar_t *cv)
  */
 void condvar_signal(condvar_t *cv)
 {
-	waitq_wakeup(&cv->wq, WAKEUP_FIRST);
+	condvar_wakeup(cv, WAKEUP_FIRST);
 }
 
 /** Signal the condition has become true to all waiting threads by waking
@@ -66,7 +110,28 @@ void condvar_signal(condvar_t *cv)
  */
 void condvar_broadcast(condvar_t *cv)
 {
-	waitq_wakeup(&cv->wq, WAKEUP_ALL);
+	condvar_wakeup(cv, WAKEUP_ALL);
+}
+
+/** Wake up the next waiter of a broadcast.
+ *
+ * @param cv		Condition variable.
+ */
+static void condvar_chain(condvar_t *cv)
+{
+	irq_spinlock_lock(&cv->wq.lock, true);
+	
+	if (cv->chain > 0) {
+		if (list_empty(&cv->wq.sleepers)) {
+			/* The waiters have timed out or have been interrupted. */
+			cv->chain = 0;
+		} else {
+			cv->chain--;
+			_waitq_wakeup_unsafe(&cv->wq, WAKEUP_FIRST);
+		}
+	}
+	
+	irq_spinlock_unlock(&cv->wq.lock, true);
 }
 
 /** Wait for the condition becoming true.
@@ -89,13 +154,24 @@ int _condvar_wait_timeout(condvar_t *cv, mutex_t *mtx, uint32_t usec, int flags)
 	ipl_t ipl;
 
 	ipl = waitq_sleep_prepare(&cv->wq);
+	
+	/* Waiters using different mutexes cannot be moved to one of them. */
+	if (list_empty(&cv->wq.sleepers))
+		cv->mtx = mtx;
+	else if (cv->mtx != mtx)
+		cv->mtx = NULL;
+	
 	mutex_unlock(mtx);
 
 	cv->wq.missed_wakeups = 0;	/* Enforce blocking. */
 	rc = waitq_sleep_timeout_unsafe(&cv->wq, usec, flags);
 
-	mutex_lock(mtx);
+	mutex_lock_requeued(mtx);
 	waitq_sleep_finish(&cv->wq, rc, ipl);
+	
+	/* Pass a broadcast on, the mutex is ours for a while. */
+	if (cv->chain > 0)
+		condvar_chain(cv);
 
 	return rc;
 }
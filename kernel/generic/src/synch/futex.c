@@ -33,118 +33,629 @@
 /**
  * @file
  * @brief	Kernel backend for futexes.
+ *
+ * A futex is identified by the physical address of its word, so that
+ * tasks sharing the memory share the futex. User space manipulates
+ * the word atomically and enters the kernel only to wait for a change
+ * or to wake up waiters, i.e. only under contention.
+ *
+ * Waiters are kept in a hash table of buckets indexed by the physical
+ * address, each protected by its own spinlock. The number of buckets
+ * grows with the number of processors. Every waiter sleeps in its own
+ * wait queue, which lets wakers pick any number of waiters and lets
+ * requeue move waiters between buckets. The value of the word is
+ * checked under the bucket lock, so a waker changing the word and
+ * then taking the bucket lock cannot miss a waiter.
+ *
+ * The virtual address of a futex word is translated anew by every
+ * operation, so that a word which has been remapped meanwhile is always
+ * found in its current frame. The frame stays referenced until the
+ * operation, including a wait, is over, so that its physical address
+ * cannot be reused by another futex in the meantime.
  */
 
 #include <synch/futex.h>
-#include <synch/mutex.h>
 #include <synch/spinlock.h>
+#include <synch/waitq.h>
 #include <mm/frame.h>
 #include <mm/page.h>
 #include <mm/slab.h>
+#include <mm/km.h>
+#include <mm/as.h>
+#include <mm/copy.h>
 #include <proc/thread.h>
 #include <proc/task.h>
 #include <genarch/mm/page_pt.h>
 #include <genarch/mm/page_ht.h>
-#include <adt/hash_table.h>
 #include <adt/list.h>
+#include <config.h>
 #include <arch.h>
 #include <align.h>
 #include <panic.h>
 #include <errno.h>
 #include <print.h>
 
-#define FUTEX_HT_SIZE	1024	/* keep it a power of 2 */
+/** Minimal number of buckets (keep it a power of 2). */
+#define FUTEX_BUCKETS_MIN  256
 
-static size_t futex_ht_hash(sysarg_t *key);
-static bool futex_ht_compare(sysarg_t *key, size_t keys, link_t *item);
-static void futex_ht_remove_callback(link_t *item);
+/** Number of buckets per processor. */
+#define FUTEX_BUCKETS_PER_CPU  64
 
-/**
- * Mutex protecting global futex hash table.
- * It is also used to serialize access to all futex_t structures.
- * Must be acquired before the task futex B+tree lock.
- */
-static mutex_t futex_ht_lock;
+#define FUTEX_OP_OP(op)      (((op) >> 28) & 0xf)
+#define FUTEX_OP_CMP(op)     (((op) >> 24) & 0xf)
+#define FUTEX_OP_OPARG(op)   (((op) >> 12) & 0xfff)
+#define FUTEX_OP_CMPARG(op)  ((op) & 0xfff)
 
-/** Futex hash table. */
-static hash_table_t futex_ht;
+/** Futex word resolved for the duration of an operation. */
+typedef struct {
+	/** Physical address of the futex word. */
+	uintptr_t paddr;
+	/** Kernel address of the futex word. */
+	atomic_t *word;
+	/** The frame of the word is referenced. */
+	bool referenced;
+	/** The word is accessed through a temporary kernel mapping. */
+	bool mapped;
+} futex_t;
 
-/** Futex hash table operations. */
-static hash_table_operations_t futex_ht_ops = {
-	.hash = futex_ht_hash,
-	.compare = futex_ht_compare,
-	.remove_callback = futex_ht_remove_callback
-};
+/** Bucket of waiters. */
+typedef struct {
+	IRQ_SPINLOCK_DECLARE(lock);
+	/** Waiters for the futexes hashed to this bucket. */
+	list_t waiters;
+} futex_bucket_t;
+
+/** Thread waiting for a futex. */
+typedef struct {
+	/** Link in the bucket. */
+	link_t link;
+	/** Physical address of the futex word waited for. */
+	uintptr_t paddr;
+	/** Bucket the waiter is queued in, changed by requeue. */
+	futex_bucket_t *volatile bucket;
+	/** Wait queue the waiter sleeps in. */
+	waitq_t wq;
+} futex_waiter_t;
+
+/** Buckets of waiters. */
+static futex_bucket_t *futex_buckets;
+
+/** Number of buckets minus one. */
+static size_t futex_buckets_mask;
 
 /** Initialize futex subsystem. */
 void futex_init(void)
 {
-	mutex_initialize(&futex_ht_lock, MUTEX_PASSIVE);
-	hash_table_create(&futex_ht, FUTEX_HT_SIZE, 1, &futex_ht_ops);
+	size_t count = FUTEX_BUCKETS_MIN;
+	while (count < config.cpu_count * FUTEX_BUCKETS_PER_CPU)
+		count <<= 1;
+	
+	futex_buckets = (futex_bucket_t *) malloc(sizeof(futex_bucket_t) * count,
+	    FRAME_ATOMIC);
+	if (!futex_buckets)
+		panic("Cannot allocate futex buckets.");
+	
+	for (size_t i = 0; i < count; i++) {
+		irq_spinlock_initialize(&futex_buckets[i].lock, "futex_bucket.lock");
+		list_initialize(&futex_buckets[i].waiters);
+	}
+	
+	futex_buckets_mask = count - 1;
 }
 
-/** Compute hash index into futex hash table.
+/** Resolve the futex word of the current task at a virtual address.
+ *
+ * A page of the task which has not been touched yet is faulted in by
+ * reading the word through the user copy path. The translation is then
+ * looked up under the page table lock and the frame is referenced. The
+ * word is accessed through the identity mapping if the frame has one,
+ * and through a temporary kernel mapping otherwise.
  *
- * @param key		Address where the key (i.e. physical address of futex
- *			counter) is stored.
+ * Kernel threads pass kernel addresses, which must be identity mapped.
  *
- * @return		Index into futex hash table.
+ * @param uaddr		Virtual address of the futex word.
+ * @param futex		Futex to be filled in. It must be released by
+ *			futex_put().
+ *
+ * @return		EOK on success, EINVAL if the address is not aligned
+ *			or not backed by writable ordinary memory, ENOENT if
+ *			it is not mapped.
  */
-size_t futex_ht_hash(sysarg_t *key)
+static int futex_get(uintptr_t uaddr, futex_t *futex)
 {
-	return (*key & (FUTEX_HT_SIZE - 1));
+	futex->paddr = 0;
+	futex->word = NULL;
+	futex->referenced = false;
+	futex->mapped = false;
+	
+	if (!IS_ALIGNED(uaddr, sizeof(atomic_t)))
+		return EINVAL;
+	
+	if (AS == AS_KERNEL) {
+		if (km_is_non_identity(uaddr))
+			return EINVAL;
+		
+		futex->paddr = KA2PA(uaddr);
+		futex->word = (atomic_t *) uaddr;
+		return EOK;
+	}
+	
+	uintptr_t page = ALIGN_DOWN(uaddr, PAGE_SIZE);
+	uintptr_t frame;
+	
+	while (true) {
+		atomic_count_t value;
+		if (copy_from_uspace(&value, (void *) uaddr, sizeof(value)) != EOK)
+			return ENOENT;
+		
+		page_table_lock(AS, true);
+		
+		pte_t *pte = page_mapping_find(AS, page, false);
+		if ((pte) && (PTE_VALID(pte)) && (PTE_PRESENT(pte))) {
+			if (!PTE_WRITABLE(pte)) {
+				page_table_unlock(AS, true);
+				return EINVAL;
+			}
+			
+			frame = PTE_GET_FRAME(pte);
+			bool referenced = frame_reference_try_add(ADDR2PFN(frame));
+			
+			page_table_unlock(AS, true);
+			
+			if (!referenced)
+				return EINVAL;
+			
+			break;
+		}
+		
+		/* The page has been unmapped again since it was faulted in. */
+		page_table_unlock(AS, true);
+	}
+	
+	futex->paddr = frame + (uaddr - page);
+	futex->referenced = true;
+	
+	uintptr_t limit = KA2PA(config.identity_base) + config.identity_size;
+	if (futex->paddr + sizeof(atomic_t) <= limit) {
+		futex->word = (atomic_t *) PA2KA(futex->paddr);
+	} else {
+		futex->word = (atomic_t *) km_map(futex->paddr, sizeof(atomic_t),
+		    PAGE_READ | PAGE_WRITE | PAGE_CACHEABLE);
+		futex->mapped = true;
+	}
+	
+	return EOK;
+}
+
+/** Release a futex resolved by futex_get().
+ *
+ * @param futex		Futex to be released.
+ */
+static void futex_put(futex_t *futex)
+{
+	if (futex->mapped)
+		km_unmap((uintptr_t) futex->word, sizeof(atomic_t));
+	
+	if (futex->referenced)
+		frame_free(ALIGN_DOWN(futex->paddr, FRAME_SIZE), 1);
 }
 
-/** Compare futex hash table item with a key.
+/** Find the bucket of a futex.
  *
- * @param key		Address where the key (i.e. physical address of futex
- *			counter) is stored.
+ * @param paddr		Physical address of the futex word.
  *
- * @return		True if the item matches the key. False otherwise.
+ * @return		Bucket.
  */
-bool futex_ht_compare(sysarg_t *key, size_t keys, link_t *item)
+static futex_bucket_t *futex_bucket(uintptr_t paddr)
 {
-	futex_t *futex;
+	size_t hash = (paddr / sizeof(atomic_t)) ^ (paddr >> PAGE_WIDTH);
+	return &futex_buckets[hash & futex_buckets_mask];
+}
+
+/** Lock two buckets.
+ *
+ * The buckets are locked in the order of their addresses.
+ *
+ * @param bucket1	First bucket.
+ * @param bucket2	Second bucket, possibly the same as the first one.
+ */
+static void futex_buckets_lock(futex_bucket_t *bucket1,
+    futex_bucket_t *bucket2)
+{
+	if (bucket1 == bucket2) {
+		irq_spinlock_lock(&bucket1->lock, true);
+	} else if (bucket1 < bucket2) {
+		irq_spinlock_lock(&bucket1->lock, true);
+		irq_spinlock_lock(&bucket2->lock, false);
+	} else {
+		irq_spinlock_lock(&bucket2->lock, true);
+		irq_spinlock_lock(&bucket1->lock, false);
+	}
+}
 
-	ASSERT(keys == 1);
+/** Unlock two buckets locked by futex_buckets_lock().
+ *
+ * @param bucket1	First bucket.
+ * @param bucket2	Second bucket, possibly the same as the first one.
+ */
+static void futex_buckets_unlock(futex_bucket_t *bucket1,
+    futex_bucket_t *bucket2)
+{
+	if (bucket1 == bucket2) {
+		irq_spinlock_unlock(&bucket1->lock, true);
+	} else if (bucket1 < bucket2) {
+		irq_spinlock_unlock(&bucket2->lock, false);
+		irq_spinlock_unlock(&bucket1->lock, true);
+	} else {
+		irq_spinlock_unlock(&bucket1->lock, false);
+		irq_spinlock_unlock(&bucket2->lock, true);
+	}
+}
+
+/** Wake up waiters for a futex.
+ *
+ * The bucket must be locked. The waiters are woken up with the bucket
+ * still locked, so that they cannot leave while being woken up.
+ *
+ * @param bucket	Bucket of the futex.
+ * @param paddr		Physical address of the futex word.
+ * @param count		Maximal number of waiters to wake up.
+ *
+ * @return		Number of waiters woken up.
+ */
+static size_t futex_bucket_wake(futex_bucket_t *bucket, uintptr_t paddr,
+    size_t count)
+{
+	size_t woken = 0;
+	link_t *cur = list_first(&bucket->waiters);
+	
+	while ((cur != NULL) && (woken < count)) {
+		link_t *next = list_next(cur, &bucket->waiters);
+		futex_waiter_t *waiter =
+		    list_get_instance(cur, futex_waiter_t, link);
+		
+		if (waiter->paddr == paddr) {
+			list_remove(&waiter->link);
+			waitq_wakeup(&waiter->wq, WAKEUP_FIRST);
+			woken++;
+		}
+		
+		cur = next;
+	}
+	
+	return woken;
+}
 
-	futex = hash_table_get_instance(item, futex_t, ht_link);
-	return *key == futex->paddr;
+/** Lock the bucket a waiter is currently queued in.
+ *
+ * @param waiter	Waiter.
+ *
+ * @return		Locked bucket.
+ */
+static futex_bucket_t *futex_waiter_lock(futex_waiter_t *waiter)
+{
+	while (true) {
+		futex_bucket_t *bucket = waiter->bucket;
+		
+		irq_spinlock_lock(&bucket->lock, true);
+		if (bucket == waiter->bucket)
+			return bucket;
+		
+		/* The waiter has been requeued meanwhile. */
+		irq_spinlock_unlock(&bucket->lock, true);
+	}
 }
 
-/** Callback for removal items from futex hash table.
+/** Wait for a futex.
+ *
+ * @param uaddr		Virtual address of the futex word.
+ * @param expected	Value of the futex word to wait on.
+ * @param usec		Timeout in microseconds, zero for no timeout.
  *
- * @param item		Item removed from the hash table.
+ * @return		EOK if woken up, EAGAIN if the futex word does not
+ *			have the expected value, ETIMEOUT or EINTR if the
+ *			wait has been cut short, or an error of futex lookup.
  */
-void futex_ht_remove_callback(link_t *item)
+int futex_wait(uintptr_t uaddr, atomic_count_t expected, uint32_t usec)
 {
-	futex_t *futex;
+	futex_t futex;
+	int rc = futex_get(uaddr, &futex);
+	if (rc != EOK)
+		return rc;
+	
+	futex_waiter_t waiter;
+	link_initialize(&waiter.link);
+	waiter.paddr = futex.paddr;
+	waiter.bucket = futex_bucket(futex.paddr);
+	waitq_initialize(&waiter.wq);
+	
+	irq_spinlock_lock(&waiter.bucket->lock, true);
+	
+	if (atomic_get(futex.word) != expected) {
+		irq_spinlock_unlock(&waiter.bucket->lock, true);
+		futex_put(&futex);
+		return EAGAIN;
+	}
+	
+	list_append(&waiter.link, &waiter.bucket->waiters);
+	irq_spinlock_unlock(&waiter.bucket->lock, true);
+	
+	rc = waitq_sleep_timeout(&waiter.wq, usec, SYNCH_FLAGS_INTERRUPTIBLE);
+	
+	/*
+	 * Wait until the waker is done with our wait queue
+	 * and leave the bucket if nobody has woken us up.
+	 */
+	futex_bucket_t *bucket = futex_waiter_lock(&waiter);
+	bool woken = !link_used(&waiter.link);
+	if (!woken)
+		list_remove(&waiter.link);
+	irq_spinlock_unlock(&bucket->lock, true);
+	
+	futex_put(&futex);
+	
+	if (woken)
+		return EOK;
+	
+	return (rc == ESYNCH_TIMEOUT) ? ETIMEOUT : EINTR;
+}
 
-	futex = hash_table_get_instance(item, futex_t, ht_link);
-	free(futex);
+/** Wake up waiters for a futex.
+ *
+ * @param uaddr		Virtual address of the futex word.
+ * @param count		Maximal number of waiters to wake up.
+ *
+ * @return		Number of waiters woken up or an error of futex lookup.
+ */
+int futex_wake(uintptr_t uaddr, size_t count)
+{
+	futex_t futex;
+	int rc = futex_get(uaddr, &futex);
+	if (rc != EOK)
+		return rc;
+	
+	futex_bucket_t *bucket = futex_bucket(futex.paddr);
+	
+	irq_spinlock_lock(&bucket->lock, true);
+	size_t woken = futex_bucket_wake(bucket, futex.paddr, count);
+	irq_spinlock_unlock(&bucket->lock, true);
+	
+	futex_put(&futex);
+	
+	return (int) woken;
 }
 
-/** Remove references from futexes known to the current task. */
-void futex_cleanup(void)
+/** Wake up waiters for a futex and move the others to another futex.
+ *
+ * @param uaddr		Virtual address of the futex word.
+ * @param expected	Expected value of the futex word.
+ * @param nr_wake	Maximal number of waiters to wake up.
+ * @param uaddr2	Virtual address of the futex word to requeue to.
+ * @param nr_requeue	Maximal number of waiters to requeue.
+ *
+ * @return		Number of waiters woken up and requeued, EAGAIN if
+ *			the futex word does not have the expected value,
+ *			or an error of futex lookup.
+ */
+int futex_requeue(uintptr_t uaddr, atomic_count_t expected, size_t nr_wake,
+    uintptr_t uaddr2, size_t nr_requeue)
 {
-	mutex_lock(&futex_ht_lock);
-	mutex_lock(&TASK->futexes_lock);
+	futex_t futex;
+	int rc = futex_get(uaddr, &futex);
+	if (rc != EOK)
+		return rc;
+	
+	futex_t futex2;
+	rc = futex_get(uaddr2, &futex2);
+	if (rc != EOK) {
+		futex_put(&futex);
+		return rc;
+	}
+	
+	futex_bucket_t *bucket = futex_bucket(futex.paddr);
+	futex_bucket_t *bucket2 = futex_bucket(futex2.paddr);
+	
+	futex_buckets_lock(bucket, bucket2);
+	
+	if (atomic_get(futex.word) != expected) {
+		futex_buckets_unlock(bucket, bucket2);
+		futex_put(&futex2);
+		futex_put(&futex);
+		return EAGAIN;
+	}
+	
+	size_t woken = futex_bucket_wake(bucket, futex.paddr, nr_wake);
+	size_t requeued = 0;
+	
+	link_t *cur = (futex.paddr != futex2.paddr) ?
+	    list_first(&bucket->waiters) : NULL;
+	
+	while ((cur != NULL) && (requeued < nr_requeue)) {
+		link_t *next = list_next(cur, &bucket->waiters);
+		futex_waiter_t *waiter =
+		    list_get_instance(cur, futex_waiter_t, link);
+		
+		if (waiter->paddr == futex.paddr) {
+			list_remove(&waiter->link);
+			waiter->paddr = futex2.paddr;
+			waiter->bucket = bucket2;
+			list_append(&waiter->link, &bucket2->waiters);
+			requeued++;
+		}
+		
+		cur = next;
+	}
+	
+	futex_buckets_unlock(bucket, bucket2);
+	
+	futex_put(&futex2);
+	futex_put(&futex);
+	
+	return (int) (woken + requeued);
+}
 
-	list_foreach(TASK->futexes.leaf_list, leaf_link, btree_node_t, node) {
-		unsigned int i;
+/** Wake up waiters for a futex and conditionally for another one.
+ *
+ * The second futex word is atomically modified as requested by the
+ * operation. The waiters of the second futex are woken up only if
+ * its former value satisfies the comparison of the operation. The
+ * values are compared as unsigned numbers.
+ *
+ * @param uaddr		Virtual address of the futex word.
+ * @param nr_wake	Maximal number of waiters to wake up.
+ * @param uaddr2	Virtual address of the second futex word.
+ * @param nr_wake2	Maximal number of waiters of the second futex
+ *			to wake up.
+ * @param op		Operation encoded by FUTEX_OP().
+ *
+ * @return		Number of waiters woken up, EINVAL for an invalid
+ *			operation, or an error of futex lookup.
+ */
+int futex_wake_op(uintptr_t uaddr, size_t nr_wake, uintptr_t uaddr2,
+    size_t nr_wake2, uint32_t op)
+{
+	if ((FUTEX_OP_OP(op) > FUTEX_OP_XOR) ||
+	    (FUTEX_OP_CMP(op) > FUTEX_OP_CMP_GE))
+		return EINVAL;
+	
+	futex_t futex;
+	int rc = futex_get(uaddr, &futex);
+	if (rc != EOK)
+		return rc;
+	
+	futex_t futex2;
+	rc = futex_get(uaddr2, &futex2);
+	if (rc != EOK) {
+		futex_put(&futex);
+		return rc;
+	}
+	
+	futex_bucket_t *bucket = futex_bucket(futex.paddr);
+	futex_bucket_t *bucket2 = futex_bucket(futex2.paddr);
+	
+	futex_buckets_lock(bucket, bucket2);
+	
+	atomic_count_t arg = FUTEX_OP_OPARG(op);
+	atomic_count_t old;
+	atomic_count_t new;
+	
+	do {
+		old = atomic_get(futex2.word);
 		
-		for (i = 0; i < node->keys; i++) {
-			futex_t *ftx;
-			uintptr_t paddr = node->key[i];
-			
-			ftx = (futex_t *) node->value[i];
-			if (--ftx->refcount == 0)
-				hash_table_remove(&futex_ht, &paddr, 1);
+		switch (FUTEX_OP_OP(op)) {
+		case FUTEX_OP_SET:
+			new = arg;
+			break;
+		case FUTEX_OP_ADD:
+			new = old + arg;
+			break;
+		case FUTEX_OP_OR:
+			new = old | arg;
+			break;
+		case FUTEX_OP_ANDN:
+			new = old & ~arg;
+			break;
+		default:
+			new = old ^ arg;
+			break;
 		}
+	} while (!atomic_cas(futex2.word, old, new));
+	
+	atomic_count_t cmparg = FUTEX_OP_CMPARG(op);
+	bool cond;
+	
+	switch (FUTEX_OP_CMP(op)) {
+	case FUTEX_OP_CMP_EQ:
+		cond = (old == cmparg);
+		break;
+	case FUTEX_OP_CMP_NE:
+		cond = (old != cmparg);
+		break;
+	case FUTEX_OP_CMP_LT:
+		cond = (old < cmparg);
+		break;
+	case FUTEX_OP_CMP_LE:
+		cond = (old <= cmparg);
+		break;
+	case FUTEX_OP_CMP_GT:
+		cond = (old > cmparg);
+		break;
+	default:
+		cond = (old >= cmparg);
+		break;
 	}
 	
-	mutex_unlock(&TASK->futexes_lock);
-	mutex_unlock(&futex_ht_lock);
+	size_t woken = futex_bucket_wake(bucket, futex.paddr, nr_wake);
+	if (cond)
+		woken += futex_bucket_wake(bucket2, futex2.paddr, nr_wake2);
+	
+	futex_buckets_unlock(bucket, bucket2);
+	
+	futex_put(&futex2);
+	futex_put(&futex);
+	
+	return (int) woken;
+}
+
+/** Wait for a futex (system call).
+ *
+ * @param uaddr		Virtual address of the futex word.
+ * @param expected	Value of the futex word to wait on.
+ * @param usec		Timeout in microseconds, zero for no timeout.
+ *
+ * @return		Result of futex_wait().
+ */
+sysarg_t sys_futex_wait(uintptr_t uaddr, sysarg_t expected, sysarg_t usec)
+{
+	return (sysarg_t) futex_wait(uaddr, (atomic_count_t) expected,
+	    (uint32_t) usec);
+}
+
+/** Wake up waiters for a futex (system call).
+ *
+ * @param uaddr		Virtual address of the futex word.
+ * @param count		Maximal number of waiters to wake up.
+ *
+ * @return		Result of futex_wake().
+ */
+sysarg_t sys_futex_wake(uintptr_t uaddr, sysarg_t count)
+{
+	return (sysarg_t) futex_wake(uaddr, (size_t) count);
+}
+
+/** Wake up and requeue waiters for a futex (system call).
+ *
+ * @param uaddr		Virtual address of the futex word.
+ * @param expected	Expected value of the futex word.
+ * @param nr_wake	Maximal number of waiters to wake up.
+ * @param uaddr2	Virtual address of the futex word to requeue to.
+ * @param nr_requeue	Maximal number of waiters to requeue.
+ *
+ * @return		Result of futex_requeue().
+ */
+sysarg_t sys_futex_requeue(uintptr_t uaddr, sysarg_t expected,
+    sysarg_t nr_wake, uintptr_t uaddr2, sysarg_t nr_requeue)
+{
+	return (sysarg_t) futex_requeue(uaddr, (atomic_count_t) expected,
+	    (size_t) nr_wake, uaddr2, (size_t) nr_requeue);
+}
+
+/** Wake up waiters for two futexes (system call).
+ *
+ * @param uaddr		Virtual address of the futex word.
+ * @param nr_wake	Maximal number of waiters to wake up.
+ * @param uaddr2	Virtual address of the second futex word.
+ * @param nr_wake2	Maximal number of waiters of the second futex
+ *			to wake up.
+ * @param op		Operation encoded by FUTEX_OP().
+ *
+ * @return		Result of futex_wake_op().
+ */
+sysarg_t sys_futex_wake_op(uintptr_t uaddr, sysarg_t nr_wake,
+    uintptr_t uaddr2, sysarg_t nr_wake2, sysarg_t op)
+{
+	return (sysarg_t) futex_wake_op(uaddr, (size_t) nr_wake, uaddr2,
+	    (size_t) nr_wake2, (uint32_t) op);
 }
 
 /** @}
@@ -0,0 +1,415 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup sync
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Lock contention statistics.
+ *
+ * Locks are grouped into classes. Spinlocks are classified by their
+ * name, mutexes and semaphores by the code which initialized them.
+ * Each processor counts acquisitions, contended acquisitions and the
+ * cycles spent waiting per class, and keeps the callers which had to
+ * wait most often. The counters of a processor are only modified by
+ * the processor itself with interrupts disabled, so no locking is
+ * needed, which is essential since the statistics are collected by
+ * the spinlocks themselves. Readers sum up the counters of all
+ * processors without synchronization, the result is approximate.
+ *
+ * The table of classes is filled in lock-free on the first acquisition
+ * of a lock of the class and is never shrunk. Acquisitions of classes
+ * which no longer fit are only counted as overflows.
+ */
+
+#include <synch/lockstat.h>
+#include <sysinfo/sysinfo.h>
+#include <arch/barrier.h>
+#include <arch/asm.h>
+#include <mm/slab.h>
+#include <mm/frame.h>
+#include <symtab.h>
+#include <memstr.h>
+#include <atomic.h>
+#include <config.h>
+#include <print.h>
+#include <str.h>
+#include <arch.h>
+#include <cpu.h>
+
+/** Caller waiting for a lock class. */
+typedef struct {
+	uintptr_t caller;
+	uint64_t count;
+} lockstat_caller_t;
+
+/** Statistics of a lock class on a single processor. */
+typedef struct {
+	uint64_t acquisitions;
+	uint64_t contended;
+	uint64_t wait_cycles;
+	uint64_t max_wait;
+	lockstat_caller_t callers[LOCKSTAT_CALLERS];
+} lockstat_t;
+
+/** Statistics of all lock classes on a single processor. */
+typedef struct {
+	lockstat_t class[LOCKSTAT_CLASSES];
+} lockstat_cpu_t;
+
+/** Lock class. */
+typedef struct {
+	/** Spinlock name or initialization site, zero if unused. */
+	atomic_t key;
+	/** Kind of the locks, zero until the class is set up. */
+	volatile lockstat_kind_t kind;
+} lockstat_class_t;
+
+static lockstat_class_t classes[LOCKSTAT_CLASSES];
+
+/** Statistics of all processors, allocated by lockstat_init(). */
+static lockstat_cpu_t *stats = NULL;
+
+/** Number of acquisitions of locks whose class did not fit. */
+static atomic_t overflows;
+
+static const char *lockstat_kinds[] = {
+	"?",
+	"spin",
+	"mutex",
+	"sem"
+};
+
+/** Find or set up the class of a lock.
+ *
+ * @param kind Kind of the lock.
+ * @param key  Spinlock name or initialization site.
+ *
+ * @return Index of the class or LOCKSTAT_CLASSES if the table is full.
+ *
+ */
+static size_t lockstat_class(lockstat_kind_t kind, uintptr_t key)
+{
+	size_t start = (key ^ (key >> 7) ^ (key >> 15));
+	
+	for (size_t i = 0; i < LOCKSTAT_CLASSES; i++) {
+		size_t idx = (start + i) & (LOCKSTAT_CLASSES - 1);
+		lockstat_class_t *class = &classes[idx];
+		atomic_count_t cur = atomic_get(&class->key);
+		
+		if (cur == 0) {
+			if (atomic_cas(&class->key, 0, (atomic_count_t) key)) {
+				class->kind = kind;
+				return idx;
+			}
+			
+			cur = atomic_get(&class->key);
+		}
+		
+		if (cur == (atomic_count_t) key)
+			return idx;
+	}
+	
+	return LOCKSTAT_CLASSES;
+}
+
+/** Account a caller.
+ *
+ * Keep the callers with the highest counts. A caller which is not
+ * in the set replaces the one with the lowest count and inherits
+ * the count, so the counts are upper bounds.
+ *
+ * @param callers Set of LOCKSTAT_CALLERS callers.
+ * @param caller  Caller to account.
+ * @param count   Number of times to account the caller.
+ *
+ */
+static void lockstat_caller(lockstat_caller_t *callers, uintptr_t caller,
+    uint64_t count)
+{
+	lockstat_caller_t *min = &callers[0];
+	
+	for (unsigned int i = 0; i < LOCKSTAT_CALLERS; i++) {
+		if (callers[i].caller == caller) {
+			callers[i].count += count;
+			return;
+		}
+		
+		if (callers[i].count < min->count)
+			min = &callers[i];
+	}
+	
+	min->caller = caller;
+	min->count += count;
+}
+
+/** Record an acquisition of a lock.
+ *
+ * @param kind      Kind of the lock.
+ * @param key       Spinlock name or initialization site of the lock.
+ * @param caller    Code which acquired the lock.
+ * @param contended True if the lock was not available right away.
+ * @param wait      Number of cycles spent waiting for the lock.
+ *
+ */
+void lockstat_record(lockstat_kind_t kind, uintptr_t key, uintptr_t caller,
+    bool contended, uint64_t wait)
+{
+	if (stats == NULL)
+		return;
+	
+	size_t idx = lockstat_class(kind, key);
+	if (idx == LOCKSTAT_CLASSES) {
+		atomic_inc(&overflows);
+		return;
+	}
+	
+	ipl_t ipl = interrupts_disable();
+	
+	if (CPU != NULL) {
+		lockstat_t *stat = &stats[CPU->id].class[idx];
+		
+		stat->acquisitions++;
+		if (contended) {
+			stat->contended++;
+			stat->wait_cycles += wait;
+			if (wait > stat->max_wait)
+				stat->max_wait = wait;
+			
+			lockstat_caller(stat->callers, caller, 1);
+		}
+	}
+	
+	interrupts_restore(ipl);
+}
+
+/** Sum up the statistics of a lock class.
+ *
+ * @param idx        Index of the class.
+ * @param stats_lock Structure to fill in.
+ *
+ * @return False if the class is not set up.
+ *
+ */
+static bool lockstat_collect(size_t idx, stats_lock_t *stats_lock)
+{
+	lockstat_class_t *class = &classes[idx];
+	uintptr_t key = (uintptr_t) atomic_get(&class->key);
+	lockstat_kind_t kind = class->kind;
+	
+	if ((key == 0) || (kind == 0))
+		return false;
+	
+	memsetb(stats_lock, sizeof(stats_lock_t), 0);
+	
+	if (kind == LOCKSTAT_SPINLOCK)
+		str_cpy(stats_lock->name, LOCK_NAME_BUFLEN, (const char *) key);
+	else
+		str_cpy(stats_lock->name, LOCK_NAME_BUFLEN,
+		    symtab_fmt_name_lookup(key));
+	
+	stats_lock->kind = kind;
+	
+	lockstat_caller_t callers[LOCKSTAT_CALLERS];
+	memsetb(callers, sizeof(callers), 0);
+	
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		lockstat_t *stat = &stats[i].class[idx];
+		
+		stats_lock->acquisitions += stat->acquisitions;
+		stats_lock->contended += stat->contended;
+		stats_lock->wait_cycles += stat->wait_cycles;
+		if (stat->max_wait > stats_lock->max_wait)
+			stats_lock->max_wait = stat->max_wait;
+		
+		for (unsigned int j = 0; j < LOCKSTAT_CALLERS; j++) {
+			if (stat->callers[j].count > 0)
+				lockstat_caller(callers, stat->callers[j].caller,
+				    stat->callers[j].count);
+		}
+	}
+	
+	/* Report the callers ordered by their counts */
+	for (unsigned int i = 0; i < LOCKSTAT_CALLERS; i++) {
+		unsigned int top = 0;
+		
+		for (unsigned int j = 1; j < LOCKSTAT_CALLERS; j++) {
+			if (callers[j].count > callers[top].count)
+				top = j;
+		}
+		
+		stats_lock->caller[i] = callers[top].caller;
+		stats_lock->caller_count[i] = callers[top].count;
+		callers[top].count = 0;
+	}
+	
+	return true;
+}
+
+/** Get the lock contention statistics
+ *
+ * @param item    Sysinfo item (unused).
+ * @param size    Size of the returned data.
+ * @param dry_run Do not get the data, just calculate the size.
+ * @param data    Unused.
+ *
+ * @return Data containing several stats_lock_t structures.
+ *         If the return value is not NULL, it should be freed
+ *         in the context of the sysinfo request.
+ */
+static void *get_stats_locks(struct sysinfo_item *item, size_t *size,
+    bool dry_run, void *data)
+{
+	size_t count = 0;
+	for (size_t i = 0; i < LOCKSTAT_CLASSES; i++) {
+		if (atomic_get(&classes[i].key) != 0)
+			count++;
+	}
+	
+	*size = sizeof(stats_lock_t) * count;
+	if ((dry_run) || (count == 0))
+		return NULL;
+	
+	stats_lock_t *stats_locks = (stats_lock_t *) malloc(*size, FRAME_ATOMIC);
+	if (stats_locks == NULL) {
+		*size = 0;
+		return NULL;
+	}
+	
+	size_t filled = 0;
+	for (size_t i = 0; (i < LOCKSTAT_CLASSES) && (filled < count); i++) {
+		if (lockstat_collect(i, &stats_locks[filled]))
+			filled++;
+	}
+	
+	*size = sizeof(stats_lock_t) * filled;
+	return ((void *) stats_locks);
+}
+
+/** Clear the statistics of all lock classes.
+ *
+ * Acquisitions recorded concurrently on other processors
+ * might partially survive.
+ *
+ */
+void lockstat_reset(void)
+{
+	if (stats == NULL)
+		return;
+	
+	for (unsigned int i = 0; i < config.cpu_count; i++)
+		memsetb(&stats[i], sizeof(lockstat_cpu_t), 0);
+	
+	atomic_set(&overflows, 0);
+}
+
+/** Print the lock contention statistics.
+ *
+ * @param all Print also the classes which have never been contended.
+ *
+ */
+void lockstat_print(bool all)
+{
+	printf("[kind ] [acquired ] [contended] [wait     ] [max wait ]"
+	    " [name\n");
+	
+	for (size_t i = 0; i < LOCKSTAT_CLASSES; i++) {
+		stats_lock_t stats_lock;
+		
+		if (!lockstat_collect(i, &stats_lock))
+			continue;
+		
+		if ((!all) && (stats_lock.contended == 0))
+			continue;
+		
+		uint64_t acquisitions;
+		char acquisitions_suffix;
+		order_suffix(stats_lock.acquisitions, &acquisitions,
+		    &acquisitions_suffix);
+		
+		uint64_t contended;
+		char contended_suffix;
+		order_suffix(stats_lock.contended, &contended, &contended_suffix);
+		
+		uint64_t wait;
+		char wait_suffix;
+		order_suffix(stats_lock.wait_cycles, &wait, &wait_suffix);
+		
+		uint64_t max_wait;
+		char max_wait_suffix;
+		order_suffix(stats_lock.max_wait, &max_wait, &max_wait_suffix);
+		
+		printf("%-7s %10" PRIu64 "%c %10" PRIu64 "%c %10" PRIu64 "%c"
+		    " %10" PRIu64 "%c %s\n", lockstat_kinds[stats_lock.kind],
+		    acquisitions, acquisitions_suffix, contended,
+		    contended_suffix, wait, wait_suffix, max_wait,
+		    max_wait_suffix, stats_lock.name);
+		
+		for (unsigned int j = 0; j < LOCKSTAT_CALLERS; j++) {
+			if (stats_lock.caller_count[j] == 0)
+				break;
+			
+			printf("        %10" PRIu64 "  %p %s\n",
+			    stats_lock.caller_count[j],
+			    (void *) (uintptr_t) stats_lock.caller[j],
+			    symtab_fmt_name_lookup(stats_lock.caller[j]));
+		}
+	}
+	
+	if (atomic_get(&overflows) > 0)
+		printf("%" PRIua " acquisitions of untracked lock classes\n",
+		    atomic_get(&overflows));
+}
+
+/** Initialize lock contention statistics.
+ *
+ * Acquisitions are recorded from now on.
+ *
+ */
+void lockstat_init(void)
+{
+	lockstat_cpu_t *new_stats = (lockstat_cpu_t *)
+	    malloc(sizeof(lockstat_cpu_t) * config.cpu_count, FRAME_ATOMIC);
+	if (new_stats == NULL) {
+		printf("Cannot allocate lock statistics.\n");
+		return;
+	}
+	
+	memsetb(new_stats, sizeof(lockstat_cpu_t) * config.cpu_count, 0);
+	
+	/* The statistics must be zeroed before the recording starts. */
+	write_barrier();
+	stats = new_stats;
+	
+	sysinfo_set_item_gen_data("system.locks", NULL, get_stats_locks, NULL);
+}
+
+/** @}
+ */
@@ -33,14 +33,58 @@
 /**
  * @file
  * @brief Mutexes.
+ *
+ * The mutex is an owner word which is locked and unlocked by a single
+ * compare-and-swap as long as there is no contention. A thread which
+ * finds the mutex locked spins while the owner is running on another
+ * CPU, as the mutex is likely to be unlocked soon. Only then it marks
+ * the mutex contended and goes to sleep in the wait queue of the mutex.
+ * Unlocking a contended mutex wakes up the first waiter, which competes
+ * for the mutex again.
+ *
+ * Condition variables can move their waiters directly to the wait queue
+ * of the mutex (wait morphing), so that the waiters are woken up one by
+ * one as the mutex gets unlocked.
  */
 
 #include <synch/mutex.h>
-#include <synch/semaphore.h>
+#include <synch/waitq.h>
+#include <synch/lockstat.h>
+#include <proc/thread.h>
+#include <proc/scheduler.h>
+#include <arch/barrier.h>
+#include <arch/asm.h>
+#include <arch/cycle.h>
+#include <atomic.h>
 #include <debug.h>
 #include <arch.h>
+#include <cpu.h>
 #include <stacktrace.h>
 
+/** Maximal number of times to check a running owner before sleeping. */
+#define MUTEX_SPIN_MAX  1000
+
+#define MUTEX_DEADLOCK_THRESHOLD	100000000
+
+/** Initialize mutex on behalf of a caller.
+ *
+ * Locks which embed a mutex pass the code initializing them,
+ * so that their mutexes do not all fall into one lock class.
+ *
+ * @param mtx  Mutex.
+ * @param type Type of the mutex.
+ * @param site Code identifying the lock class of the mutex.
+ */
+void mutex_initialize_site(mutex_t *mtx, mutex_type_t type, uintptr_t site)
+{
+	mtx->type = type;
+	atomic_set(&mtx->owner, 0);
+	waitq_initialize(&mtx->wq);
+#ifdef CONFIG_LOCKSTAT
+	mtx->site = site;
+#endif
+}
+
 /** Initialize mutex.
  *
  * @param mtx  Mutex.
@@ -48,8 +92,7 @@
  */
 void mutex_initialize(mutex_t *mtx, mutex_type_t type)
 {
-	mtx->type = type;
-	semaphore_initialize(&mtx->sem, 1);
+	mutex_initialize_site(mtx, type, CALLER);
 }
 
 /** Find out whether the mutex is currently locked.
@@ -59,10 +102,162 @@ void mutex_initialize(mutex_t *mtx, mutex_type_t type)
  */
 bool mutex_locked(mutex_t *mtx)
 {
-	return semaphore_count_get(&mtx->sem) <= 0;
+	return atomic_get(&mtx->owner) != 0;
 }
 
-#define MUTEX_DEADLOCK_THRESHOLD	100000000
+/** Owner word identifying the current thread. */
+NO_TRACE static inline atomic_count_t mutex_self(void)
+{
+	if (THREAD)
+		return (atomic_count_t) (uintptr_t) THREAD;
+	
+	return MUTEX_NO_THREAD;
+}
+
+/** Try to lock the mutex without waiting.
+ *
+ * @param mtx Mutex.
+ *
+ * @return True if the mutex has been locked.
+ *
+ */
+NO_TRACE static inline bool mutex_trylock_fast(mutex_t *mtx)
+{
+	if (atomic_cas(&mtx->owner, 0, mutex_self())) {
+		CS_ENTER_BARRIER();
+		return true;
+	}
+	
+	return false;
+}
+
+/** Check whether the owner of a mutex is running on another CPU.
+ *
+ * The owner might unlock the mutex and even cease to exist while
+ * being checked. Thread structures come from a slab cache, so the
+ * memory remains accessible and the answer is just a stale hint.
+ *
+ * @param owner Owner word of the mutex.
+ *
+ * @return True if it is worth spinning instead of going to sleep.
+ *
+ */
+NO_TRACE static bool mutex_owner_running(atomic_count_t owner)
+{
+#ifdef CONFIG_SMP
+	owner &= ~((atomic_count_t) MUTEX_CONTENDED);
+	if ((owner == 0) || (owner == MUTEX_NO_THREAD))
+		return false;
+	
+	thread_t *thread = (thread_t *) (uintptr_t) owner;
+	return ((thread->state == Running) && (thread->cpu != CPU));
+#else
+	return false;
+#endif
+}
+
+/** Acquire an active mutex by busy waiting.
+ *
+ * @param mtx   Mutex.
+ * @param flags Specify mode of operation.
+ *
+ * @return ESYNCH_OK_ATOMIC or ESYNCH_WOULD_BLOCK.
+ *
+ */
+static int mutex_lock_active(mutex_t *mtx, unsigned int flags)
+{
+	unsigned int cnt = 0;
+	bool deadlock_reported = false;
+	
+	while (!mutex_trylock_fast(mtx)) {
+		if (flags & SYNCH_FLAGS_NON_BLOCKING)
+			return ESYNCH_WOULD_BLOCK;
+		
+		if (cnt++ > MUTEX_DEADLOCK_THRESHOLD) {
+			printf("cpu%u: looping on active mutex %p\n",
+			    CPU->id, mtx);
+			stack_trace();
+			cnt = 0;
+			deadlock_reported = true;
+		}
+	}
+	
+	if (deadlock_reported)
+		printf("cpu%u: not deadlocked\n", CPU->id);
+	
+	return ESYNCH_OK_ATOMIC;
+}
+
+/** Acquire a passive mutex, going to sleep if necessary.
+ *
+ * @param mtx   Mutex.
+ * @param usec  Timeout in microseconds.
+ * @param flags Specify mode of operation.
+ *
+ * @return See comment for waitq_sleep_timeout().
+ *
+ */
+static int mutex_lock_passive(mutex_t *mtx, uint32_t usec, unsigned int flags)
+{
+	/* Spin while the owner is running on another CPU. */
+	for (unsigned int i = 0; i < MUTEX_SPIN_MAX; i++) {
+		atomic_count_t owner = atomic_get(&mtx->owner);
+		
+		if (owner == 0) {
+			if (mutex_trylock_fast(mtx))
+				return ESYNCH_OK_ATOMIC;
+		} else if (!mutex_owner_running(owner))
+			break;
+	}
+	
+	bool blocked = false;
+	
+	while (true) {
+		ipl_t ipl = waitq_sleep_prepare(&mtx->wq);
+		
+		/*
+		 * The owner cannot unlock a contended mutex
+		 * without the lock of the wait queue.
+		 */
+		atomic_count_t owner = atomic_get(&mtx->owner);
+		
+		if (owner == 0) {
+			/*
+			 * Keep the mutex contended for the sake of the
+			 * threads which are still waiting.
+			 */
+			atomic_count_t self = mutex_self();
+			if (!list_empty(&mtx->wq.sleepers))
+				self |= MUTEX_CONTENDED;
+			
+			bool locked = atomic_cas(&mtx->owner, 0, self);
+			waitq_sleep_finish(&mtx->wq, ESYNCH_WOULD_BLOCK, ipl);
+			
+			if (locked) {
+				CS_ENTER_BARRIER();
+				return (blocked) ? ESYNCH_OK_BLOCKED :
+				    ESYNCH_OK_ATOMIC;
+			}
+			
+			continue;
+		}
+		
+		if ((!(owner & MUTEX_CONTENDED)) &&
+		    (!atomic_cas(&mtx->owner, owner, owner | MUTEX_CONTENDED))) {
+			/* The mutex has been unlocked or taken over meanwhile. */
+			waitq_sleep_finish(&mtx->wq, ESYNCH_WOULD_BLOCK, ipl);
+			continue;
+		}
+		
+		int rc = waitq_sleep_timeout_unsafe(&mtx->wq, usec, flags);
+		waitq_sleep_finish(&mtx->wq, rc, ipl);
+		
+		if (SYNCH_FAILED(rc))
+			return rc;
+		
+		blocked = true;
+	}
+}
 
 /** Acquire mutex.
  *
@@ -74,38 +269,45 @@ bool mutex_locked(mutex_t *mtx)
  *
  * For exact description of possible combinations of
  * usec and flags, see comment for waitq_sleep_timeout().
+ * The timeout starts anew each time the thread is woken
+ * up and loses the mutex to another thread.
  *
  * @return See comment for waitq_sleep_timeout().
  *
  */
 int _mutex_lock_timeout(mutex_t *mtx, uint32_t usec, unsigned int flags)
 {
+	if (mutex_trylock_fast(mtx)) {
+#ifdef CONFIG_LOCKSTAT
+		lockstat_record(LOCKSTAT_MUTEX, mtx->site, CALLER, false, 0);
+#endif
+		return ESYNCH_OK_ATOMIC;
+	}
+	
+#ifdef CONFIG_LOCKSTAT
+	uint64_t start = get_cycle();
+#endif
 	int rc;
-
+	
 	if ((mtx->type == MUTEX_PASSIVE) && (THREAD)) {
-		rc = _semaphore_down_timeout(&mtx->sem, usec, flags);
+		if ((usec == 0) && (flags & SYNCH_FLAGS_NON_BLOCKING))
+			return ESYNCH_WOULD_BLOCK;
+		
+		rc = mutex_lock_passive(mtx, usec, flags);
 	} else {
 		ASSERT((mtx->type == MUTEX_ACTIVE) || (!THREAD));
 		ASSERT(usec == SYNCH_NO_TIMEOUT);
 		ASSERT(!(flags & SYNCH_FLAGS_INTERRUPTIBLE));
 		
-		unsigned int cnt = 0;
-		bool deadlock_reported = false;
-		do {
-			if (cnt++ > MUTEX_DEADLOCK_THRESHOLD) {
-				printf("cpu%u: looping on active mutex %p\n",
-				    CPU->id, mtx);
-				stack_trace();
-				cnt = 0;
-				deadlock_reported = true;
-			}
-			rc = semaphore_trydown(&mtx->sem);
-		} while (SYNCH_FAILED(rc) &&
-		    !(flags & SYNCH_FLAGS_NON_BLOCKING));
-		if (deadlock_reported)
-			printf("cpu%u: not deadlocked\n", CPU->id);
+		rc = mutex_lock_active(mtx, flags);
 	}
-
+	
+#ifdef CONFIG_LOCKSTAT
+	if (SYNCH_OK(rc))
+		lockstat_record(LOCKSTAT_MUTEX, mtx->site, CALLER, true,
+		    get_cycle() - start);
+#endif
+	
 	return rc;
 }
 
@@ -115,7 +317,123 @@ int _mutex_lock_timeout(mutex_t *mtx, uint32_t usec, unsigned int flags)
  */
 void mutex_unlock(mutex_t *mtx)
 {
-	semaphore_up(&mtx->sem);
+	CS_LEAVE_BARRIER();
+	
+	while (true) {
+		atomic_count_t owner = atomic_get(&mtx->owner);
+		ASSERT(owner != 0);
+		
+		if (owner & MUTEX_CONTENDED)
+			break;
+		
+		if (atomic_cas(&mtx->owner, owner, 0))
+			return;
+	}
+	
+	/*
+	 * Nobody changes the owner word of a contended mutex
+	 * without holding the lock of the wait queue.
+	 */
+	irq_spinlock_lock(&mtx->wq.lock, true);
+	
+	atomic_set(&mtx->owner, 0);
+	if (!list_empty(&mtx->wq.sleepers))
+		_waitq_wakeup_unsafe(&mtx->wq, WAKEUP_FIRST);
+	
+	irq_spinlock_unlock(&mtx->wq.lock, true);
+	
+	if (!interrupts_disabled())
+		scheduler_preempt();
+}
+
+/** Move threads sleeping in a wait queue to the wait queue of a mutex.
+ *
+ * This implements wait morphing for condition variables. Instead of
+ * being woken up just to find the mutex locked, the threads are woken
+ * up one by one as the mutex gets unlocked. The caller must hold the
+ * lock of the wait queue with interrupts disabled.
+ *
+ * @param mtx  Mutex.
+ * @param wq   Wait queue.
+ * @param mode WAKEUP_FIRST to move the first thread only,
+ *             WAKEUP_ALL to move all of them.
+ *
+ * @return False if the mutex is not a passive mutex owned by the
+ *         current thread. Nothing is moved in that case.
+ *
+ */
+bool mutex_requeue(mutex_t *mtx, waitq_t *wq, wakeup_mode_t mode)
+{
+	ASSERT(interrupts_disabled());
+	ASSERT(irq_spinlock_locked(&wq->lock));
+	
+	if ((mtx->type != MUTEX_PASSIVE) || (!THREAD))
+		return false;
+	
+	atomic_count_t owner = atomic_get(&mtx->owner);
+	if ((owner & ~((atomic_count_t) MUTEX_CONTENDED)) != mutex_self())
+		return false;
+	
+	irq_spinlock_lock(&mtx->wq.lock, false);
+	
+	while (!list_empty(&wq->sleepers)) {
+		thread_t *thread = list_get_instance(list_first(&wq->sleepers),
+		    thread_t, wq_link);
+		
+		/*
+		 * Timeouts and interruptions find the thread
+		 * through its sleep queue, see waitq_sleep_timed_out().
+		 */
+		irq_spinlock_lock(&thread->lock, false);
+		list_remove(&thread->wq_link);
+		list_append(&thread->wq_link, &mtx->wq.sleepers);
+		thread->sleep_queue = &mtx->wq;
+		irq_spinlock_unlock(&thread->lock, false);
+		
+		if (mode == WAKEUP_FIRST)
+			break;
+	}
+	
+	/*
+	 * Make mutex_unlock() wake up the moved threads. Only the owner
+	 * and the holders of the wait queue lock change the owner word.
+	 */
+	if (!list_empty(&mtx->wq.sleepers))
+		atomic_set(&mtx->owner, owner | MUTEX_CONTENDED);
+	
+	irq_spinlock_unlock(&mtx->wq.lock, false);
+	return true;
+}
+
+/** Lock a mutex in a thread which might have been moved to its wait queue.
+ *
+ * A thread woken up from the wait queue of a mutex has to keep the
+ * mutex contended as long as there are other threads waiting. Unlike
+ * the threads woken up in mutex_lock_passive(), a thread moved there by
+ * mutex_requeue() locks the mutex anew and may take the fast path.
+ *
+ * @param mtx Mutex.
+ *
+ */
+void mutex_lock_requeued(mutex_t *mtx)
+{
+	mutex_lock(mtx);
+	
+	/*
+	 * The threads which start waiting while we own
+	 * the mutex mark the mutex contended themselves.
+	 */
+	if (list_empty(&mtx->wq.sleepers))
+		return;
+	
+	irq_spinlock_lock(&mtx->wq.lock, true);
+	
+	if (!list_empty(&mtx->wq.sleepers)) {
+		atomic_count_t owner = atomic_get(&mtx->owner);
+		atomic_set(&mtx->owner, owner | MUTEX_CONTENDED);
+	}
+	
+	irq_spinlock_unlock(&mtx->wq.lock, true);
 }
 
 /** @}
@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup sync
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Read-copy-update.
+ *
+ * Readers only disable preemption, so a CPU which switches context
+ * or runs its idle loop cannot be inside a read-side critical section.
+ * Such points are quiescent states. A CPU notes them by recording
+ * the number of the grace period that is currently running.
+ *
+ * Callbacks are queued per CPU. The reclaimer thread claims them,
+ * starts a new grace period and polls until every active CPU has
+ * passed a quiescent state in it. Idle CPUs that have been asleep
+ * since before the grace period began are woken up, so that they
+ * go around their idle loop once. After that, the claimed callbacks
+ * are invoked and the waiters in rcu_synchronize() are woken up.
+ */
+
+#include <synch/rcu.h>
+#include <synch/mutex.h>
+#include <synch/condvar.h>
+#include <synch/waitq.h>
+#include <smp/ipi.h>
+#include <proc/thread.h>
+#include <time/clock.h>
+#include <arch/barrier.h>
+#include <arch.h>
+#include <config.h>
+#include <cpu.h>
+#include <debug.h>
+
+static struct {
+	/**
+	 * Number of the most recently started grace period.
+	 * Changed only by the reclaimer with mtx held.
+	 */
+	volatile size_t cur_gp;
+	
+	/** Protects the fields below. */
+	mutex_t mtx;
+	/** Number of the most recently completed grace period. */
+	size_t completed_gp;
+	/** A grace period was requested by rcu_synchronize(). */
+	bool gp_requested;
+	/** Waiters for the completion of a grace period. */
+	condvar_t gp_done_cv;
+	
+	/** The reclaimer sleeps here while there is nothing to do. */
+	waitq_t work_wq;
+} rcu;
+
+/** Initialize RCU subsystem. */
+void rcu_init(void)
+{
+	rcu.cur_gp = 0;
+	mutex_initialize(&rcu.mtx, MUTEX_PASSIVE);
+	rcu.completed_gp = 0;
+	rcu.gp_requested = false;
+	condvar_initialize(&rcu.gp_done_cv);
+	waitq_initialize(&rcu.work_wq);
+}
+
+/** Initialize per-CPU RCU state.
+ *
+ * @param rc Per-CPU RCU state.
+ *
+ */
+void rcu_cpu_init(rcu_cpu_t *rc)
+{
+	rc->qs_gp = 0;
+	irq_spinlock_initialize(&rc->lock, "cpus[].rcu.lock");
+	rc->cbs = NULL;
+	rc->cbs_tail = &rc->cbs;
+}
+
+/** Note that the current CPU is in a quiescent state.
+ *
+ * Called by the scheduler outside of any read-side critical
+ * section, with interrupts disabled.
+ *
+ */
+void rcu_quiescent_state(void)
+{
+	ASSERT(interrupts_disabled());
+	
+	/*
+	 * Make the memory accesses of the preceding critical sections
+	 * visible before the grace period can be seen as finished.
+	 */
+	memory_barrier();
+	CPU->rcu.qs_gp = rcu.cur_gp;
+}
+
+/** Queue a callback to run after a grace period.
+ *
+ * The callback is invoked in the context of the reclaimer thread
+ * once all read-side critical sections which might have been
+ * running at the time of this call have finished.
+ *
+ * Can be called from any context, including interrupt handlers
+ * and read-side critical sections.
+ *
+ * @param item Callback structure, usually embedded in the object
+ *             to be reclaimed.
+ * @param func Function to call with item as its argument.
+ *
+ */
+void rcu_call(rcu_item_t *item, rcu_func_t func)
+{
+	item->next = NULL;
+	item->func = func;
+	
+	ipl_t ipl = interrupts_disable();
+	rcu_cpu_t *rc = &CPU->rcu;
+	
+	irq_spinlock_lock(&rc->lock, false);
+	
+	bool first = (rc->cbs == NULL);
+	*rc->cbs_tail = item;
+	rc->cbs_tail = &item->next;
+	
+	irq_spinlock_unlock(&rc->lock, false);
+	
+	if (first)
+		waitq_wakeup(&rcu.work_wq, WAKEUP_FIRST);
+	
+	interrupts_restore(ipl);
+}
+
+/** Wait until a grace period elapses.
+ *
+ * On return, all read-side critical sections which were running
+ * at the time of the call have finished. Must be called from
+ * a thread outside of any read-side critical section.
+ *
+ */
+void rcu_synchronize(void)
+{
+	ASSERT(THREAD);
+	
+	mutex_lock(&rcu.mtx);
+	
+	/* The grace period running right now might have started too early. */
+	size_t target = rcu.cur_gp + 1;
+	rcu.gp_requested = true;
+	waitq_wakeup(&rcu.work_wq, WAKEUP_FIRST);
+	
+	while ((ssize_t) (rcu.completed_gp - target) < 0)
+		condvar_wait(&rcu.gp_done_cv, &rcu.mtx);
+	
+	mutex_unlock(&rcu.mtx);
+}
+
+/** Check whether all CPUs passed a quiescent state.
+ *
+ * Idle CPUs which have not done so yet are kicked.
+ *
+ * @param gp Number of the grace period.
+ *
+ * @return True if the grace period has elapsed.
+ *
+ */
+static bool rcu_gp_elapsed(size_t gp)
+{
+	bool elapsed = true;
+	
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		cpu_t *cpu = &cpus[i];
+		
+		if ((!cpu->active) || (cpu->rcu.qs_gp == gp))
+			continue;
+		
+		elapsed = false;
+		
+		if ((cpu->idle) && (cpu != CPU))
+			ipi_wakeup(cpu);
+	}
+	
+	/* Order the callbacks after the readers of all CPUs. */
+	memory_barrier();
+	
+	return elapsed;
+}
+
+/** Run one grace period. */
+static void rcu_gp(void)
+{
+	mutex_lock(&rcu.mtx);
+	rcu.gp_requested = false;
+	size_t gp = ++rcu.cur_gp;
+	mutex_unlock(&rcu.mtx);
+	
+	/*
+	 * Make the new grace period visible before looking for
+	 * the quiescent states.
+	 */
+	memory_barrier();
+	
+	while (!rcu_gp_elapsed(gp))
+		thread_usleep(1000000 / HZ);
+	
+	mutex_lock(&rcu.mtx);
+	rcu.completed_gp = gp;
+	condvar_broadcast(&rcu.gp_done_cv);
+	mutex_unlock(&rcu.mtx);
+}
+
+/** Claim the callbacks queued on all CPUs.
+ *
+ * @return Claimed callbacks in a single list.
+ *
+ */
+static rcu_item_t *rcu_claim(void)
+{
+	rcu_item_t *cbs = NULL;
+	rcu_item_t **tail = &cbs;
+	
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		rcu_cpu_t *rc = &cpus[i].rcu;
+		
+		irq_spinlock_lock(&rc->lock, true);
+		
+		if (rc->cbs != NULL) {
+			*tail = rc->cbs;
+			tail = rc->cbs_tail;
+			
+			rc->cbs = NULL;
+			rc->cbs_tail = &rc->cbs;
+		}
+		
+		irq_spinlock_unlock(&rc->lock, true);
+	}
+	
+	return cbs;
+}
+
+/** RCU reclaimer thread.
+ *
+ * Drives the grace periods and invokes the callbacks.
+ *
+ * @param arg Not used.
+ *
+ */
+void rcu_reclaimer(void *arg)
+{
+	thread_detach(THREAD);
+	
+	while (true) {
+		rcu_item_t *cbs = rcu_claim();
+		
+		mutex_lock(&rcu.mtx);
+		bool requested = rcu.gp_requested;
+		mutex_unlock(&rcu.mtx);
+		
+		if ((cbs == NULL) && (!requested)) {
+			waitq_sleep(&rcu.work_wq);
+			continue;
+		}
+		
+		/* The callbacks were queued before this grace period. */
+		rcu_gp();
+		
+		while (cbs != NULL) {
+			rcu_item_t *next = cbs->next;
+			cbs->func(cbs);
+			cbs = next;
+		}
+	}
+}
+
+/** @}
+ */
@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup sync
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Reader-writer locks.
+ *
+ * Two flavours are provided. The sleeping rwlock_t is built on top
+ * of a mutex and two condition variables and may be held across
+ * blocking operations. The irq_rwlock_t is a spinning lock for
+ * short read-mostly critical sections entered with interrupts
+ * disabled, such as the global task and thread trees.
+ *
+ * Both flavours prefer writers so that a steady stream of readers
+ * cannot starve updates. Neither flavour supports upgrading a read
+ * lock to a write lock.
+ */
+
+#include <synch/rwlock.h>
+#include <synch/mutex.h>
+#include <synch/condvar.h>
+#include <synch/spinlock.h>
+#include <arch/barrier.h>
+#include <arch.h>
+#include <config.h>
+#include <preemption.h>
+#include <memstr.h>
+#include <debug.h>
+
+/** Initialize sleeping reader-writer lock.
+ *
+ * @param rwl  Reader-writer lock.
+ * @param type Type of the underlying mutex. MUTEX_ACTIVE locks
+ *             busy-wait instead of sleeping and can thus be used
+ *             before the scheduler is running.
+ *
+ */
+void rwlock_initialize(rwlock_t *rwl, mutex_type_t type)
+{
+	/* The code initializing the lock identifies its lock class. */
+	mutex_initialize_site(&rwl->mtx, type, CALLER);
+	condvar_initialize(&rwl->readers_cv);
+	condvar_initialize(&rwl->writers_cv);
+	rwl->readers = 0;
+	rwl->readers_waiting = 0;
+	rwl->writers_waiting = 0;
+	rwl->writer = false;
+}
+
+/** Wait for a change of the reader-writer lock state.
+ *
+ * Called and returns with the internal mutex held.
+ *
+ * @param rwl Reader-writer lock.
+ * @param cv  Condition variable to wait on.
+ *
+ */
+static void rwlock_wait(rwlock_t *rwl, condvar_t *cv)
+{
+	if ((rwl->mtx.type == MUTEX_PASSIVE) && (THREAD)) {
+		condvar_wait(cv, &rwl->mtx);
+	} else {
+		mutex_unlock(&rwl->mtx);
+		mutex_lock(&rwl->mtx);
+	}
+}
+
+/** Acquire reader-writer lock for reading.
+ *
+ * Blocks while a writer holds the lock or is waiting for it.
+ *
+ * @param rwl Reader-writer lock.
+ *
+ */
+void rwlock_read_lock(rwlock_t *rwl)
+{
+	mutex_lock(&rwl->mtx);
+	
+	while ((rwl->writer) || (rwl->writers_waiting > 0)) {
+		rwl->readers_waiting++;
+		rwlock_wait(rwl, &rwl->readers_cv);
+		rwl->readers_waiting--;
+	}
+	
+	rwl->readers++;
+	mutex_unlock(&rwl->mtx);
+}
+
+/** Release reader-writer lock held for reading.
+ *
+ * @param rwl Reader-writer lock.
+ *
+ */
+void rwlock_read_unlock(rwlock_t *rwl)
+{
+	mutex_lock(&rwl->mtx);
+	
+	ASSERT(rwl->readers > 0);
+	rwl->readers--;
+	
+	if ((rwl->readers == 0) && (rwl->writers_waiting > 0))
+		condvar_signal(&rwl->writers_cv);
+	
+	mutex_unlock(&rwl->mtx);
+}
+
+/** Acquire reader-writer lock for writing.
+ *
+ * @param rwl Reader-writer lock.
+ *
+ */
+void rwlock_write_lock(rwlock_t *rwl)
+{
+	mutex_lock(&rwl->mtx);
+	
+	rwl->writers_waiting++;
+	while ((rwl->writer) || (rwl->readers > 0))
+		rwlock_wait(rwl, &rwl->writers_cv);
+	rwl->writers_waiting--;
+	
+	rwl->writer = true;
+	mutex_unlock(&rwl->mtx);
+}
+
+/** Release reader-writer lock held for writing.
+ *
+ * Another waiting writer is woken up first; the waiting readers
+ * are let in only when there is no writer left.
+ *
+ * @param rwl Reader-writer lock.
+ *
+ */
+void rwlock_write_unlock(rwlock_t *rwl)
+{
+	mutex_lock(&rwl->mtx);
+	
+	ASSERT(rwl->writer);
+	rwl->writer = false;
+	
+	if (rwl->writers_waiting > 0)
+		condvar_signal(&rwl->writers_cv);
+	else if (rwl->readers_waiting > 0)
+		condvar_broadcast(&rwl->readers_cv);
+	
+	mutex_unlock(&rwl->mtx);
+}
+
+/** Initialize interrupts-disabled reader-writer lock.
+ *
+ * @param rwl  Reader-writer lock.
+ * @param name Symbolic name of the lock.
+ *
+ */
+void irq_rwlock_initialize(irq_rwlock_t *rwl, const char *name)
+{
+	irq_spinlock_initialize(&rwl->lock, name);
+	rwl->writer = false;
+	memsetb(rwl->cpus, sizeof(rwl->cpus), 0);
+}
+
+/** Acquire interrupts-disabled reader-writer lock for reading.
+ *
+ * The read side may nest on a single CPU. Only the outermost
+ * acquisition checks for writers, as a writer is waiting for
+ * the nested reader to leave.
+ *
+ * @param rwl     Reader-writer lock.
+ * @param irq_dis If true, disables interrupts before locking the
+ *                lock. The interrupt level is restored when the
+ *                outermost reader on this CPU leaves.
+ *
+ */
+void irq_rwlock_read_lock(irq_rwlock_t *rwl, bool irq_dis)
+{
+	ipl_t ipl = 0;
+	
+	if (irq_dis)
+		ipl = interrupts_disable();
+	else
+		ASSERT(interrupts_disabled());
+	
+	preemption_disable();
+	
+	irq_rwlock_cpu_t *slot = &rwl->cpus[CPU->id];
+	if (slot->readers > 0) {
+		slot->readers++;
+		return;
+	}
+	
+	DEADLOCK_PROBE_INIT(p_rwlock);
+	
+	while (true) {
+		slot->readers = 1;
+		
+		/*
+		 * Publish the reader before looking for a writer. The
+		 * writer does the opposite, so at least one of us sees
+		 * the other.
+		 */
+		memory_barrier();
+		if (!rwl->writer)
+			break;
+		
+		/* Step aside and let the writer in. */
+		slot->readers = 0;
+		while (rwl->writer)
+			DEADLOCK_PROBE(p_rwlock, DEADLOCK_THRESHOLD);
+	}
+	
+	slot->ipl = ipl;
+	
+	/*
+	 * Prevent critical section code from bleeding out this way up.
+	 */
+	CS_ENTER_BARRIER();
+}
+
+/** Release interrupts-disabled reader-writer lock held for reading.
+ *
+ * @param rwl     Reader-writer lock.
+ * @param irq_res If true, the interrupt level saved by the outermost
+ *                reader is restored once it leaves.
+ *
+ */
+void irq_rwlock_read_unlock(irq_rwlock_t *rwl, bool irq_res)
+{
+	ASSERT(interrupts_disabled());
+	
+	irq_rwlock_cpu_t *slot = &rwl->cpus[CPU->id];
+	ASSERT(slot->readers > 0);
+	
+	ipl_t ipl = slot->ipl;
+	
+	/*
+	 * Prevent critical section code from bleeding out this way down.
+	 */
+	CS_LEAVE_BARRIER();
+	
+	size_t readers = --slot->readers;
+	preemption_enable();
+	
+	if ((irq_res) && (readers == 0))
+		interrupts_restore(ipl);
+}
+
+/** Acquire interrupts-disabled reader-writer lock for writing.
+ *
+ * @param rwl     Reader-writer lock.
+ * @param irq_dis If true, disables interrupts before locking the lock.
+ *
+ */
+void irq_rwlock_write_lock(irq_rwlock_t *rwl, bool irq_dis)
+{
+	irq_spinlock_lock(&rwl->lock, irq_dis);
+	
+	/* Upgrading a read lock would wait for ourselves. */
+	ASSERT(rwl->cpus[CPU->id].readers == 0);
+	
+	rwl->writer = true;
+	memory_barrier();
+	
+	DEADLOCK_PROBE_INIT(p_rwlock);
+	
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		while (rwl->cpus[i].readers > 0)
+			DEADLOCK_PROBE(p_rwlock, DEADLOCK_THRESHOLD);
+	}
+	
+	/*
+	 * Prevent critical section code from bleeding out this way up.
+	 */
+	CS_ENTER_BARRIER();
+}
+
+/** Release interrupts-disabled reader-writer lock held for writing.
+ *
+ * @param rwl     Reader-writer lock.
+ * @param irq_res If true, interrupts are restored to the previously
+ *                saved interrupt level.
+ *
+ */
+void irq_rwlock_write_unlock(irq_rwlock_t *rwl, bool irq_res)
+{
+	ASSERT(rwl->writer);
+	
+	/*
+	 * Prevent critical section code from bleeding out this way down.
+	 */
+	CS_LEAVE_BARRIER();
+	
+	rwl->writer = false;
+	irq_spinlock_unlock(&rwl->lock, irq_res);
+}
+
+/** Find out whether the current CPU holds the lock.
+ *
+ * @param rwl Reader-writer lock.
+ *
+ * @return True if the lock is held for reading on this CPU or
+ *         held for writing, false otherwise.
+ *
+ */
+bool irq_rwlock_locked(irq_rwlock_t *rwl)
+{
+	return ((rwl->cpus[CPU->id].readers > 0) ||
+	    ((rwl->writer) && (irq_spinlock_locked(&rwl->lock))));
+}
+
+/** @}
+ */
@@ -38,7 +38,10 @@
 #include <synch/semaphore.h>
 #include <synch/waitq.h>
 #include <synch/spinlock.h>
+#include <synch/lockstat.h>
 #include <arch/asm.h>
+#include <arch/cycle.h>
+#include <debug.h>
 #include <arch.h>
 
 /** Initialize semaphore
@@ -53,6 +56,9 @@ void semaphore_initialize(semaphore_t *sem, int val)
 {
 	waitq_initialize(&sem->wq);
 	waitq_count_set(&sem->wq, val);
+#ifdef CONFIG_LOCKSTAT
+	sem->site = CALLER;
+#endif
 }
 
 /** Semaphore down
@@ -72,7 +78,19 @@ void semaphore_initialize(semaphore_t *sem, int val)
  */
 int _semaphore_down_timeout(semaphore_t *sem, uint32_t usec, unsigned int flags)
 {
+#ifdef CONFIG_LOCKSTAT
+	uint64_t start = get_cycle();
+	int rc = waitq_sleep_timeout(&sem->wq, usec, flags);
+	
+	if (SYNCH_OK(rc))
+		lockstat_record(LOCKSTAT_SEMAPHORE, sem->site, CALLER,
+		    rc == ESYNCH_OK_BLOCKED,
+		    (rc == ESYNCH_OK_BLOCKED) ? get_cycle() - start : 0);
+	
+	return rc;
+#else
 	return waitq_sleep_timeout(&sem->wq, usec, flags);
+#endif
 }
 
 /** Semaphore up
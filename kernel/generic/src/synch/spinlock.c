@@ -36,17 +36,126 @@
  */
 
 #include <synch/spinlock.h>
+#include <synch/lockstat.h>
 #include <atomic.h>
 #include <arch/barrier.h>
+#include <arch/cycle.h>
 #include <arch.h>
 #include <preemption.h>
 #include <print.h>
 #include <debug.h>
 #include <symtab.h>
 #include <stacktrace.h>
+#include <cpu.h>
+#include <panic.h>
 
 #ifdef CONFIG_SMP
 
+/** State of a spinning loop
+ *
+ * Kept for the deadlock detection and for the lock
+ * contention statistics.
+ *
+ */
+typedef struct {
+	/** Iterations since the last deadlock report. */
+	size_t count;
+	/** A possible deadlock has been reported. */
+	bool reported;
+	/** The lock was not available right away. */
+	bool contended;
+	/** Cycle counter when the lock was found unavailable. */
+	uint64_t start;
+} spin_probe_t;
+
+/** Initialize the state of a spinning loop
+ *
+ * @param probe Spinning loop state.
+ *
+ */
+NO_TRACE static inline void spin_probe_init(spin_probe_t *probe)
+{
+	probe->count = 0;
+	probe->reported = false;
+	probe->contended = false;
+	probe->start = 0;
+}
+
+/** Account an iteration of a spinning loop
+ *
+ * @param probe  Spinning loop state.
+ * @param lock   Spinlock being spun on.
+ * @param caller Code acquiring the spinlock.
+ *
+ */
+NO_TRACE static inline void spin_probe(spin_probe_t *probe, spinlock_t *lock,
+    uintptr_t caller)
+{
+#ifdef CONFIG_LOCKSTAT
+	if (!probe->contended) {
+		probe->contended = true;
+		probe->start = get_cycle();
+	}
+#endif
+	
+#ifdef CONFIG_DEBUG_SPINLOCK
+	/*
+	 * We need to be careful about particular locks
+	 * which are directly used to report deadlocks
+	 * via printf() (and recursively other functions).
+	 * This conserns especially printf_lock and the
+	 * framebuffer lock.
+	 *
+	 * Any lock whose name is prefixed by "*" will be
+	 * ignored by this deadlock detection routine
+	 * as this might cause an infinite recursion.
+	 * We trust our code that there is no possible deadlock
+	 * caused by these locks (except when an exception
+	 * is triggered for instance by printf()).
+	 *
+	 * We encountered false positives caused by very
+	 * slow framebuffer interaction (especially when
+	 * run in a simulator) that caused problems with both
+	 * printf_lock and the framebuffer lock.
+	 */
+	if (lock->name[0] == '*')
+		return;
+	
+	if (probe->count++ > DEADLOCK_THRESHOLD) {
+		printf("cpu%u: looping on spinlock %p:%s, "
+		    "caller=%p (%s)\n", CPU->id, lock, lock->name,
+		    (void *) caller, symtab_fmt_name_lookup(caller));
+		stack_trace();
+		
+		probe->count = 0;
+		probe->reported = true;
+	}
+#endif
+}
+
+/** Finish a spinning loop once the spinlock has been acquired
+ *
+ * @param probe  Spinning loop state.
+ * @param lock   Acquired spinlock.
+ * @param caller Code acquiring the spinlock.
+ *
+ */
+NO_TRACE static inline void spin_probe_done(spin_probe_t *probe,
+    spinlock_t *lock, uintptr_t caller)
+{
+#ifdef CONFIG_DEBUG_SPINLOCK
+	if (probe->reported)
+		printf("cpu%u: not deadlocked\n", CPU->id);
+#endif
+	
+#ifdef CONFIG_LOCKSTAT
+	lockstat_record(LOCKSTAT_SPINLOCK, (uintptr_t) lock->name, caller,
+	    probe->contended, (probe->contended) ? get_cycle() - probe->start : 0);
+#endif
+}
+
+#if defined(CONFIG_SPINLOCK_ticket)
+
 /** Initialize spinlock
  *
  * @param sl Pointer to spinlock_t structure.
@@ -54,65 +163,353 @@
  */
 void spinlock_initialize(spinlock_t *lock, const char *name)
 {
-	atomic_set(&lock->val, 0);
-#ifdef CONFIG_DEBUG_SPINLOCK
+	atomic_set(&lock->next, 0);
+	atomic_set(&lock->owner, 0);
+#ifdef SPINLOCK_NAMED
 	lock->name = name;
 #endif
 }
 
-#ifdef CONFIG_DEBUG_SPINLOCK
+/** Acquire spinlock
+ *
+ * Draw a ticket and wait until the owner field reaches it.
+ * Waiters acquire the lock in the order of their arrival.
+ *
+ * @param lock   Pointer to spinlock_t structure.
+ * @param caller Code acquiring the spinlock.
+ *
+ */
+static void spinlock_acquire(spinlock_t *lock, uintptr_t caller)
+{
+	spin_probe_t probe;
+	spin_probe_init(&probe);
+	
+	preemption_disable();
+	atomic_count_t ticket = atomic_postinc(&lock->next);
+	
+	while (atomic_get(&lock->owner) != ticket)
+		spin_probe(&probe, lock, caller);
+	
+	spin_probe_done(&probe, lock, caller);
+	
+	/*
+	 * Prevent critical section code from bleeding out this way up.
+	 */
+	CS_ENTER_BARRIER();
+}
 
 /** Lock spinlock
- *
- * Lock spinlock.
- * This version has limitted ability to report 
- * possible occurence of deadlock.
  *
  * @param lock Pointer to spinlock_t structure.
  *
  */
-void spinlock_lock_debug(spinlock_t *lock)
+void spinlock_lock_queued(spinlock_t *lock)
+{
+	spinlock_acquire(lock, CALLER);
+}
+
+/** Unlock spinlock
+ *
+ * Pass the lock to the holder of the next ticket.
+ *
+ * @param sl Pointer to spinlock_t structure.
+ */
+void spinlock_unlock_queued(spinlock_t *lock)
 {
-	size_t i = 0;
-	bool deadlock_reported = false;
+	ASSERT_SPINLOCK(spinlock_locked(lock), lock);
 	
+	/*
+	 * Prevent critical section code from bleeding out this way down.
+	 */
+	CS_LEAVE_BARRIER();
+	
+	/* Only the owner ever modifies the owner field */
+	atomic_set(&lock->owner, atomic_get(&lock->owner) + 1);
+	preemption_enable();
+}
+
+/** Lock spinlock conditionally
+ *
+ * Lock spinlock conditionally. If the spinlock is not available
+ * at the moment, signal failure.
+ *
+ * @param lock Pointer to spinlock_t structure.
+ *
+ * @return Zero on failure, non-zero otherwise.
+ *
+ */
+int spinlock_trylock(spinlock_t *lock)
+{
 	preemption_disable();
-	while (test_and_set(&lock->val)) {
-		/*
-		 * We need to be careful about particular locks
-		 * which are directly used to report deadlocks
-		 * via printf() (and recursively other functions).
-		 * This conserns especially printf_lock and the
-		 * framebuffer lock.
-		 *
-		 * Any lock whose name is prefixed by "*" will be
-		 * ignored by this deadlock detection routine
-		 * as this might cause an infinite recursion.
-		 * We trust our code that there is no possible deadlock
-		 * caused by these locks (except when an exception
-		 * is triggered for instance by printf()).
-		 *
-		 * We encountered false positives caused by very
-		 * slow framebuffer interaction (especially when
-		 * run in a simulator) that caused problems with both
-		 * printf_lock and the framebuffer lock.
-		 */
-		if (lock->name[0] == '*')
-			continue;
+	
+	/* Draw a ticket only if it would be served right away */
+	atomic_count_t owner = atomic_get(&lock->owner);
+	int rc = atomic_cas(&lock->next, owner, owner + 1);
+	
+	/*
+	 * Prevent critical section code from bleeding out this way up.
+	 */
+	CS_ENTER_BARRIER();
+	
+	if (!rc)
+		preemption_enable();
+	
+	return rc;
+}
+
+/** Find out whether the spinlock is currently locked.
+ *
+ * @param lock		Spinlock.
+ * @return		True if the spinlock is locked, false otherwise.
+ */
+bool spinlock_locked(spinlock_t *lock)
+{
+	return atomic_get(&lock->next) != atomic_get(&lock->owner);
+}
+
+#elif defined(CONFIG_SPINLOCK_mcs)
+
+/** Queue nodes used before the CPU structure is set up */
+static mcs_cpu_t mcs_boot;
+
+/** Allocate a queue node of the current CPU
+ *
+ * The node bitmap is manipulated atomically so that the
+ * allocation is safe with respect to interrupt handlers
+ * on the same CPU and to application processors which
+ * share the boot set of nodes before their CPU structure
+ * is known.
+ *
+ * @return Queue node.
+ *
+ */
+static mcs_node_t *mcs_node_get(void)
+{
+	mcs_cpu_t *mcs = (CPU) ? &CPU->mcs : &mcs_boot;
+	
+	while (true) {
+		atomic_count_t used = atomic_get(&mcs->used);
+		
+		unsigned int i;
+		for (i = 0; i < MCS_NODES; i++) {
+			if (!(used & (1 << i)))
+				break;
+		}
+		
+		if (i == MCS_NODES)
+			panic("Too many nested spinlocks.");
 		
-		if (i++ > DEADLOCK_THRESHOLD) {
-			printf("cpu%u: looping on spinlock %p:%s, "
-			    "caller=%p (%s)\n", CPU->id, lock, lock->name,
-			    (void *) CALLER, symtab_fmt_name_lookup(CALLER));
-			stack_trace();
+		if (atomic_cas(&mcs->used, used, used | (1 << i))) {
+			mcs_node_t *node = &mcs->nodes[i];
 			
-			i = 0;
-			deadlock_reported = true;
+			node->next = NULL;
+			node->locked = true;
+			node->cpu = mcs;
+			
+			return node;
 		}
 	}
+}
+
+/** Release a queue node
+ *
+ * @param node Queue node previously returned by mcs_node_get().
+ *
+ */
+static void mcs_node_put(mcs_node_t *node)
+{
+	mcs_cpu_t *mcs = node->cpu;
+	atomic_count_t mask = 1 << (node - mcs->nodes);
+	atomic_count_t used;
 	
-	if (deadlock_reported)
-		printf("cpu%u: not deadlocked\n", CPU->id);
+	do {
+		used = atomic_get(&mcs->used);
+	} while (!atomic_cas(&mcs->used, used, used & ~mask));
+}
+
+/** Initialize spinlock
+ *
+ * @param sl Pointer to spinlock_t structure.
+ *
+ */
+void spinlock_initialize(spinlock_t *lock, const char *name)
+{
+	atomic_set(&lock->tail, 0);
+	lock->holder = NULL;
+#ifdef SPINLOCK_NAMED
+	lock->name = name;
+#endif
+}
+
+/** Acquire spinlock
+ *
+ * Append a queue node of the current CPU to the tail of the
+ * lock queue and spin on the node until the predecessor hands
+ * the lock over.
+ *
+ * @param lock   Pointer to spinlock_t structure.
+ * @param caller Code acquiring the spinlock.
+ *
+ */
+static void spinlock_acquire(spinlock_t *lock, uintptr_t caller)
+{
+	spin_probe_t probe;
+	spin_probe_init(&probe);
+	
+	preemption_disable();
+	mcs_node_t *node = mcs_node_get();
+	
+	/* Make the node initialization visible before publishing it */
+	write_barrier();
+	
+	atomic_count_t prev;
+	do {
+		prev = atomic_get(&lock->tail);
+	} while (!atomic_cas(&lock->tail, prev, (atomic_count_t) node));
+	
+	if (prev != 0) {
+		((mcs_node_t *) prev)->next = node;
+		
+		while (node->locked)
+			spin_probe(&probe, lock, caller);
+	}
+	
+	spin_probe_done(&probe, lock, caller);
+	
+	/*
+	 * Prevent critical section code from bleeding out this way up.
+	 */
+	CS_ENTER_BARRIER();
+	
+	lock->holder = node;
+}
+
+/** Lock spinlock
+ *
+ * @param lock Pointer to spinlock_t structure.
+ *
+ */
+void spinlock_lock_queued(spinlock_t *lock)
+{
+	spinlock_acquire(lock, CALLER);
+}
+
+/** Unlock spinlock
+ *
+ * Hand the lock over to the successor in the queue,
+ * or mark the lock as free if there is none.
+ *
+ * @param sl Pointer to spinlock_t structure.
+ */
+void spinlock_unlock_queued(spinlock_t *lock)
+{
+	ASSERT_SPINLOCK(spinlock_locked(lock), lock);
+	
+	mcs_node_t *node = lock->holder;
+	
+	/*
+	 * Prevent critical section code from bleeding out this way down.
+	 */
+	CS_LEAVE_BARRIER();
+	
+	if (node->next == NULL) {
+		if (atomic_cas(&lock->tail, (atomic_count_t) node, 0)) {
+			mcs_node_put(node);
+			preemption_enable();
+			return;
+		}
+		
+		/* A successor is just linking itself in */
+		while (node->next == NULL);
+	}
+	
+	node->next->locked = false;
+	mcs_node_put(node);
+	preemption_enable();
+}
+
+/** Lock spinlock conditionally
+ *
+ * Lock spinlock conditionally. If the spinlock is not available
+ * at the moment, signal failure.
+ *
+ * @param lock Pointer to spinlock_t structure.
+ *
+ * @return Zero on failure, non-zero otherwise.
+ *
+ */
+int spinlock_trylock(spinlock_t *lock)
+{
+	preemption_disable();
+	mcs_node_t *node = mcs_node_get();
+	
+	/* Make the node initialization visible before publishing it */
+	write_barrier();
+	
+	int rc = atomic_cas(&lock->tail, 0, (atomic_count_t) node);
+	
+	/*
+	 * Prevent critical section code from bleeding out this way up.
+	 */
+	CS_ENTER_BARRIER();
+	
+	if (rc)
+		lock->holder = node;
+	else {
+		mcs_node_put(node);
+		preemption_enable();
+	}
+	
+	return rc;
+}
+
+/** Find out whether the spinlock is currently locked.
+ *
+ * @param lock		Spinlock.
+ * @return		True if the spinlock is locked, false otherwise.
+ */
+bool spinlock_locked(spinlock_t *lock)
+{
+	return atomic_get(&lock->tail) != 0;
+}
+
+#else
+
+/** Initialize spinlock
+ *
+ * @param sl Pointer to spinlock_t structure.
+ *
+ */
+void spinlock_initialize(spinlock_t *lock, const char *name)
+{
+	atomic_set(&lock->val, 0);
+#ifdef SPINLOCK_NAMED
+	lock->name = name;
+#endif
+}
+
+#ifdef SPINLOCK_NAMED
+
+/** Acquire spinlock
+ *
+ * This version has limitted ability to report
+ * possible occurence of deadlock and collects
+ * contention statistics.
+ *
+ * @param lock   Pointer to spinlock_t structure.
+ * @param caller Code acquiring the spinlock.
+ *
+ */
+static void spinlock_acquire(spinlock_t *lock, uintptr_t caller)
+{
+	spin_probe_t probe;
+	spin_probe_init(&probe);
+	
+	preemption_disable();
+	while (test_and_set(&lock->val))
+		spin_probe(&probe, lock, caller);
+	
+	spin_probe_done(&probe, lock, caller);
 	
 	/*
 	 * Prevent critical section code from bleeding out this way up.
@@ -120,6 +517,16 @@ void spinlock_lock_debug(spinlock_t *lock)
 	CS_ENTER_BARRIER();
 }
 
+/** Lock spinlock
+ *
+ * @param lock Pointer to spinlock_t structure.
+ *
+ */
+void spinlock_lock_debug(spinlock_t *lock)
+{
+	spinlock_acquire(lock, CALLER);
+}
+
 /** Unlock spinlock
  *
  * Unlock spinlock.
@@ -179,6 +586,18 @@ bool spinlock_locked(spinlock_t *lock)
 
 #endif
 
+#endif
+
+/*
+ * Interrupts-disabled spinlocks acquire their spinlock on behalf
+ * of their caller where the spinlock implementation cares about it.
+ */
+#if (defined(SPINLOCK_QUEUED)) || (defined(SPINLOCK_NAMED))
+	#define spinlock_lock_caller(lock, caller)  spinlock_acquire((lock), (caller))
+#else
+	#define spinlock_lock_caller(lock, caller)  spinlock_lock((lock))
+#endif
+
 /** Initialize interrupts-disabled spinlock
  *
  * @param lock IRQ spinlock to be initialized.
@@ -206,14 +625,14 @@ void irq_spinlock_lock(irq_spinlock_t *lock, bool irq_dis)
 {
 	if (irq_dis) {
 		ipl_t ipl = interrupts_disable();
-		spinlock_lock(&(lock->lock));
+		spinlock_lock_caller(&(lock->lock), CALLER);
 		
 		lock->guard = true;
 		lock->ipl = ipl;
 	} else {
 		ASSERT_IRQ_SPINLOCK(interrupts_disabled(), lock);
 		
-		spinlock_lock(&(lock->lock));
+		spinlock_lock_caller(&(lock->lock), CALLER);
 		ASSERT_IRQ_SPINLOCK(!lock->guard, lock);
 	}
 }
@@ -286,7 +705,7 @@ void irq_spinlock_pass(irq_spinlock_t *unlock, irq_spinlock_t *lock)
 	unlock->guard = false;
 	
 	spinlock_unlock(&(unlock->lock));
-	spinlock_lock(&(lock->lock));
+	spinlock_lock_caller(&(lock->lock), CALLER);
 	
 	ASSERT_IRQ_SPINLOCK(!lock->guard, lock);
 	
@@ -311,7 +730,7 @@ void irq_spinlock_exchange(irq_spinlock_t *unlock, irq_spinlock_t *lock)
 {
 	ASSERT_IRQ_SPINLOCK(interrupts_disabled(), unlock);
 	
-	spinlock_lock(&(lock->lock));
+	spinlock_lock_caller(&(lock->lock), CALLER);
 	ASSERT_IRQ_SPINLOCK(!lock->guard, lock);
 	
 	/* Pass guard from unlock to lock */
@@ -90,7 +90,7 @@ void waitq_sleep_timed_out(void *data)
 	bool do_wakeup = false;
 	DEADLOCK_PROBE_INIT(p_wqlock);
 	
-	irq_spinlock_lock(&threads_lock, false);
+	irq_rwlock_read_lock(&threads_lock, false);
 	if (!thread_exists(thread))
 		goto out;
 	
@@ -120,7 +120,7 @@ grab_locks:
 		thread_ready(thread);
 	
 out:
-	irq_spinlock_unlock(&threads_lock, false);
+	irq_rwlock_read_unlock(&threads_lock, false);
 }
 
 /** Interrupt sleeping thread.
@@ -440,6 +440,13 @@ void waitq_wakeup(waitq_t *wq, wakeup_mode_t mode)
 	irq_spinlock_lock(&wq->lock, true);
 	_waitq_wakeup_unsafe(wq, mode);
 	irq_spinlock_unlock(&wq->lock, true);
+	
+	/*
+	 * Let a woken up real-time thread run right away. Interrupt
+	 * handlers leave this to exc_dispatch() once they are done.
+	 */
+	if (!interrupts_disabled())
+		scheduler_preempt();
 }
 
 /** Internal SMP- and IRQ-unsafe version of waitq_wakeup()
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup generic
+ * @{
+ */
+
+/**
+ * @file
+ * @brief System call dispatching.
+ */
+
+#include <syscall/syscall.h>
+#include <synch/futex.h>
+#include <proc/thread.h>
+#include <proc/task.h>
+#include <arch.h>
+#include <print.h>
+
+/** Dispatch system call
+ *
+ * Called directly from the assembler code with interrupts enabled.
+ *
+ * @param a1 .. a6 Arguments of the system call.
+ * @param id       System call number.
+ *
+ * @return Return value of the system call handler.
+ *
+ */
+sysarg_t syscall_handler(sysarg_t a1, sysarg_t a2, sysarg_t a3,
+    sysarg_t a4, sysarg_t a5, sysarg_t a6, sysarg_t id)
+{
+	/* Account user cycles */
+	irq_spinlock_lock(&THREAD->lock, true);
+	thread_update_accounting(true);
+	irq_spinlock_unlock(&THREAD->lock, true);
+	
+	sysarg_t rc;
+	if (id < SYSCALL_END) {
+		rc = syscall_table[id](a1, a2, a3, a4, a5, a6);
+	} else {
+		printf("Task %" PRIu64 ": Unknown syscall %#" PRIxn ".\n",
+		    TASK->taskid, id);
+		task_kill_self(true);
+		rc = (sysarg_t) -1;
+	}
+	
+	/* Account kernel cycles */
+	irq_spinlock_lock(&THREAD->lock, true);
+	thread_update_accounting(false);
+	irq_spinlock_unlock(&THREAD->lock, true);
+	
+	return rc;
+}
+
+/** Cast a handler which takes fewer arguments to the generic type. */
+#define SYSCALL_HANDLER(handler) \
+	((syshandler_t) (void (*)(void)) (handler))
+
+/** System call table. */
+syshandler_t syscall_table[SYSCALL_END] = {
+	/* Synchronization related syscalls. */
+	SYSCALL_HANDLER(sys_futex_wait),
+	SYSCALL_HANDLER(sys_futex_wake),
+	SYSCALL_HANDLER(sys_futex_requeue),
+	SYSCALL_HANDLER(sys_futex_wake_op)
+};
+
+/** @}
+ */
@@ -40,6 +40,8 @@
 #include <synch/spinlock.h>
 #include <synch/mutex.h>
 #include <time/clock.h>
+#include <mm/as.h>
+#include <atomic.h>
 #include <mm/frame.h>
 #include <proc/task.h>
 #include <proc/thread.h>
@@ -148,35 +150,10 @@ static bool avl_count_walker(avltree_node_t *node, void *arg)
 static size_t get_task_virtmem(as_t *as)
 {
 	/*
-	 * We are holding spinlocks here and therefore are not allowed to
-	 * block. Only attempt to lock the address space and address space
-	 * area mutexes conditionally. If it is not possible to lock either
-	 * object, return inexact statistics by skipping the respective object.
+	 * The counter is maintained by the address space code and
+	 * can be read without locking the address space.
 	 */
-	
-	if (SYNCH_FAILED(mutex_trylock(&as->lock)))
-		return 0;
-	
-	size_t pages = 0;
-	
-	/* Walk the B+ tree and count pages */
-	list_foreach(as->as_area_btree.leaf_list, leaf_link, btree_node_t,
-	    node) {
-		unsigned int i;
-		for (i = 0; i < node->keys; i++) {
-			as_area_t *area = node->value[i];
-			
-			if (SYNCH_FAILED(mutex_trylock(&area->lock)))
-				continue;
-			
-			pages += area->pages;
-			mutex_unlock(&area->lock);
-		}
-	}
-	
-	mutex_unlock(&as->lock);
-	
-	return (pages << PAGE_WIDTH);
+	return (atomic_get(&as->virt_pages) << PAGE_WIDTH);
 }
 
 /** Get the resident (used) size of a virtual address space
@@ -189,34 +166,10 @@ static size_t get_task_virtmem(as_t *as)
 static size_t get_task_resmem(as_t *as)
 {
 	/*
-	 * We are holding spinlocks here and therefore are not allowed to
-	 * block. Only attempt to lock the address space and address space
-	 * area mutexes conditionally. If it is not possible to lock either
-	 * object, return inexact statistics by skipping the respective object.
+	 * The counter is maintained by the address space code and
+	 * can be read without locking the address space.
 	 */
-	
-	if (SYNCH_FAILED(mutex_trylock(&as->lock)))
-		return 0;
-	
-	size_t pages = 0;
-	
-	/* Walk the B+ tree and count pages */
-	list_foreach(as->as_area_btree.leaf_list, leaf_link, btree_node_t, node) {
-		unsigned int i;
-		for (i = 0; i < node->keys; i++) {
-			as_area_t *area = node->value[i];
-			
-			if (SYNCH_FAILED(mutex_trylock(&area->lock)))
-				continue;
-			
-			pages += area->resident;
-			mutex_unlock(&area->lock);
-		}
-	}
-	
-	mutex_unlock(&as->lock);
-	
-	return (pages << PAGE_WIDTH);
+	return (atomic_get(&as->resident_pages) << PAGE_WIDTH);
 }
 
 /* Produce task statistics
@@ -284,7 +237,7 @@ static void *get_stats_tasks(struct sysinfo_item *item, size_t *size,
     bool dry_run, void *data)
 {
 	/* Messing with task structures, avoid deadlock */
-	irq_spinlock_lock(&tasks_lock, true);
+	irq_rwlock_read_lock(&tasks_lock, true);
 	
 	/* First walk the task tree to count the tasks */
 	size_t count = 0;
@@ -292,21 +245,21 @@ static void *get_stats_tasks(struct sysinfo_item *item, size_t *size,
 	
 	if (count == 0) {
 		/* No tasks found (strange) */
-		irq_spinlock_unlock(&tasks_lock, true);
+		irq_rwlock_read_unlock(&tasks_lock, true);
 		*size = 0;
 		return NULL;
 	}
 	
 	*size = sizeof(stats_task_t) * count;
 	if (dry_run) {
-		irq_spinlock_unlock(&tasks_lock, true);
+		irq_rwlock_read_unlock(&tasks_lock, true);
 		return NULL;
 	}
 	
 	stats_task_t *stats_tasks = (stats_task_t *) malloc(*size, FRAME_ATOMIC);
 	if (stats_tasks == NULL) {
 		/* No free space for allocation */
-		irq_spinlock_unlock(&tasks_lock, true);
+		irq_rwlock_read_unlock(&tasks_lock, true);
 		*size = 0;
 		return NULL;
 	}
@@ -315,7 +268,7 @@ static void *get_stats_tasks(struct sysinfo_item *item, size_t *size,
 	stats_task_t *iterator = stats_tasks;
 	avltree_walk(&tasks_tree, task_serialize_walker, (void *) &iterator);
 	
-	irq_spinlock_unlock(&tasks_lock, true);
+	irq_rwlock_read_unlock(&tasks_lock, true);
 	
 	return ((void *) stats_tasks);
 }
@@ -390,7 +343,7 @@ static void *get_stats_threads(struct sysinfo_item *item, size_t *size,
     bool dry_run, void *data)
 {
 	/* Messing with threads structures, avoid deadlock */
-	irq_spinlock_lock(&threads_lock, true);
+	irq_rwlock_read_lock(&threads_lock, true);
 	
 	/* First walk the thread tree to count the threads */
 	size_t count = 0;
@@ -398,21 +351,21 @@ static void *get_stats_threads(struct sysinfo_item *item, size_t *size,
 	
 	if (count == 0) {
 		/* No threads found (strange) */
-		irq_spinlock_unlock(&threads_lock, true);
+		irq_rwlock_read_unlock(&threads_lock, true);
 		*size = 0;
 		return NULL;
 	}
 	
 	*size = sizeof(stats_thread_t) * count;
 	if (dry_run) {
-		irq_spinlock_unlock(&threads_lock, true);
+		irq_rwlock_read_unlock(&threads_lock, true);
 		return NULL;
 	}
 	
 	stats_thread_t *stats_threads = (stats_thread_t *) malloc(*size, FRAME_ATOMIC);
 	if (stats_threads == NULL) {
 		/* No free space for allocation */
-		irq_spinlock_unlock(&threads_lock, true);
+		irq_rwlock_read_unlock(&threads_lock, true);
 		*size = 0;
 		return NULL;
 	}
@@ -421,7 +374,7 @@ static void *get_stats_threads(struct sysinfo_item *item, size_t *size,
 	stats_thread_t *iterator = stats_threads;
 	avltree_walk(&threads_tree, thread_serialize_walker, (void *) &iterator);
 	
-	irq_spinlock_unlock(&threads_lock, true);
+	irq_rwlock_read_unlock(&threads_lock, true);
 	
 	return ((void *) stats_threads);
 }
@@ -457,12 +410,12 @@ static sysinfo_return_t get_stats_task(const char *name, bool dry_run,
 		return ret;
 	
 	/* Messing with task structures, avoid deadlock */
-	irq_spinlock_lock(&tasks_lock, true);
+	irq_rwlock_read_lock(&tasks_lock, true);
 	
 	task_t *task = task_find_by_id(task_id);
 	if (task == NULL) {
 		/* No task with this ID */
-		irq_spinlock_unlock(&tasks_lock, true);
+		irq_rwlock_read_unlock(&tasks_lock, true);
 		return ret;
 	}
 	
@@ -471,13 +424,13 @@ static sysinfo_return_t get_stats_task(const char *name, bool dry_run,
 		ret.data.data = NULL;
 		ret.data.size = sizeof(stats_task_t);
 		
-		irq_spinlock_unlock(&tasks_lock, true);
+		irq_rwlock_read_unlock(&tasks_lock, true);
 	} else {
 		/* Allocate stats_task_t structure */
 		stats_task_t *stats_task =
 		    (stats_task_t *) malloc(sizeof(stats_task_t), FRAME_ATOMIC);
 		if (stats_task == NULL) {
-			irq_spinlock_unlock(&tasks_lock, true);
+			irq_rwlock_read_unlock(&tasks_lock, true);
 			return ret;
 		}
 		
@@ -486,12 +439,15 @@ static sysinfo_return_t get_stats_task(const char *name, bool dry_run,
 		ret.data.data = (void *) stats_task;
 		ret.data.size = sizeof(stats_task_t);
 		
-		/* Hand-over-hand locking */
-		irq_spinlock_exchange(&tasks_lock, &task->lock);
-		
+		/*
+		 * Readers do not exclude each other, so the tree stays
+		 * locked while the task is inspected.
+		 */
+		irq_spinlock_lock(&task->lock, false);
 		produce_stats_task(task, stats_task);
+		irq_spinlock_unlock(&task->lock, false);
 		
-		irq_spinlock_unlock(&task->lock, true);
+		irq_rwlock_read_unlock(&tasks_lock, true);
 	}
 	
 	return ret;
@@ -528,12 +484,12 @@ static sysinfo_return_t get_stats_thread(const char *name, bool dry_run,
 		return ret;
 	
 	/* Messing with threads structures, avoid deadlock */
-	irq_spinlock_lock(&threads_lock, true);
+	irq_rwlock_read_lock(&threads_lock, true);
 	
 	thread_t *thread = thread_find_by_id(thread_id);
 	if (thread == NULL) {
 		/* No thread with this ID */
-		irq_spinlock_unlock(&threads_lock, true);
+		irq_rwlock_read_unlock(&threads_lock, true);
 		return ret;
 	}
 	
@@ -542,13 +498,13 @@ static sysinfo_return_t get_stats_thread(const char *name, bool dry_run,
 		ret.data.data = NULL;
 		ret.data.size = sizeof(stats_thread_t);
 		
-		irq_spinlock_unlock(&threads_lock, true);
+		irq_rwlock_read_unlock(&threads_lock, true);
 	} else {
 		/* Allocate stats_thread_t structure */
 		stats_thread_t *stats_thread =
 		    (stats_thread_t *) malloc(sizeof(stats_thread_t), FRAME_ATOMIC);
 		if (stats_thread == NULL) {
-			irq_spinlock_unlock(&threads_lock, true);
+			irq_rwlock_read_unlock(&threads_lock, true);
 			return ret;
 		}
 		
@@ -557,12 +513,15 @@ static sysinfo_return_t get_stats_thread(const char *name, bool dry_run,
 		ret.data.data = (void *) stats_thread;
 		ret.data.size = sizeof(stats_thread_t);
 		
-		/* Hand-over-hand locking */
-		irq_spinlock_exchange(&threads_lock, &thread->lock);
-		
+		/*
+		 * Readers do not exclude each other, so the tree stays
+		 * locked while the thread is inspected.
+		 */
+		irq_spinlock_lock(&thread->lock, false);
 		produce_stats_thread(thread, stats_thread);
+		irq_spinlock_unlock(&thread->lock, false);
 		
-		irq_spinlock_unlock(&thread->lock, true);
+		irq_rwlock_read_unlock(&threads_lock, true);
 	}
 	
 	return ret;
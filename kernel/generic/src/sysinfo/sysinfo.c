@@ -36,7 +36,7 @@
 #include <sysinfo/sysinfo.h>
 #include <mm/slab.h>
 #include <print.h>
-#include <synch/mutex.h>
+#include <synch/rwlock.h>
 #include <arch/asm.h>
 #include <errno.h>
 #include <macros.h>
@@ -53,7 +53,7 @@ static sysinfo_item_t *global_root = NULL;
 static slab_cache_t *sysinfo_item_slab;
 
 /** Sysinfo lock */
-static mutex_t sysinfo_lock;
+static rwlock_t sysinfo_lock;
 
 /** Sysinfo item constructor
  *
@@ -99,7 +99,7 @@ void sysinfo_init(void)
 	    sizeof(sysinfo_item_t), 0, sysinfo_item_constructor,
 	    sysinfo_item_destructor, SLAB_CACHE_MAGDEFERRED);
 	
-	mutex_initialize(&sysinfo_lock, MUTEX_ACTIVE);
+	rwlock_initialize(&sysinfo_lock, MUTEX_ACTIVE);
 }
 
 /** Recursively create items in sysinfo tree
@@ -234,7 +234,7 @@ void sysinfo_set_item_val(const char *name, sysinfo_item_t **root,
     sysarg_t val)
 {
 	/* Protect sysinfo tree consistency */
-	mutex_lock(&sysinfo_lock);
+	rwlock_write_lock(&sysinfo_lock);
 	
 	if (root == NULL)
 		root = &global_root;
@@ -245,7 +245,7 @@ void sysinfo_set_item_val(const char *name, sysinfo_item_t **root,
 		item->val.val = val;
 	}
 	
-	mutex_unlock(&sysinfo_lock);
+	rwlock_write_unlock(&sysinfo_lock);
 }
 
 /** Set sysinfo item with a constant binary data
@@ -265,7 +265,7 @@ void sysinfo_set_item_data(const char *name, sysinfo_item_t **root,
     void *data, size_t size)
 {
 	/* Protect sysinfo tree consistency */
-	mutex_lock(&sysinfo_lock);
+	rwlock_write_lock(&sysinfo_lock);
 	
 	if (root == NULL)
 		root = &global_root;
@@ -277,7 +277,7 @@ void sysinfo_set_item_data(const char *name, sysinfo_item_t **root,
 		item->val.data.size = size;
 	}
 	
-	mutex_unlock(&sysinfo_lock);
+	rwlock_write_unlock(&sysinfo_lock);
 }
 
 /** Set sysinfo item with a generated numeric value
@@ -293,7 +293,7 @@ void sysinfo_set_item_gen_val(const char *name, sysinfo_item_t **root,
     sysinfo_fn_val_t fn, void *data)
 {
 	/* Protect sysinfo tree consistency */
-	mutex_lock(&sysinfo_lock);
+	rwlock_write_lock(&sysinfo_lock);
 	
 	if (root == NULL)
 		root = &global_root;
@@ -305,7 +305,7 @@ void sysinfo_set_item_gen_val(const char *name, sysinfo_item_t **root,
 		item->val.gen_val.data = data;
 	}
 	
-	mutex_unlock(&sysinfo_lock);
+	rwlock_write_unlock(&sysinfo_lock);
 }
 
 /** Set sysinfo item with a generated binary data
@@ -326,7 +326,7 @@ void sysinfo_set_item_gen_data(const char *name, sysinfo_item_t **root,
     sysinfo_fn_data_t fn, void *data)
 {
 	/* Protect sysinfo tree consistency */
-	mutex_lock(&sysinfo_lock);
+	rwlock_write_lock(&sysinfo_lock);
 	
 	if (root == NULL)
 		root = &global_root;
@@ -338,7 +338,7 @@ void sysinfo_set_item_gen_data(const char *name, sysinfo_item_t **root,
 		item->val.gen_data.data = data;
 	}
 	
-	mutex_unlock(&sysinfo_lock);
+	rwlock_write_unlock(&sysinfo_lock);
 }
 
 /** Set sysinfo item with an undefined value
@@ -351,7 +351,7 @@ void sysinfo_set_item_gen_data(const char *name, sysinfo_item_t **root,
 void sysinfo_set_item_undefined(const char *name, sysinfo_item_t **root)
 {
 	/* Protect sysinfo tree consistency */
-	mutex_lock(&sysinfo_lock);
+	rwlock_write_lock(&sysinfo_lock);
 	
 	if (root == NULL)
 		root = &global_root;
@@ -360,7 +360,7 @@ void sysinfo_set_item_undefined(const char *name, sysinfo_item_t **root)
 	if (item != NULL)
 		item->val_type = SYSINFO_VAL_UNDEFINED;
 	
-	mutex_unlock(&sysinfo_lock);
+	rwlock_write_unlock(&sysinfo_lock);
 }
 
 /** Set sysinfo item with a generated subtree
@@ -376,7 +376,7 @@ void sysinfo_set_subtree_fn(const char *name, sysinfo_item_t **root,
     sysinfo_fn_subtree_t fn, void *data)
 {
 	/* Protect sysinfo tree consistency */
-	mutex_lock(&sysinfo_lock);
+	rwlock_write_lock(&sysinfo_lock);
 	
 	if (root == NULL)
 		root = &global_root;
@@ -391,7 +391,7 @@ void sysinfo_set_subtree_fn(const char *name, sysinfo_item_t **root,
 		item->subtree.generator.data = data;
 	}
 	
-	mutex_unlock(&sysinfo_lock);
+	rwlock_write_unlock(&sysinfo_lock);
 }
 
 /** Sysinfo dump indentation helper routine
@@ -487,14 +487,14 @@ void sysinfo_dump(sysinfo_item_t *root)
 {
 	/* Avoid other functions to mess with sysinfo
 	   while we are dumping it */
-	mutex_lock(&sysinfo_lock);
+	rwlock_read_lock(&sysinfo_lock);
 	
 	if (root == NULL)
 		sysinfo_dump_internal(global_root, 0);
 	else
 		sysinfo_dump_internal(root, 0);
 	
-	mutex_unlock(&sysinfo_lock);
+	rwlock_read_unlock(&sysinfo_lock);
 }
 
 /** @}
@@ -38,6 +38,11 @@
  * of preemption. It is also responsible for executing expired
  * timeouts.
  *
+ * Architectures which define clock_program_arch() do not interrupt
+ * the CPU every tick, but only when the next timeout expires or the
+ * time slice of the current thread ends. The ticks in between are
+ * reported to clock() as missed clock ticks.
+ *
  */
 
 #include <time/clock.h>
@@ -57,6 +62,10 @@
 #include <mm/frame.h>
 #include <ddi/ddi.h>
 #include <arch/cycle.h>
+#include <arch/interrupt.h>
+#include <arch/asm.h>
+#include <macros.h>
+#include <debug.h>
 
 /* Pointer to variable with uptime */
 uptime_t *uptime;
@@ -64,6 +73,13 @@ uptime_t *uptime;
 /** Physical memory area of the real time clock */
 static parea_t clock_parea;
 
+/** Conversion of cycle counter values to nanoseconds. */
+static uint32_t cycle_mult = 0;
+static uint32_t cycle_shift = 0;
+
+/** Cycle counter value at which the monotonic clock started. */
+static uint64_t cycle_base = 0;
+
 /** Fragment of second
  *
  * For updating  seconds correctly.
@@ -89,6 +105,9 @@ void clock_counter_init(void)
 	uptime->seconds1 = 0;
 	uptime->seconds2 = 0;
 	uptime->useconds = 0;
+	uptime->cycle_mult = cycle_mult;
+	uptime->cycle_shift = cycle_shift;
+	uptime->cycle_base = cycle_base;
 	
 	clock_parea.pbase = faddr;
 	clock_parea.frames = 1;
@@ -104,6 +123,105 @@ void clock_counter_init(void)
 	sysinfo_set_item_val("clock.faddr", NULL, (sysarg_t) faddr);
 }
 
+/** Divide a 64-bit number by a 32-bit number
+ *
+ * Used only to set up the monotonic clock, so that
+ * no support for 64-bit division is needed.
+ *
+ */
+NO_TRACE static uint64_t clock_div(uint64_t dividend, uint32_t divisor)
+{
+	uint64_t quotient = 0;
+	uint64_t remainder = 0;
+	int i;
+	
+	for (i = 63; i >= 0; i--) {
+		remainder = (remainder << 1) | ((dividend >> i) & 1);
+		if (remainder >= divisor) {
+			remainder -= divisor;
+			quotient |= UINT64_C(1) << i;
+		}
+	}
+	
+	return quotient;
+}
+
+/** Use the cycle counter as the monotonic clock source
+ *
+ * To be called from calibrate_delay_loop() on architectures
+ * whose get_cycle() counts at a constant and known frequency.
+ * Only the first call has any effect.
+ *
+ * @param freq Frequency of the cycle counter (Hz).
+ *
+ */
+void clock_source_init(uint32_t freq)
+{
+	ASSERT(freq != 0);
+	
+	if (cycle_mult != 0)
+		return;
+	
+	/* Use the most precise multiplier which fits into 32 bits. */
+	unsigned int shift = 32;
+	uint64_t mult;
+	while ((mult = clock_div(UINT64_C(1000000000) << shift, freq)) >
+	    UINT32_MAX)
+		shift--;
+	
+	cycle_base = get_cycle();
+	cycle_shift = shift;
+	cycle_mult = mult;
+}
+
+/** Convert cycle counter difference to nanoseconds
+ *
+ * The upper and the lower half of the cycle count are converted
+ * separately, so that the multiplication cannot overflow.
+ *
+ * @param cycles Number of cycles.
+ *
+ * @return Number of nanoseconds.
+ *
+ */
+uint64_t cycles2ns(uint64_t cycles)
+{
+	uint64_t upper = cycles >> 32;
+	uint64_t lower = cycles & UINT32_MAX;
+	
+	return ((upper * cycle_mult) << (32 - cycle_shift)) +
+	    ((lower * cycle_mult) >> cycle_shift);
+}
+
+/** Read the monotonic clock
+ *
+ * If the cycle counter cannot be used as the clock source,
+ * the clock has the resolution of the uptime counters.
+ *
+ * @return Nanoseconds since the clock started.
+ *
+ */
+uint64_t clock_ns(void)
+{
+	if (cycle_mult != 0)
+		return cycles2ns(get_cycle() - cycle_base);
+	
+	if (uptime == NULL)
+		return 0;
+	
+	sysarg_t sec2 = uptime->seconds2;
+	read_barrier();
+	sysarg_t usec = uptime->useconds;
+	read_barrier();
+	sysarg_t sec1 = uptime->seconds1;
+	
+	/* The counters have just crossed a second boundary. */
+	if (sec1 != sec2)
+		usec = 0;
+	
+	return (uint64_t) sec1 * 1000000000 + (uint64_t) usec * 1000;
+}
+
 /** Update public counters
  *
  * Update it only on first processor
@@ -135,6 +253,33 @@ static void cpu_update_accounting(void)
 	irq_spinlock_unlock(&CPU->lock, false);
 }
 
+/** Program the next clock interrupt
+ *
+ * Let the next clock interrupt on the current CPU come when the first
+ * timeout expires or the time slice of the current thread ends, but
+ * not later than CLOCK_TICKLESS_MAX ticks after the last one.
+ *
+ * Interrupts must be disabled.
+ *
+ */
+void clock_program(void)
+{
+#ifdef clock_program_arch
+	ASSERT(interrupts_disabled());
+	
+	uint64_t ticks = min(timeout_next(), CLOCK_TICKLESS_MAX);
+	
+	/*
+	 * The ticks of the current thread are modified
+	 * only by the current CPU with interrupts disabled.
+	 */
+	if ((THREAD) && (THREAD->ticks < ticks))
+		ticks = THREAD->ticks + 1;
+	
+	clock_program_arch(ticks);
+#endif
+}
+
 /** Clock routine
  *
  * Clock routine executed from clock interrupt handler
@@ -150,8 +295,7 @@ void clock(void)
 	cpu_update_accounting();
 	
 	/*
-	 * To avoid lock ordering problems,
-	 * run all expired timeouts as you visit them.
+	 * Run the expired timeouts for each tick.
 	 *
 	 */
 	size_t i;
@@ -160,61 +304,45 @@ void clock(void)
 		clock_update_counters();
 		cpu_update_accounting();
 		
-		irq_spinlock_lock(&CPU->timeoutlock, false);
-		
-		link_t *cur;
-		while ((cur = list_first(&CPU->timeout_active_list)) != NULL) {
-			timeout_t *timeout = list_get_instance(cur, timeout_t,
-			    link);
-			
-			irq_spinlock_lock(&timeout->lock, false);
-			if (timeout->ticks-- != 0) {
-				irq_spinlock_unlock(&timeout->lock, false);
-				break;
-			}
-			
-			list_remove(cur);
-			timeout_handler_t handler = timeout->handler;
-			void *arg = timeout->arg;
-			timeout_reinitialize(timeout);
-			
-			irq_spinlock_unlock(&timeout->lock, false);
-			irq_spinlock_unlock(&CPU->timeoutlock, false);
-			
-			handler(arg);
-			
-			irq_spinlock_lock(&CPU->timeoutlock, false);
-		}
-		
-		irq_spinlock_unlock(&CPU->timeoutlock, false);
+		timeout_tick();
 	}
 	CPU->missed_clock_ticks = 0;
 	
+	bool throttle = rt_tick(1 + missed_clock_ticks);
+	
 	/*
 	 * Do CPU usage accounting and find out whether to preempt THREAD.
 	 *
 	 */
 	
 	if (THREAD) {
-		uint64_t ticks;
+		bool expired;
 		
 		irq_spinlock_lock(&CPU->lock, false);
 		CPU->needs_relink += 1 + missed_clock_ticks;
 		irq_spinlock_unlock(&CPU->lock, false);
 		
+		/*
+		 * The time slice has expired if it ended
+		 * on one of the missed clock ticks.
+		 */
 		irq_spinlock_lock(&THREAD->lock, false);
-		if ((ticks = THREAD->ticks)) {
-			if (ticks >= 1 + missed_clock_ticks)
-				THREAD->ticks -= 1 + missed_clock_ticks;
-			else
-				THREAD->ticks = 0;
+		if (THREAD->ticks > missed_clock_ticks) {
+			THREAD->ticks -= 1 + missed_clock_ticks;
+			expired = false;
+		} else {
+			THREAD->ticks = 0;
+			expired = true;
 		}
 		irq_spinlock_unlock(&THREAD->lock, false);
 		
-		if ((!ticks) && (!PREEMPTION_DISABLED)) {
+		if ((expired || throttle) && (!PREEMPTION_DISABLED)) {
 			scheduler();
+			return;
 		}
 	}
+	
+	clock_program();
 }
 
 /** @}
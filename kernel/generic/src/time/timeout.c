@@ -33,9 +33,14 @@
 /**
  * @file
  * @brief Timeout management functions.
+ *
+ * Registered timeouts are kept in a per-CPU hierarchical timeout wheel.
+ * Registering and unregistering a timeout takes constant time, the
+ * timeouts which expire in the same tick are activated as a batch.
  */
 
 #include <time/timeout.h>
+#include <time/clock.h>
 #include <typedefs.h>
 #include <config.h>
 #include <panic.h>
@@ -44,6 +49,10 @@
 #include <cpu.h>
 #include <arch/asm.h>
 #include <arch.h>
+#include <bitops.h>
+#include <macros.h>
+#include <align.h>
+#include <debug.h>
 
 /** Initialize timeouts
  *
@@ -53,7 +62,21 @@
 void timeout_init(void)
 {
 	irq_spinlock_initialize(&CPU->timeoutlock, "cpu.timeoutlock");
-	list_initialize(&CPU->timeout_active_list);
+	
+	timeout_wheel_t *wheel = &CPU->timeout_wheel;
+	wheel->now = 0;
+	wheel->count = 0;
+	
+	unsigned int level;
+	for (level = 0; level < WHEEL_LEVELS; level++) {
+		wheel->map[level] = 0;
+		
+		unsigned int slot;
+		for (slot = 0; slot < WHEEL_SLOTS; slot++)
+			list_initialize(&wheel->slot[level][slot]);
+	}
+	
+	list_initialize(&wheel->overflow);
 }
 
 /** Reinitialize timeout
@@ -66,7 +89,7 @@ void timeout_init(void)
 void timeout_reinitialize(timeout_t *timeout)
 {
 	timeout->cpu = NULL;
-	timeout->ticks = 0;
+	timeout->deadline = 0;
 	timeout->handler = NULL;
 	timeout->arg = NULL;
 	link_initialize(&timeout->link);
@@ -85,6 +108,62 @@ void timeout_initialize(timeout_t *timeout)
 	timeout_reinitialize(timeout);
 }
 
+/** Insert timeout into the timeout wheel
+ *
+ * The timeout is put into the lowest level of the wheel which
+ * reaches its deadline, or into the overflow list if no level
+ * does. The timeout wheel lock must be held.
+ *
+ * @param wheel   Timeout wheel.
+ * @param timeout Timeout to insert.
+ *
+ */
+NO_TRACE static void wheel_insert(timeout_wheel_t *wheel, timeout_t *timeout)
+{
+	ASSERT(timeout->deadline >= wheel->now);
+	
+	uint64_t delta = timeout->deadline - wheel->now;
+	if (delta >= WHEEL_SPAN(WHEEL_LEVELS)) {
+		list_append(&timeout->link, &wheel->overflow);
+		return;
+	}
+	
+	unsigned int level = 0;
+	
+	while ((level < WHEEL_LEVELS - 1) && (delta >= WHEEL_SPAN(level + 1)))
+		level++;
+	
+	unsigned int slot =
+	    (timeout->deadline >> (WHEEL_BITS * level)) & WHEEL_MASK;
+	
+	list_append(&timeout->link, &wheel->slot[level][slot]);
+	wheel->map[level] |= UINT64_C(1) << slot;
+}
+
+/** Move the timeouts of the current slot to the lower levels
+ *
+ * The timeout wheel lock must be held.
+ *
+ * @param wheel Timeout wheel.
+ * @param level Level of the wheel.
+ *
+ */
+NO_TRACE static void wheel_cascade(timeout_wheel_t *wheel, unsigned int level)
+{
+	unsigned int idx = (wheel->now >> (WHEEL_BITS * level)) & WHEEL_MASK;
+	list_t list;
+	
+	list_initialize(&list);
+	list_concat(&list, &wheel->slot[level][idx]);
+	wheel->map[level] &= ~(UINT64_C(1) << idx);
+	
+	link_t *cur;
+	while ((cur = list_first(&list)) != NULL) {
+		list_remove(cur);
+		wheel_insert(wheel, list_get_instance(cur, timeout_t, link));
+	}
+}
+
 /** Register timeout
  *
  * Insert timeout handler f (with argument arg)
@@ -100,59 +179,35 @@ void timeout_initialize(timeout_t *timeout)
 void timeout_register(timeout_t *timeout, uint64_t time,
     timeout_handler_t handler, void *arg)
 {
-	irq_spinlock_lock(&CPU->timeoutlock, true);
+	timeout_wheel_t *wheel = &CPU->timeout_wheel;
+	
+	ipl_t ipl = interrupts_disable();
+	irq_spinlock_lock(&CPU->timeoutlock, false);
 	irq_spinlock_lock(&timeout->lock, false);
 	
 	if (timeout->cpu)
 		panic("Unexpected: timeout->cpu != 0.");
 	
+	/* Avoid the 64-bit division for the common short timeouts. */
+	uint64_t ticks = (time <= UINT32_MAX) ? us2ticks(time) :
+	    time / (1000000 / HZ);
+	
 	timeout->cpu = CPU;
-	timeout->ticks = us2ticks(time);
+	timeout->deadline = wheel->now + ticks;
 	
 	timeout->handler = handler;
 	timeout->arg = arg;
 	
-	/*
-	 * Insert timeout into the active timeouts list according to timeout->ticks.
-	 */
-	uint64_t sum = 0;
-	timeout_t *target = NULL;
-	link_t *cur;
-	for (cur = CPU->timeout_active_list.head.next;
-	    cur != &CPU->timeout_active_list.head; cur = cur->next) {
-		target = list_get_instance(cur, timeout_t, link);
-		irq_spinlock_lock(&target->lock, false);
-		
-		if (timeout->ticks < sum + target->ticks) {
-			irq_spinlock_unlock(&target->lock, false);
-			break;
-		}
-		
-		sum += target->ticks;
-		irq_spinlock_unlock(&target->lock, false);
-	}
-	
-	/* Avoid using cur->prev directly */
-	link_t *prev = cur->prev;
-	list_insert_after(&timeout->link, prev);
+	wheel_insert(wheel, timeout);
+	wheel->count++;
 	
-	/*
-	 * Adjust timeout->ticks according to ticks
-	 * accumulated in target's predecessors.
-	 */
-	timeout->ticks -= sum;
+	irq_spinlock_unlock(&timeout->lock, false);
+	irq_spinlock_unlock(&CPU->timeoutlock, false);
 	
-	/*
-	 * Decrease ticks of timeout's immediate succesor by timeout->ticks.
-	 */
-	if (cur != &CPU->timeout_active_list.head) {
-		irq_spinlock_lock(&target->lock, false);
-		target->ticks -= timeout->ticks;
-		irq_spinlock_unlock(&target->lock, false);
-	}
+	/* The timeout might expire before the next clock interrupt. */
+	clock_program();
 	
-	irq_spinlock_unlock(&timeout->lock, false);
-	irq_spinlock_unlock(&CPU->timeoutlock, true);
+	interrupts_restore(ipl);
 }
 
 /** Unregister timeout
@@ -183,18 +238,12 @@ grab_locks:
 	
 	/*
 	 * Now we know for sure that timeout hasn't been activated yet
-	 * and is lurking in timeout->cpu->timeout_active_list.
+	 * and is lurking in the timeout wheel of timeout->cpu or in the
+	 * list of timeouts being activated by timeout_tick().
 	 */
 	
-	link_t *cur = timeout->link.next;
-	if (cur != &timeout->cpu->timeout_active_list.head) {
-		timeout_t *tmp = list_get_instance(cur, timeout_t, link);
-		irq_spinlock_lock(&tmp->lock, false);
-		tmp->ticks += timeout->ticks;
-		irq_spinlock_unlock(&tmp->lock, false);
-	}
-	
 	list_remove(&timeout->link);
+	timeout->cpu->timeout_wheel.count--;
 	irq_spinlock_unlock(&timeout->cpu->timeoutlock, false);
 	
 	timeout_reinitialize(timeout);
@@ -203,5 +252,167 @@ grab_locks:
 	return true;
 }
 
+/** Find the first non-empty slot of a timeout wheel level
+ *
+ * The timeout wheel lock must be held.
+ *
+ * @param wheel Timeout wheel.
+ * @param level Level of the wheel.
+ * @param start Slot to start the search at.
+ * @param dist  Place to store the distance of the slot found
+ *              from the start slot.
+ *
+ * @return True if a non-empty slot was found.
+ *
+ */
+NO_TRACE static bool wheel_first(timeout_wheel_t *wheel, unsigned int level,
+    unsigned int start, unsigned int *dist)
+{
+	while (wheel->map[level] != 0) {
+		/* Rotate the bitmap so that the start slot is bit 0. */
+		uint64_t map = wheel->map[level];
+		if (start != 0)
+			map = (map >> start) | (map << (WHEEL_SLOTS - start));
+		
+		unsigned int i = fnzb64(map & (~map + 1));
+		unsigned int slot = (start + i) & WHEEL_MASK;
+		
+		if (!list_empty(&wheel->slot[level][slot])) {
+			*dist = i;
+			return true;
+		}
+		
+		/* The last timeout in the slot has been unregistered. */
+		wheel->map[level] &= ~(UINT64_C(1) << slot);
+	}
+	
+	return false;
+}
+
+/** Get the number of ticks until the first timeout expires
+ *
+ * The timeouts in the higher levels of the timeout wheel are
+ * accounted for by the tick in which they are moved to the lower
+ * levels, so the result might be shorter than the actual time.
+ *
+ * Interrupts must be disabled.
+ *
+ * @return Number of clock ticks, 1 being the next clock tick,
+ *         UINT64_MAX if there are no timeouts.
+ *
+ */
+uint64_t timeout_next(void)
+{
+	timeout_wheel_t *wheel = &CPU->timeout_wheel;
+	uint64_t next = UINT64_MAX;
+	
+	irq_spinlock_lock(&CPU->timeoutlock, false);
+	
+	unsigned int level;
+	for (level = 0; (wheel->count != 0) && (level < WHEEL_LEVELS);
+	    level++) {
+		unsigned int shift = WHEEL_BITS * level;
+		
+		/*
+		 * The current slot of a higher level has already been
+		 * moved down unless the next tick is the one moving it.
+		 * Its timeouts belong to the next turn of the level.
+		 */
+		unsigned int skip = ((level > 0) &&
+		    ((wheel->now & (WHEEL_SPAN(level) - 1)) != 0)) ? 1 : 0;
+		unsigned int start = ((wheel->now >> shift) + skip) & WHEEL_MASK;
+		
+		unsigned int dist;
+		if (!wheel_first(wheel, level, start, &dist))
+			continue;
+		
+		uint64_t tick = ((wheel->now >> shift) + skip + dist) << shift;
+		next = min(next, tick - wheel->now + 1);
+	}
+	
+	/* The overflow list is visited when the top level wraps around. */
+	if (!list_empty(&wheel->overflow)) {
+		uint64_t tick = ALIGN_UP(wheel->now, WHEEL_SPAN(WHEEL_LEVELS));
+		next = min(next, tick - wheel->now + 1);
+	}
+	
+	irq_spinlock_unlock(&CPU->timeoutlock, false);
+	
+	return next;
+}
+
+/** Process one tick of the timeout wheel
+ *
+ * Move the timeouts from the higher levels of the wheel when the
+ * lower levels wrap around and activate the timeouts expiring in
+ * the current tick.
+ *
+ * Interrupts must be disabled.
+ *
+ */
+void timeout_tick(void)
+{
+	timeout_wheel_t *wheel = &CPU->timeout_wheel;
+	list_t expired;
+	
+	list_initialize(&expired);
+	irq_spinlock_lock(&CPU->timeoutlock, false);
+	
+	unsigned int level;
+	for (level = 1; level < WHEEL_LEVELS; level++) {
+		unsigned int shift = WHEEL_BITS * (level - 1);
+		if (((wheel->now >> shift) & WHEEL_MASK) != 0)
+			break;
+		
+		wheel_cascade(wheel, level);
+	}
+	
+	/* The whole wheel has wrapped around, revisit the overflow list. */
+	if (level == WHEEL_LEVELS) {
+		list_t list;
+		list_initialize(&list);
+		list_concat(&list, &wheel->overflow);
+		
+		link_t *cur;
+		while ((cur = list_first(&list)) != NULL) {
+			list_remove(cur);
+			wheel_insert(wheel, list_get_instance(cur, timeout_t, link));
+		}
+	}
+	
+	unsigned int idx = wheel->now & WHEEL_MASK;
+	list_concat(&expired, &wheel->slot[0][idx]);
+	wheel->map[0] &= ~(UINT64_C(1) << idx);
+	wheel->now++;
+	
+	/*
+	 * To avoid lock ordering problems,
+	 * run all expired timeouts as you visit them.
+	 * Until then, they can still be unregistered.
+	 */
+	link_t *cur;
+	while ((cur = list_first(&expired)) != NULL) {
+		timeout_t *timeout = list_get_instance(cur, timeout_t, link);
+		
+		irq_spinlock_lock(&timeout->lock, false);
+		
+		list_remove(cur);
+		wheel->count--;
+		
+		timeout_handler_t handler = timeout->handler;
+		void *arg = timeout->arg;
+		timeout_reinitialize(timeout);
+		
+		irq_spinlock_unlock(&timeout->lock, false);
+		irq_spinlock_unlock(&CPU->timeoutlock, false);
+		
+		handler(arg);
+		
+		irq_spinlock_lock(&CPU->timeoutlock, false);
+	}
+	
+	irq_spinlock_unlock(&CPU->timeoutlock, false);
+}
+
 /** @}
  */
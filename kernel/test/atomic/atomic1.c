@@ -59,5 +59,41 @@ const char *test_atomic1(void)
 	if (atomic_get(&a) != 10)
 		return "Failed atomic_get() after atomic_predec()";
 	
+	if (atomic_cas(&a, 11, 12))
+		return "Failed atomic_cas() with unexpected value";
+	if (atomic_get(&a) != 10)
+		return "Failed atomic_get() after failed atomic_cas()";
+	
+	if (!atomic_cas(&a, 10, 12))
+		return "Failed atomic_cas() with expected value";
+	if (atomic_get(&a) != 12)
+		return "Failed atomic_get() after atomic_cas()";
+	
+	if (atomic_fetch_add(&a, 5) != 12)
+		return "Failed atomic_fetch_add()";
+	if (atomic_get(&a) != 17)
+		return "Failed atomic_get() after atomic_fetch_add()";
+	
+	if (atomic_fetch_add_release(&a, (atomic_count_t) -7) != 17)
+		return "Failed atomic_fetch_add_release() with wrapped value";
+	if (atomic_get_acquire(&a) != 10)
+		return "Failed atomic_get_acquire() after atomic_fetch_add_release()";
+	
+	if (atomic_exchange(&a, 20) != 10)
+		return "Failed atomic_exchange()";
+	if (atomic_exchange_acquire(&a, 30) != 20)
+		return "Failed atomic_exchange_acquire()";
+	if (atomic_get(&a) != 30)
+		return "Failed atomic_get() after atomic_exchange_acquire()";
+	
+	if (!atomic_cas_acquire(&a, 30, 31))
+		return "Failed atomic_cas_acquire() with expected value";
+	if (atomic_cas_release(&a, 30, 32))
+		return "Failed atomic_cas_release() with unexpected value";
+	
+	atomic_set_release(&a, 10);
+	if (atomic_get(&a) != 10)
+		return "Failed atomic_get() after atomic_set_release()";
+	
 	return NULL;
 }
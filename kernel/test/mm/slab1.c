@@ -30,6 +30,7 @@
 #include <mm/slab.h>
 #include <print.h>
 #include <proc/thread.h>
+#include <synch/semaphore.h>
 #include <arch.h>
 #include <memstr.h>
 
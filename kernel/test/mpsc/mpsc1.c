@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <test.h>
+#include <arch.h>
+#include <atomic.h>
+#include <print.h>
+#include <proc/thread.h>
+#include <proc/scheduler.h>
+#include <mm/slab.h>
+#include <arch/cycle.h>
+
+#include <synch/waitq.h>
+#include <adt/mpsc.h>
+
+#define PRODUCERS  4
+#define ROUNDS     20000
+
+typedef struct {
+	mpsc_link_t link;
+	unsigned int producer;
+	unsigned int seq;
+} item_t;
+
+static mpsc_queue_t queue;
+static item_t *items;
+
+static waitq_t can_start;
+static atomic_t producers_finished;
+
+static void producer(void *arg)
+{
+	unsigned int id = (unsigned int) (uintptr_t) arg;
+	
+	thread_detach(THREAD);
+	
+	waitq_sleep(&can_start);
+	
+	for (unsigned int i = 0; i < ROUNDS; i++) {
+		item_t *item = &items[id * ROUNDS + i];
+		
+		item->producer = id;
+		item->seq = i;
+		mpsc_push(&queue, &item->link);
+	}
+	
+	atomic_inc(&producers_finished);
+}
+
+const char *test_mpsc1(void)
+{
+	unsigned int next[PRODUCERS];
+	const char *retval = NULL;
+	
+	mpsc_initialize(&queue);
+	if (!mpsc_empty(&queue) || (mpsc_pop(&queue) != NULL))
+		return "New queue not empty";
+	
+	/* Single threaded sanity check. */
+	item_t single[2];
+	mpsc_push(&queue, &single[0].link);
+	mpsc_push(&queue, &single[1].link);
+	if ((mpsc_pop(&queue) != &single[0].link) ||
+	    (mpsc_pop(&queue) != &single[1].link))
+		return "Items removed out of order";
+	if (!mpsc_empty(&queue) || (mpsc_pop(&queue) != NULL))
+		return "Queue not empty after removing all items";
+	
+	items = (item_t *) malloc(sizeof(item_t) * PRODUCERS * ROUNDS, 0);
+	waitq_initialize(&can_start);
+	atomic_set(&producers_finished, 0);
+	
+	unsigned int producers = 0;
+	for (unsigned int i = 0; i < PRODUCERS; i++) {
+		next[i] = 0;
+		
+		thread_t *thrd = thread_create(producer, (void *) (uintptr_t) i,
+		    TASK, THREAD_FLAG_NONE, "mpsc_producer");
+		if (thrd) {
+			producers++;
+			thread_ready(thrd);
+		} else
+			TPRINTF("could not create thread %u\n", i);
+	}
+	
+	thread_sleep(1);
+	
+	uint64_t start = get_cycle();
+	waitq_wakeup(&can_start, WAKEUP_ALL);
+	
+	unsigned int received = 0;
+	unsigned int empty = 0;
+	
+	while (received < producers * ROUNDS) {
+		mpsc_link_t *link = mpsc_pop(&queue);
+		if (link == NULL) {
+			empty++;
+			scheduler();
+			continue;
+		}
+		
+		item_t *item = mpsc_get_instance(link, item_t, link);
+		if ((item->producer >= producers) ||
+		    (item->seq != next[item->producer])) {
+			retval = "Items of a producer removed out of order";
+			break;
+		}
+		
+		next[item->producer]++;
+		received++;
+	}
+	
+	uint64_t cycles = get_cycle() - start;
+	
+	while (atomic_get(&producers_finished) < producers)
+		thread_usleep(10000);
+	
+	if ((retval == NULL) && (mpsc_pop(&queue) != NULL))
+		retval = "Queue not empty after removing all items";
+	
+	TPRINTF("%u producers, %u items, %" PRIu64 " cycles, "
+	    "%u times empty\n", producers, received, cycles, empty);
+	if (received > 0)
+		TPRINTF("%" PRIu64 " cycles per item\n", cycles / received);
+	
+	free(items);
+	return retval;
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <test.h>
+#include <arch.h>
+#include <atomic.h>
+#include <print.h>
+#include <proc/thread.h>
+#include <proc/scheduler.h>
+#include <arch/cycle.h>
+
+#include <synch/waitq.h>
+#include <adt/spsc.h>
+
+#define SLOTS   64
+#define ROUNDS  100000
+
+static spsc_ring_t ring;
+
+static waitq_t can_start;
+static atomic_t producer_finished;
+static unsigned int full;
+
+static void producer(void *arg)
+{
+	thread_detach(THREAD);
+	
+	waitq_sleep(&can_start);
+	
+	for (uintptr_t i = 1; i <= ROUNDS; i++) {
+		while (!spsc_push(&ring, (void *) i)) {
+			full++;
+			scheduler();
+		}
+	}
+	
+	atomic_set(&producer_finished, 1);
+}
+
+const char *test_spsc1(void)
+{
+	const char *retval = NULL;
+	void *item;
+	
+	if (!spsc_create(&ring, SLOTS, 0))
+		return "Cannot create ring";
+	
+	/* Single threaded sanity check. */
+	if (!spsc_empty(&ring) || spsc_pop(&ring, &item)) {
+		spsc_destroy(&ring);
+		return "New ring not empty";
+	}
+	
+	for (uintptr_t i = 0; i < SLOTS; i++) {
+		if (!spsc_push(&ring, (void *) i)) {
+			spsc_destroy(&ring);
+			return "Ring full too early";
+		}
+	}
+	
+	if (spsc_push(&ring, NULL)) {
+		spsc_destroy(&ring);
+		return "Ring overflow";
+	}
+	
+	for (uintptr_t i = 0; i < SLOTS; i++) {
+		if ((!spsc_pop(&ring, &item)) || (item != (void *) i)) {
+			spsc_destroy(&ring);
+			return "Items removed out of order";
+		}
+	}
+	
+	if (!spsc_empty(&ring)) {
+		spsc_destroy(&ring);
+		return "Ring not empty after removing all items";
+	}
+	
+	waitq_initialize(&can_start);
+	atomic_set(&producer_finished, 0);
+	full = 0;
+	
+	thread_t *thrd = thread_create(producer, NULL, TASK, THREAD_FLAG_NONE,
+	    "spsc_producer");
+	if (!thrd) {
+		spsc_destroy(&ring);
+		return "Cannot create producer thread";
+	}
+	
+	thread_ready(thrd);
+	thread_sleep(1);
+	
+	uint64_t start = get_cycle();
+	waitq_wakeup(&can_start, WAKEUP_ALL);
+	
+	unsigned int empty = 0;
+	
+	for (uintptr_t i = 1; i <= ROUNDS; i++) {
+		while (!spsc_pop(&ring, &item)) {
+			empty++;
+			scheduler();
+		}
+		
+		if (item != (void *) i) {
+			retval = "Items removed out of order";
+			break;
+		}
+	}
+	
+	uint64_t cycles = get_cycle() - start;
+	
+	while (atomic_get(&producer_finished) == 0)
+		thread_usleep(10000);
+	
+	TPRINTF("%u slots, %u items, %" PRIu64 " cycles, "
+	    "%u times full, %u times empty\n", SLOTS, ROUNDS, cycles, full,
+	    empty);
+	TPRINTF("%" PRIu64 " cycles per item\n", cycles / ROUNDS);
+	
+	spsc_destroy(&ring);
+	return retval;
+}
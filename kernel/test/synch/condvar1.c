@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <test.h>
+#include <arch.h>
+#include <atomic.h>
+#include <print.h>
+#include <proc/thread.h>
+#include <synch/mutex.h>
+#include <synch/condvar.h>
+
+#define WAITERS  8
+
+/** Time for which the mutex is held after the broadcast (microseconds). */
+#define HOLD_DELAY  10000
+
+/** Longest time for all waiters to acquire the mutex (microseconds). */
+#define FINISH_DELAY  2000000
+
+static mutex_t mtx;
+static condvar_t cv;
+
+/* Protected by mtx. */
+static bool go;
+static size_t waiting;
+static size_t inside;
+static size_t overlapped;
+static size_t acquired[WAITERS];
+
+static atomic_t done;
+
+static void waiter(void *arg)
+{
+	size_t *count = (size_t *) arg;
+	
+	thread_detach(THREAD);
+	
+	mutex_lock(&mtx);
+	
+	waiting++;
+	while (!go)
+		condvar_wait(&cv, &mtx);
+	
+	if (inside++ != 0)
+		overlapped++;
+	
+	(*count)++;
+	thread_usleep(1000);
+	
+	inside--;
+	mutex_unlock(&mtx);
+	
+	atomic_inc(&done);
+}
+
+/** Broadcast to waiters of a condition variable.
+ *
+ * @param held Broadcast while holding the mutex, so that the waiters are
+ *             moved to the mutex rather than woken up one by one.
+ *
+ * @return Error message or NULL.
+ *
+ */
+static const char *broadcast(bool held)
+{
+	size_t i;
+	
+	go = false;
+	waiting = 0;
+	inside = 0;
+	overlapped = 0;
+	atomic_set(&done, 0);
+	
+	for (i = 0; i < WAITERS; i++) {
+		acquired[i] = 0;
+		
+		thread_t *thread = thread_create(waiter, &acquired[i], TASK,
+		    THREAD_FLAG_NONE, "condvar1");
+		if (!thread)
+			return "Could not create thread";
+		
+		thread_ready(thread);
+	}
+	
+	/*
+	 * A waiter releases the mutex only in condvar_wait(),
+	 * so all of them sleep once they have been counted.
+	 */
+	while (true) {
+		mutex_lock(&mtx);
+		if (waiting == WAITERS)
+			break;
+		
+		mutex_unlock(&mtx);
+		thread_usleep(10000);
+	}
+	
+	go = true;
+	
+	if (held) {
+		condvar_broadcast(&cv);
+		thread_usleep(HOLD_DELAY);
+		
+		if (atomic_get(&done) != 0) {
+			mutex_unlock(&mtx);
+			return "Waiter ran while the mutex was held";
+		}
+		
+		mutex_unlock(&mtx);
+	} else {
+		mutex_unlock(&mtx);
+		condvar_broadcast(&cv);
+	}
+	
+	size_t wait;
+	for (wait = 0; wait < FINISH_DELAY / 10000; wait++) {
+		if (atomic_get(&done) == WAITERS)
+			break;
+		
+		thread_usleep(10000);
+	}
+	
+	if (atomic_get(&done) != WAITERS)
+		return "Broadcast wakeup lost";
+	
+	/* Give duplicate wakeups a chance to show up. */
+	thread_usleep(10000);
+	
+	if (overlapped != 0)
+		return "Mutex acquired by two waiters at once";
+	
+	for (i = 0; i < WAITERS; i++) {
+		if (acquired[i] != 1)
+			return "Waiter did not acquire the mutex exactly once";
+	}
+	
+	if (mutex_locked(&mtx))
+		return "Mutex left locked";
+	
+	return NULL;
+}
+
+const char *test_condvar1(void)
+{
+	mutex_initialize(&mtx, MUTEX_PASSIVE);
+	condvar_initialize(&cv);
+	
+	TPRINTF("Broadcast with the mutex held\n");
+	const char *err = broadcast(true);
+	if (err)
+		return err;
+	
+	TPRINTF("Broadcast after the mutex is released\n");
+	return broadcast(false);
+}
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <test.h>
+#include <arch.h>
+#include <atomic.h>
+#include <print.h>
+#include <errno.h>
+#include <proc/thread.h>
+#include <synch/futex.h>
+#include <abi/synch.h>
+
+#define WAITERS  4
+
+/** Time for the waiters to fall asleep (microseconds). */
+#define QUEUE_DELAY  100000
+
+typedef struct {
+	atomic_t *word;
+	int rc;
+} waiter_t;
+
+static waiter_t waiters[WAITERS];
+static atomic_t waiting;
+static atomic_t done;
+
+static atomic_t word1;
+static atomic_t word2;
+
+static void waiter_thread(void *arg)
+{
+	waiter_t *waiter = (waiter_t *) arg;
+	
+	thread_detach(THREAD);
+	
+	atomic_inc(&waiting);
+	waiter->rc = futex_wait((uintptr_t) waiter->word, 0, 0);
+	atomic_inc(&done);
+}
+
+/** Start waiters for futex words whose value is zero.
+ *
+ * @param count Number of waiters, the first half waits for word1,
+ *              the other half for word2 unless single is true.
+ * @param single Let all waiters wait for word1.
+ *
+ * @return Number of waiters started.
+ *
+ */
+static size_t waiters_start(size_t count, bool single)
+{
+	atomic_set(&word1, 0);
+	atomic_set(&word2, 0);
+	atomic_set(&waiting, 0);
+	atomic_set(&done, 0);
+	
+	size_t i;
+	for (i = 0; i < count; i++) {
+		waiters[i].word = ((single) || (i < count / 2)) ? &word1 : &word2;
+		waiters[i].rc = EOK;
+		
+		thread_t *thread = thread_create(waiter_thread, &waiters[i], TASK,
+		    THREAD_FLAG_NONE, "futex1");
+		if (!thread)
+			break;
+		
+		thread_ready(thread);
+	}
+	
+	while ((size_t) atomic_get(&waiting) < i)
+		thread_usleep(10000);
+	
+	thread_usleep(QUEUE_DELAY);
+	
+	return i;
+}
+
+/** Wait until the waiters are woken up, waking up any remaining ones.
+ *
+ * @param count Number of waiters started.
+ * @param woken Number of waiters expected to have been woken up
+ *              before the call.
+ *
+ * @return NULL on success, error message otherwise.
+ *
+ */
+static const char *waiters_finish(size_t count, size_t woken)
+{
+	const char *ret = NULL;
+	
+	thread_usleep(QUEUE_DELAY);
+	if ((size_t) atomic_get(&done) != woken)
+		ret = "Unexpected number of waiters left";
+	
+	while ((size_t) atomic_get(&done) < count) {
+		(void) futex_wake((uintptr_t) &word1, count);
+		(void) futex_wake((uintptr_t) &word2, count);
+		thread_usleep(10000);
+	}
+	
+	for (size_t i = 0; i < count; i++) {
+		if ((waiters[i].rc != EOK) && (ret == NULL))
+			ret = "Waiter failed";
+	}
+	
+	return ret;
+}
+
+static const char *test_wake(void)
+{
+	size_t count = waiters_start(WAITERS, true);
+	if (count != WAITERS) {
+		(void) waiters_finish(count, 0);
+		return "Could not create waiters";
+	}
+	
+	const char *ret = NULL;
+	
+	int rc = futex_wake((uintptr_t) &word1, 1);
+	if (rc != 1)
+		ret = "Wake of one waiter woke up a different number";
+	
+	rc = futex_wake((uintptr_t) &word2, WAITERS);
+	if ((rc != 0) && (ret == NULL))
+		ret = "Wake of another futex woke up waiters";
+	
+	rc = futex_wake((uintptr_t) &word1, WAITERS);
+	if ((rc != WAITERS - 1) && (ret == NULL))
+		ret = "Wake of all waiters woke up a different number";
+	
+	const char *ret2 = waiters_finish(count, WAITERS);
+	return (ret != NULL) ? ret : ret2;
+}
+
+static const char *test_requeue(void)
+{
+	size_t count = waiters_start(WAITERS, true);
+	if (count != WAITERS) {
+		(void) waiters_finish(count, 0);
+		return "Could not create waiters";
+	}
+	
+	const char *ret = NULL;
+	
+	int rc = futex_requeue((uintptr_t) &word1, 1, 1, (uintptr_t) &word2,
+	    WAITERS);
+	if (rc != EAGAIN)
+		ret = "Requeue with unexpected value did not fail";
+	
+	rc = futex_requeue((uintptr_t) &word1, 0, 1, (uintptr_t) &word2,
+	    WAITERS);
+	if ((rc != WAITERS) && (ret == NULL))
+		ret = "Requeue woke up and moved a different number of waiters";
+	
+	rc = futex_wake((uintptr_t) &word1, WAITERS);
+	if ((rc != 0) && (ret == NULL))
+		ret = "Requeued waiters left behind";
+	
+	rc = futex_wake((uintptr_t) &word2, WAITERS);
+	if ((rc != WAITERS - 1) && (ret == NULL))
+		ret = "Requeued waiters lost";
+	
+	const char *ret2 = waiters_finish(count, WAITERS);
+	return (ret != NULL) ? ret : ret2;
+}
+
+static const char *test_wake_op(void)
+{
+	size_t count = waiters_start(WAITERS, false);
+	if (count != WAITERS) {
+		(void) waiters_finish(count, 0);
+		return "Could not create waiters";
+	}
+	
+	const char *ret = NULL;
+	
+	int rc = futex_wake_op((uintptr_t) &word1, 1, (uintptr_t) &word2,
+	    WAITERS, FUTEX_OP(FUTEX_OP_XOR + 1, 0, FUTEX_OP_CMP_EQ, 0));
+	if (rc != EINVAL)
+		ret = "Invalid operation accepted";
+	
+	/* The former value 0 does not satisfy the comparison. */
+	rc = futex_wake_op((uintptr_t) &word1, 1, (uintptr_t) &word2,
+	    WAITERS, FUTEX_OP(FUTEX_OP_ADD, 1, FUTEX_OP_CMP_NE, 0));
+	if ((rc != 1) && (ret == NULL))
+		ret = "Wake-op woke up waiters of the second futex";
+	
+	if ((atomic_get(&word2) != 1) && (ret == NULL))
+		ret = "Wake-op did not add to the second futex";
+	
+	/* The former value 1 satisfies the comparison. */
+	rc = futex_wake_op((uintptr_t) &word1, 1, (uintptr_t) &word2,
+	    WAITERS, FUTEX_OP(FUTEX_OP_SET, 5, FUTEX_OP_CMP_EQ, 1));
+	if ((rc != WAITERS / 2 + 1) && (ret == NULL))
+		ret = "Wake-op woke up a different number of waiters";
+	
+	if ((atomic_get(&word2) != 5) && (ret == NULL))
+		ret = "Wake-op did not set the second futex";
+	
+	const char *ret2 = waiters_finish(count, WAITERS / 2 + 2);
+	return (ret != NULL) ? ret : ret2;
+}
+
+const char *test_futex1(void)
+{
+	atomic_set(&word1, 0);
+	
+	int rc = futex_wait((uintptr_t) &word1, 1, 0);
+	if (rc != EAGAIN)
+		return "Wait with unexpected value did not fail";
+	
+	rc = futex_wait((uintptr_t) &word1, 0, 10000);
+	if (rc != ETIMEOUT)
+		return "Wait did not time out";
+	
+	TPRINTF("Testing wake...\n");
+	const char *ret = test_wake();
+	if (ret != NULL)
+		return ret;
+	
+	TPRINTF("Testing requeue...\n");
+	ret = test_requeue();
+	if (ret != NULL)
+		return ret;
+	
+	TPRINTF("Testing wake-op...\n");
+	return test_wake_op();
+}
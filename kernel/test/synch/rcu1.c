@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <test.h>
+#include <arch.h>
+#include <atomic.h>
+#include <print.h>
+#include <proc/thread.h>
+#include <mm/slab.h>
+
+#include <synch/rcu.h>
+
+#define READERS  8
+#define UPDATES  200
+#define LOOKUPS  100
+
+#define DATA_MAGIC  0x52435531
+
+typedef struct {
+	rcu_item_t rcu;
+	uint32_t magic;
+} data_t;
+
+static data_t *volatile shared;
+
+static atomic_t finish;
+static atomic_t readers_finished;
+static atomic_t reclaimed;
+static atomic_t failures;
+
+static void reclaim(rcu_item_t *item)
+{
+	data_t *data = (data_t *) item;
+	
+	/* Poison the object so that late readers notice. */
+	data->magic = 0;
+	free(data);
+	
+	atomic_inc(&reclaimed);
+}
+
+static void reader(void *arg)
+{
+	thread_detach(THREAD);
+	
+	while (!atomic_get(&finish)) {
+		for (unsigned int i = 0; i < LOOKUPS; i++) {
+			rcu_read_lock();
+			
+			data_t *data = shared;
+			if (data->magic != DATA_MAGIC)
+				atomic_inc(&failures);
+			
+			rcu_read_unlock();
+		}
+		
+		thread_usleep(10);
+	}
+	
+	atomic_inc(&readers_finished);
+}
+
+static data_t *data_create(void)
+{
+	data_t *data = (data_t *) malloc(sizeof(data_t), 0);
+	data->magic = DATA_MAGIC;
+	
+	return data;
+}
+
+const char *test_rcu1(void)
+{
+	atomic_count_t readers = 0;
+	
+	atomic_set(&finish, 0);
+	atomic_set(&readers_finished, 0);
+	atomic_set(&reclaimed, 0);
+	atomic_set(&failures, 0);
+	
+	shared = data_create();
+	
+	for (unsigned int i = 0; i < READERS; i++) {
+		thread_t *thrd = thread_create(reader, NULL, TASK,
+		    THREAD_FLAG_NONE, "rcu_reader");
+		if (thrd) {
+			readers++;
+			thread_ready(thrd);
+		} else
+			TPRINTF("could not create reader %u\n", i);
+	}
+	
+	TPRINTF("Replacing the shared object %u times...", UPDATES);
+	
+	for (unsigned int i = 0; i < UPDATES; i++) {
+		data_t *old = shared;
+		rcu_assign_pointer(shared, data_create());
+		
+		/* Exercise both the asynchronous and the blocking way. */
+		if (i & 1)
+			rcu_call(&old->rcu, reclaim);
+		else {
+			rcu_synchronize();
+			reclaim(&old->rcu);
+		}
+		
+		thread_usleep(100);
+	}
+	
+	TPRINTF("ok\n");
+	
+	atomic_set(&finish, 1);
+	while (atomic_get(&readers_finished) < readers)
+		thread_usleep(10000);
+	
+	rcu_call(&shared->rcu, reclaim);
+	
+	while (atomic_get(&reclaimed) < UPDATES + 1) {
+		TPRINTF("%" PRIua " objects not reclaimed yet\n",
+		    UPDATES + 1 - atomic_get(&reclaimed));
+		thread_sleep(1);
+	}
+	
+	if (atomic_get(&failures) != 0)
+		return "Reader saw a reclaimed object";
+	
+	return NULL;
+}
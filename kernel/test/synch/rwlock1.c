@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <test.h>
+#include <arch.h>
+#include <atomic.h>
+#include <print.h>
+#include <proc/thread.h>
+#include <arch/cycle.h>
+
+#include <synch/waitq.h>
+#include <synch/spinlock.h>
+#include <synch/rwlock.h>
+
+#define READERS  12
+#define WRITERS  2
+#define ROUNDS   20000
+#define ENTRIES  32
+
+/* Writers update the table once per this many reader rounds. */
+#define WRITE_RATIO  64
+
+typedef enum {
+	LOCK_SPINLOCK,
+	LOCK_IRQ_RWLOCK,
+	LOCK_RWLOCK
+} lock_kind_t;
+
+static const char *lock_names[] = {
+	"irq_spinlock_t",
+	"irq_rwlock_t",
+	"rwlock_t"
+};
+
+static lock_kind_t kind;
+
+static IRQ_SPINLOCK_DECLARE(spin);
+static irq_rwlock_t irq_rwl;
+static rwlock_t rwl;
+
+/** Read-mostly table, all entries are equal outside writers. */
+static uint32_t table[ENTRIES];
+
+static waitq_t can_start;
+static atomic_count_t threads;
+static atomic_t threads_finished;
+static atomic_t failures;
+static uint64_t finish;
+
+static void lock_read(void)
+{
+	switch (kind) {
+	case LOCK_SPINLOCK:
+		irq_spinlock_lock(&spin, true);
+		break;
+	case LOCK_IRQ_RWLOCK:
+		irq_rwlock_read_lock(&irq_rwl, true);
+		break;
+	case LOCK_RWLOCK:
+		rwlock_read_lock(&rwl);
+		break;
+	}
+}
+
+static void unlock_read(void)
+{
+	switch (kind) {
+	case LOCK_SPINLOCK:
+		irq_spinlock_unlock(&spin, true);
+		break;
+	case LOCK_IRQ_RWLOCK:
+		irq_rwlock_read_unlock(&irq_rwl, true);
+		break;
+	case LOCK_RWLOCK:
+		rwlock_read_unlock(&rwl);
+		break;
+	}
+}
+
+static void lock_write(void)
+{
+	switch (kind) {
+	case LOCK_SPINLOCK:
+		irq_spinlock_lock(&spin, true);
+		break;
+	case LOCK_IRQ_RWLOCK:
+		irq_rwlock_write_lock(&irq_rwl, true);
+		break;
+	case LOCK_RWLOCK:
+		rwlock_write_lock(&rwl);
+		break;
+	}
+}
+
+static void unlock_write(void)
+{
+	switch (kind) {
+	case LOCK_SPINLOCK:
+		irq_spinlock_unlock(&spin, true);
+		break;
+	case LOCK_IRQ_RWLOCK:
+		irq_rwlock_write_unlock(&irq_rwl, true);
+		break;
+	case LOCK_RWLOCK:
+		rwlock_write_unlock(&rwl);
+		break;
+	}
+}
+
+static void done(void)
+{
+	if (atomic_preinc(&threads_finished) == threads)
+		finish = get_cycle();
+}
+
+static void reader(void *arg)
+{
+	thread_detach(THREAD);
+	
+	waitq_sleep(&can_start);
+	
+	for (unsigned int i = 0; i < ROUNDS; i++) {
+		lock_read();
+		
+		for (unsigned int j = 1; j < ENTRIES; j++) {
+			if (table[j] != table[0]) {
+				atomic_inc(&failures);
+				break;
+			}
+		}
+		
+		unlock_read();
+	}
+	
+	done();
+}
+
+static void writer(void *arg)
+{
+	thread_detach(THREAD);
+	
+	waitq_sleep(&can_start);
+	
+	for (unsigned int i = 0; i < ROUNDS / WRITE_RATIO; i++) {
+		lock_write();
+		
+		for (unsigned int j = 0; j < ENTRIES; j++)
+			table[j]++;
+		
+		unlock_write();
+		thread_usleep(10);
+	}
+	
+	done();
+}
+
+static bool run(lock_kind_t k)
+{
+	kind = k;
+	threads = 0;
+	atomic_set(&threads_finished, 0);
+	
+	for (unsigned int i = 0; i < READERS + WRITERS; i++) {
+		bool is_reader = (i < READERS);
+		thread_t *thrd = thread_create(is_reader ? reader : writer,
+		    NULL, TASK, THREAD_FLAG_NONE,
+		    is_reader ? "rwlock_reader" : "rwlock_writer");
+		if (thrd) {
+			threads++;
+			thread_ready(thrd);
+		} else
+			TPRINTF("could not create thread %u\n", i);
+	}
+	
+	thread_sleep(1);
+	
+	uint64_t start = get_cycle();
+	waitq_wakeup(&can_start, WAKEUP_ALL);
+	
+	while (atomic_get(&threads_finished) < threads)
+		thread_usleep(10000);
+	
+	TPRINTF("%-16s %" PRIu64 " cycles\n", lock_names[k], finish - start);
+	
+	return (atomic_get(&failures) == 0);
+}
+
+const char *test_rwlock1(void)
+{
+	waitq_initialize(&can_start);
+	irq_spinlock_initialize(&spin, "rwlock1_spin");
+	irq_rwlock_initialize(&irq_rwl, "rwlock1_irq_rwl");
+	rwlock_initialize(&rwl, MUTEX_PASSIVE);
+	atomic_set(&failures, 0);
+	
+	TPRINTF("%u readers, %u writers, %u rounds\n", READERS, WRITERS,
+	    ROUNDS);
+	
+	if (!run(LOCK_SPINLOCK))
+		return "Reader saw a partially updated table (irq_spinlock_t)";
+	
+	if (!run(LOCK_IRQ_RWLOCK))
+		return "Reader saw a partially updated table (irq_rwlock_t)";
+	
+	if (!run(LOCK_RWLOCK))
+		return "Reader saw a partially updated table (rwlock_t)";
+	
+	return NULL;
+}
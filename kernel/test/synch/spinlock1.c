@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <test.h>
+#include <arch.h>
+#include <atomic.h>
+#include <print.h>
+#include <proc/thread.h>
+#include <arch/cycle.h>
+
+#include <synch/waitq.h>
+#include <synch/spinlock.h>
+
+#define THREADS  16
+#define ROUNDS   50000
+
+#if defined(CONFIG_SPINLOCK_ticket)
+	#define SPINLOCK_NAME  "ticket"
+#elif defined(CONFIG_SPINLOCK_mcs)
+	#define SPINLOCK_NAME  "mcs"
+#elif defined(CONFIG_SMP)
+	#define SPINLOCK_NAME  "test-and-set"
+#else
+	#define SPINLOCK_NAME  "none (UP)"
+#endif
+
+static IRQ_SPINLOCK_DECLARE(lock);
+
+/** Protected by lock */
+static uint32_t counter;
+static uint64_t max_wait;
+
+static waitq_t can_start;
+static atomic_count_t threads;
+static atomic_t threads_finished;
+static uint64_t finish;
+
+static void contender(void *arg)
+{
+	thread_detach(THREAD);
+	
+	waitq_sleep(&can_start);
+	
+	for (unsigned int i = 0; i < ROUNDS; i++) {
+		uint64_t t0 = get_cycle();
+		irq_spinlock_lock(&lock, true);
+		uint64_t wait = get_cycle() - t0;
+		
+		counter++;
+		if (wait > max_wait)
+			max_wait = wait;
+		
+		irq_spinlock_unlock(&lock, true);
+	}
+	
+	if (atomic_preinc(&threads_finished) == threads)
+		finish = get_cycle();
+}
+
+const char *test_spinlock1(void)
+{
+	waitq_initialize(&can_start);
+	irq_spinlock_initialize(&lock, "spinlock1_lock");
+	counter = 0;
+	max_wait = 0;
+	threads = 0;
+	atomic_set(&threads_finished, 0);
+	
+	for (unsigned int i = 0; i < THREADS; i++) {
+		thread_t *thrd = thread_create(contender, NULL, TASK,
+		    THREAD_FLAG_NONE, "spinlock_contender");
+		if (thrd) {
+			threads++;
+			thread_ready(thrd);
+		} else
+			TPRINTF("could not create thread %u\n", i);
+	}
+	
+	thread_sleep(1);
+	
+	uint64_t start = get_cycle();
+	waitq_wakeup(&can_start, WAKEUP_ALL);
+	
+	while (atomic_get(&threads_finished) < threads)
+		thread_usleep(10000);
+	
+	TPRINTF("%s spinlock, %" PRIu64 " threads, %u rounds\n", SPINLOCK_NAME,
+	    (uint64_t) threads, ROUNDS);
+	TPRINTF("total %" PRIu64 " cycles, longest wait %" PRIu64 " cycles\n",
+	    finish - start, max_wait);
+	
+	if (counter != threads * ROUNDS)
+		return "Lost update under the spinlock";
+	
+	return NULL;
+}
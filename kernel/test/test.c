@@ -47,14 +47,24 @@ test_t tests[] = {
 #include <mm/mapping1.def>
 #include <mm/slab1.def>
 #include <mm/slab2.def>
+#include <mpsc/mpsc1.def>
+#include <spsc/spsc1.def>
 #include <synch/semaphore1.def>
 #include <synch/semaphore2.def>
+#include <synch/rwlock1.def>
+#include <synch/rcu1.def>
+#include <synch/spinlock1.def>
+#include <synch/futex1.def>
+#include <synch/condvar1.def>
 #include <print/print1.def>
 #include <print/print2.def>
 #include <print/print3.def>
 #include <print/print4.def>
 #include <print/print5.def>
 #include <thread/thread1.def>
+#include <thread/fair1.def>
+#include <thread/affinity1.def>
+#include <time/timeout1.def>
 	{
 		.name = NULL,
 		.desc = NULL,
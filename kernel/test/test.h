@@ -66,14 +66,24 @@ extern const char *test_mapping1(void);
 extern const char *test_purge1(void);
 extern const char *test_slab1(void);
 extern const char *test_slab2(void);
+extern const char *test_mpsc1(void);
+extern const char *test_spsc1(void);
 extern const char *test_semaphore1(void);
 extern const char *test_semaphore2(void);
+extern const char *test_rwlock1(void);
+extern const char *test_rcu1(void);
+extern const char *test_spinlock1(void);
+extern const char *test_futex1(void);
+extern const char *test_condvar1(void);
 extern const char *test_print1(void);
 extern const char *test_print2(void);
 extern const char *test_print3(void);
 extern const char *test_print4(void);
 extern const char *test_print5(void);
 extern const char *test_thread1(void);
+extern const char *test_fair1(void);
+extern const char *test_affinity1(void);
+extern const char *test_timeout1(void);
 
 extern test_t tests[];
 
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <print.h>
+#include <debug.h>
+
+#include <test.h>
+#include <atomic.h>
+#include <errno.h>
+#include <config.h>
+#include <cpu.h>
+#include <cpu_mask.h>
+#include <proc/thread.h>
+
+#include <arch.h>
+
+#define WORKERS  8
+
+/** Number of sleeps of each worker in each phase. */
+#define ROUNDS  200
+
+/*
+ * Phase 0 runs the workers on the first half of the CPUs, phase 2 on
+ * the second one. Phase 1 is the change of the affinity, in which
+ * either is allowed.
+ */
+static atomic_t phase;
+static cpu_mask_t masks[2];
+
+static atomic_t violations;
+static atomic_t rounds;
+static atomic_t threads_finished;
+
+static void worker(void *data)
+{
+	thread_detach(THREAD);
+	
+	while (atomic_get(&phase) < 3) {
+		atomic_count_t before = atomic_get(&phase);
+		
+		/* Becoming ready again, the thread is placed anew. */
+		thread_usleep(1000);
+		
+		atomic_count_t after = atomic_get(&phase);
+		if ((before == after) && (before != 1) &&
+		    (!cpu_mask_is_set(&masks[before / 2], CPU->id)))
+			atomic_inc(&violations);
+		
+		atomic_inc(&rounds);
+	}
+	
+	atomic_inc(&threads_finished);
+}
+
+/** Wait until each worker has slept ROUNDS times in the current phase.
+ *
+ * @param count Number of workers.
+ *
+ */
+static void wait_rounds(atomic_count_t count)
+{
+	atomic_set(&rounds, 0);
+	while (atomic_get(&rounds) < count * ROUNDS)
+		thread_usleep(10000);
+}
+
+const char *test_affinity1(void)
+{
+	if (config.cpu_active < 2) {
+		TPRINTF("Test skipped, at least two CPUs are needed\n");
+		return NULL;
+	}
+	
+	/* Split the active CPUs into two halves. */
+	unsigned int i;
+	unsigned int active = 0;
+	cpu_mask_none(&masks[0]);
+	cpu_mask_none(&masks[1]);
+	for (i = 0; i < config.cpu_count; i++) {
+		if (cpus[i].active)
+			cpu_mask_set(&masks[active++ % 2], cpus[i].id);
+	}
+	
+	atomic_set(&phase, 0);
+	atomic_set(&violations, 0);
+	atomic_set(&rounds, 0);
+	atomic_set(&threads_finished, 0);
+	
+	thread_t *threads[WORKERS];
+	atomic_count_t total = 0;
+	const char *ret = NULL;
+	
+	for (i = 0; i < WORKERS; i++) {
+		threads[i] = thread_create(worker, NULL, TASK,
+		    THREAD_FLAG_NONE, "affinity1");
+		if (!threads[i]) {
+			ret = "Could not create thread";
+			break;
+		}
+		
+		/* An affinity without an existing CPU is refused. */
+		cpu_mask_t none;
+		cpu_mask_none(&none);
+		if (thread_set_affinity(threads[i], &none) != EINVAL) {
+			ret = "Empty affinity accepted";
+			thread_set_affinity(threads[i], &masks[0]);
+		} else if (thread_set_affinity(threads[i], &masks[0]) != EOK)
+			ret = "Affinity refused";
+		
+		/* The thread runs even if the affinity was not set. */
+		thread_ready(threads[i]);
+		total++;
+	}
+	
+	if (ret == NULL) {
+		TPRINTF("Running %u threads on the first half of the CPUs\n",
+		    WORKERS);
+		wait_rounds(total);
+		
+		TPRINTF("Moving the threads to the second half\n");
+		atomic_set(&phase, 1);
+		for (i = 0; i < WORKERS; i++)
+			thread_set_affinity(threads[i], &masks[1]);
+		atomic_set(&phase, 2);
+		
+		wait_rounds(total);
+	}
+	
+	atomic_set(&phase, 3);
+	while (atomic_get(&threads_finished) < total) {
+		TPRINTF("Threads left: %" PRIua "\n",
+		    total - atomic_get(&threads_finished));
+		thread_sleep(1);
+	}
+	
+	if ((ret == NULL) && (atomic_get(&violations) != 0)) {
+		TPRINTF("%" PRIua " wakeups outside of the affinity\n",
+		    atomic_get(&violations));
+		ret = "Thread ran on a CPU outside of its affinity";
+	}
+	
+	return ret;
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <print.h>
+#include <debug.h>
+
+#include <test.h>
+#include <atomic.h>
+#include <proc/thread.h>
+#include <proc/scheduler.h>
+
+#include <arch.h>
+
+/** Seconds for the classic thread to sink into the lower half of rq. */
+#define WARMUP  2
+
+/** Seconds in which both threads have to make progress. */
+#define PERIOD  3
+
+static atomic_t finish;
+static atomic_t threads_finished;
+
+static atomic_t fair_count;
+static atomic_t classic_count;
+
+static void spin(void *data)
+{
+	atomic_t *count = (atomic_t *) data;
+	
+	thread_detach(THREAD);
+	
+	while (atomic_get(&finish))
+		atomic_inc(count);
+	
+	atomic_inc(&threads_finished);
+}
+
+const char *test_fair1(void)
+{
+	const char *ret = NULL;
+	atomic_count_t total = 0;
+	cpu_t *cpu = CPU;
+	
+	atomic_set(&finish, 1);
+	atomic_set(&threads_finished, 0);
+	atomic_set(&fair_count, 0);
+	atomic_set(&classic_count, 0);
+	
+	thread_t *fair = thread_create(spin, &fair_count, TASK,
+	    THREAD_FLAG_FAIR, "fair1-fair");
+	if (fair) {
+		thread_wire(fair, cpu);
+		thread_ready(fair);
+		total++;
+	} else
+		ret = "Could not create fair thread";
+	
+	thread_t *classic = thread_create(spin, &classic_count, TASK,
+	    THREAD_FLAG_NONE, "fair1-classic");
+	if (classic) {
+		thread_wire(classic, cpu);
+		thread_ready(classic);
+		total++;
+	} else
+		ret = "Could not create classic thread";
+	
+	if (ret == NULL) {
+		TPRINTF("Running threads on cpu%u for %d seconds...\n",
+		    cpu->id, WARMUP + PERIOD);
+		thread_sleep(WARMUP);
+		
+		atomic_count_t fair_start = atomic_get(&fair_count);
+		atomic_count_t classic_start = atomic_get(&classic_count);
+		
+		thread_sleep(PERIOD);
+		
+		atomic_count_t fair_end = atomic_get(&fair_count);
+		atomic_count_t classic_end = atomic_get(&classic_count);
+		
+		TPRINTF("fair: %" PRIua ", classic: %" PRIua "\n",
+		    fair_end - fair_start, classic_end - classic_start);
+		
+		if (fair_end == fair_start)
+			ret = "Fair thread did not make progress";
+		else if (classic_end == classic_start)
+			ret = "Classic thread starved by fair thread";
+	}
+	
+	atomic_set(&finish, 0);
+	while (atomic_get(&threads_finished) < total) {
+		TPRINTF("Threads left: %" PRIua "\n",
+		    total - atomic_get(&threads_finished));
+		thread_sleep(1);
+	}
+	
+	return ret;
+}
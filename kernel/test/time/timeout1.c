@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2026 Einherjar developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <test.h>
+#include <print.h>
+#include <atomic.h>
+#include <debug.h>
+#include <typedefs.h>
+#include <arch.h>
+#include <arch/asm.h>
+#include <cpu.h>
+#include <proc/thread.h>
+#include <time/timeout.h>
+#include <time/clock.h>
+#include <time/wheel.h>
+
+#define TIMEOUTS  512
+
+/** Longest delay of a timeout which is let to expire (usec). */
+#define SHORT_DELAY  3000000
+
+/** Scale of the random delay of a timeout which is unregistered. */
+#define LONG_DELAY_SCALE  200
+
+/** Number of ticks of a timeout beyond the span of the timeout wheel. */
+#define OVERFLOW_TICKS  (WHEEL_SPAN(WHEEL_LEVELS) + 1)
+
+typedef struct {
+	timeout_t timeout;
+	cpu_t *cpu;
+	uint64_t deadline;
+	bool cancelled;
+	atomic_t fired;
+	atomic_t late;
+} item_t;
+
+static item_t items[TIMEOUTS];
+static atomic_t fired;
+
+static timeout_t overflow;
+static atomic_t overflow_fired;
+
+static uint32_t seed;
+
+static uint32_t random(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 8);
+}
+
+static void handler(void *arg)
+{
+	item_t *item = (item_t *) arg;
+	
+	/* The wheel has already advanced past the tick being processed. */
+	if ((CPU != item->cpu) || (CPU->timeout_wheel.now - 1 != item->deadline))
+		atomic_inc(&item->late);
+	
+	atomic_inc(&item->fired);
+	atomic_inc(&fired);
+}
+
+static void overflow_handler(void *arg)
+{
+	atomic_inc(&overflow_fired);
+}
+
+const char *test_timeout1(void)
+{
+	size_t i;
+	size_t expected = 0;
+	
+	seed = 42;
+	atomic_set(&fired, 0);
+	atomic_set(&overflow_fired, 0);
+	
+	/*
+	 * Register all timeouts on the same CPU, so that the expiration
+	 * ticks can be compared. Every fourth timeout goes to the higher
+	 * levels of the timeout wheel.
+	 */
+	ipl_t ipl = interrupts_disable();
+	
+	for (i = 0; i < TIMEOUTS; i++) {
+		item_t *item = &items[i];
+		uint64_t delay;
+		
+		if ((i % 4) == 3)
+			delay = SHORT_DELAY +
+			    (uint64_t) random() * LONG_DELAY_SCALE;
+		else
+			delay = random() % SHORT_DELAY;
+		
+		timeout_initialize(&item->timeout);
+		item->cpu = CPU;
+		item->deadline = CPU->timeout_wheel.now + us2ticks(delay);
+		item->cancelled = false;
+		atomic_set(&item->fired, 0);
+		atomic_set(&item->late, 0);
+		
+		timeout_register(&item->timeout, delay, handler, item);
+	}
+	
+	/* A timeout beyond the span of the wheel must not be shortened. */
+	uint64_t overflow_deadline = CPU->timeout_wheel.now + OVERFLOW_TICKS;
+	timeout_initialize(&overflow);
+	timeout_register(&overflow, OVERFLOW_TICKS * (1000000 / HZ),
+	    overflow_handler, NULL);
+	
+	interrupts_restore(ipl);
+	
+	if (overflow.deadline != overflow_deadline) {
+		timeout_unregister(&overflow);
+		return "Timeout beyond the wheel span was shortened";
+	}
+	
+	TPRINTF("Registered %u timeouts\n", TIMEOUTS);
+	
+	/* Unregister all long timeouts and every third short timeout. */
+	for (i = 0; i < TIMEOUTS; i++) {
+		item_t *item = &items[i];
+		
+		if (((i % 4) == 3) || ((i % 3) == 0)) {
+			if (timeout_unregister(&item->timeout))
+				item->cancelled = true;
+		}
+		
+		if (!item->cancelled)
+			expected++;
+	}
+	
+	TPRINTF("Waiting for %zu timeouts to expire\n", expected);
+	
+	size_t wait;
+	for (wait = 0; wait < 2 * SHORT_DELAY / 100000; wait++) {
+		if (atomic_get(&fired) >= expected)
+			break;
+		
+		thread_usleep(100000);
+	}
+	
+	/* Give the cancelled timeouts a chance to show up. */
+	thread_usleep(100000);
+	
+	bool overflow_pending = timeout_unregister(&overflow);
+	
+	for (i = 0; i < TIMEOUTS; i++) {
+		item_t *item = &items[i];
+		
+		if (item->cancelled) {
+			if (atomic_get(&item->fired) != 0)
+				return "Unregistered timeout expired";
+			
+			continue;
+		}
+		
+		if (atomic_get(&item->fired) != 1)
+			return "Timeout did not expire exactly once";
+		
+		if (atomic_get(&item->late) != 0)
+			return "Timeout expired in a wrong tick";
+		
+		if (timeout_unregister(&item->timeout))
+			return "Expired timeout could be unregistered";
+	}
+	
+	if (atomic_get(&fired) != expected)
+		return "Wrong number of timeouts expired";
+	
+	if (atomic_get(&overflow_fired) != 0)
+		return "Timeout beyond the wheel span expired early";
+	
+	if (!overflow_pending)
+		return "Timeout beyond the wheel span was lost";
+	
+	return NULL;
+}